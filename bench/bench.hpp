@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Minimal benchmark harness, every benchmark registers itself with
+/// FUR_BENCH and is run by the furrent_bench executable
+namespace fur::bench {
+
+/// A registered benchmark
+struct Benchmark {
+  /// Name used to select the benchmark from the command line
+  std::string name;
+  /// Body of the benchmark, reports its results with `report`
+  void (*fn)();
+};
+
+/// @return all registered benchmarks
+std::vector<Benchmark>& registry();
+
+/// Registers a benchmark during static initialization
+struct Registration {
+  Registration(const char* name, void (*fn)());
+};
+
+/// Print the throughput of a measured operation
+/// @param label what has been measured
+/// @param bytes number of bytes processed
+/// @param seconds time spent processing them
+void report(const std::string& label, int64_t bytes, double seconds);
+
+/// Print the rate of a measured operation
+/// @param label what has been measured
+/// @param count number of operations completed
+/// @param seconds time spent completing them
+void report_rate(const std::string& label, int64_t count, double seconds);
+
+/// Print the memory kept by a measured operation
+/// @param label what has been measured
+/// @param bytes number of bytes still allocated once the operation is done
+/// @param seconds time spent by the operation
+void report_memory(const std::string& label, int64_t bytes, double seconds);
+
+/// @return number of bytes currently allocated on the heap, 0 if the C
+/// library cannot tell
+int64_t heap_in_use();
+
+}  // namespace fur::bench
+
+/// Define and register a new benchmark
+#define FUR_BENCH(name)                                                  \
+  static void name();                                                    \
+  static const fur::bench::Registration name##_registration(#name, name); \
+  static void name()
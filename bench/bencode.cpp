@@ -0,0 +1,127 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "bencode/bencode_parser.hpp"
+#include "bencode/bencode_value.hpp"
+#include "hash.hpp"
+#include "platform/io.hpp"
+
+using namespace fur;
+
+/// Number of pieces of the synthetic torrent, as many as a 100 GB torrent
+/// with pieces of 1 MB
+const int64_t SYNTH_PIECES = 100000;
+/// Number of peers of the synthetic tracker response
+const int64_t SYNTH_PEERS = 50000;
+/// Number of times every file is loaded and parsed
+const int64_t PARSE_REPETITIONS = 20;
+
+/// A bencoded string
+static std::string bencode_string(const std::string& str) {
+  return std::to_string(str.size()) + ':' + str;
+}
+
+/// A multi-file torrent with a very long `pieces` string
+static std::string synthetic_torrent() {
+  std::string files;
+  for (int64_t i = 0; i < 100; i++) {
+    files += "d6:lengthi" + std::to_string(SYNTH_PIECES * 10486) +
+             "e4:pathl" + bencode_string("file" + std::to_string(i)) + "ee";
+  }
+  std::string pieces(SYNTH_PIECES * 20, '\x42');
+  return "d8:announce" + bencode_string("http://tracker.example/announce") +
+         "4:infod5:filesl" + files + "e4:name" + bencode_string("synthetic") +
+         "12:piece lengthi1048576e6:pieces" + bencode_string(pieces) + "ee";
+}
+
+/// A tracker response with compact peers
+static std::string synthetic_tracker_response() {
+  std::string peers(SYNTH_PEERS * 6, '\x07');
+  return "d8:intervali900e5:peers" + bencode_string(peers) + "e";
+}
+
+/// Measures loading and parsing a file, first reading it as text and then
+/// mapping it
+static void run(const std::string& label, const std::string& filepath) {
+  const auto size = static_cast<int64_t>(std::filesystem::file_size(filepath));
+  bencode::BencodeParser parser;
+
+  auto clock_beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < PARSE_REPETITIONS; i++) {
+    auto text = platform::io::load_file_text(filepath);
+    if (!text.valid() || !parser.decode(*text).valid()) return;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - clock_beg;
+  bench::report(label + ", read", size * PARSE_REPETITIONS, elapsed.count());
+
+  clock_beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < PARSE_REPETITIONS; i++) {
+    auto mapped = platform::io::MappedFile::open(filepath);
+    if (!mapped.valid() || !parser.decode(mapped->view()).valid()) return;
+  }
+  elapsed = std::chrono::steady_clock::now() - clock_beg;
+  bench::report(label + ", mapped", size * PARSE_REPETITIONS, elapsed.count());
+}
+
+/// Measures computing the info hash of a torrent, encoding the parsed info
+/// dictionary again and hashing its span in the data instead
+static void run_info_hash(const std::string& label, const std::string& data) {
+  bencode::BencodeParser parser;
+  auto tree = parser.decode(data);
+  if (!tree.valid()) return;
+  auto& root = dynamic_cast<bencode::BencodeDict&>(**tree);
+  const auto& info = *root.value().at("info");
+  const auto info_span = parser.span("info");
+  if (!info_span) return;
+  const auto size = static_cast<int64_t>(info_span->size());
+
+  std::string buffer;
+  auto clock_beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < PARSE_REPETITIONS; i++) {
+    buffer.clear();
+    bencode::BencodeParser::encode(info, buffer);
+    hash::compute_info_hash(buffer);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - clock_beg;
+  bench::report(label + ", info hash encoded", size * PARSE_REPETITIONS,
+                elapsed.count());
+
+  clock_beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < PARSE_REPETITIONS; i++)
+    hash::compute_info_hash(*info_span);
+  elapsed = std::chrono::steady_clock::now() - clock_beg;
+  bench::report(label + ", info hash in place", size * PARSE_REPETITIONS,
+                elapsed.count());
+}
+
+FUR_BENCH(bencode_parse) {
+  auto folder = std::filesystem::temp_directory_path() / "furrent_bencode";
+  std::filesystem::create_directories(folder);
+
+  struct Input {
+    std::string label;
+    std::string filepath;
+  };
+  std::vector<Input> inputs = {
+      {"synthetic torrent", (folder / "synthetic.torrent").string()},
+      {"tracker response", (folder / "tracker.bencode").string()},
+  };
+  std::ofstream(inputs[0].filepath, std::ios::binary) << synthetic_torrent();
+  std::ofstream(inputs[1].filepath, std::ios::binary)
+      << synthetic_tracker_response();
+
+  // Real torrent, only when run from the build folder
+  const std::string ubuntu =
+      "../extra/ubuntu-22.04.1-desktop-amd64.iso.torrent";
+  if (std::filesystem::exists(ubuntu)) inputs.push_back({"ubuntu", ubuntu});
+
+  for (const auto& input : inputs) run(input.label, input.filepath);
+  run_info_hash("synthetic torrent", synthetic_torrent());
+  std::filesystem::remove_all(folder);
+}
@@ -0,0 +1,84 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "mt/executor.hpp"
+#include "mt/sharing_queue.hpp"
+#include "policy/policy.hpp"
+
+using namespace fur;
+
+/// Number of jobs executed by every run
+const int64_t CONTENTION_JOBS = 200000;
+/// Iterations of the busy loop making up a job, a few hundred nanoseconds
+const int64_t CONTENTION_JOB_WORK = 200;
+
+/// Small amount of CPU-bound work, the result is kept in `sink`
+static void job_work(int64_t seed, std::atomic_int64_t& sink) {
+  int64_t value = seed;
+  for (int64_t i = 0; i < CONTENTION_JOB_WORK; i++)
+    value = value * 6364136223846793005 + 1442695040888963407;
+  sink.fetch_add(value & 1, std::memory_order_relaxed);
+}
+
+/// Jobs are pulled by every thread from a single `mt::SharedQueue`, as the
+/// workers of Furrent do with the pieces
+static double run_shared_queue(int64_t threads_cnt) {
+  mt::SharedQueue<int64_t> queue;
+  std::atomic_int64_t done{0};
+  std::atomic_int64_t sink{0};
+  std::atomic_bool alive{true};
+
+  std::vector<std::thread> threads;
+  for (int64_t i = 0; i < threads_cnt; i++) {
+    threads.emplace_back([&] {
+      policy::FIFOPolicy<int64_t> fifo;
+      while (alive.load(std::memory_order_relaxed)) {
+        auto job = queue.try_extract(fifo);
+        if (!job.valid()) {
+          queue.wait_work();
+          continue;
+        }
+        job_work(*job, sink);
+        done.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  const auto beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < CONTENTION_JOBS; i++) queue.insert(int64_t(i));
+  while (done.load(std::memory_order_relaxed) < CONTENTION_JOBS)
+    std::this_thread::yield();
+  const auto end = std::chrono::steady_clock::now();
+
+  alive = false;
+  queue.begin_skip_waiting();
+  for (auto& thread : threads) thread.join();
+  return std::chrono::duration<double>(end - beg).count();
+}
+
+/// Jobs are spread over the deques of a `mt::Executor`
+static double run_executor(int64_t threads_cnt) {
+  std::atomic_int64_t sink{0};
+  mt::Executor executor(threads_cnt);
+
+  const auto beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < CONTENTION_JOBS; i++)
+    executor.submit([i, &sink] { job_work(i, sink); });
+  executor.wait_idle();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - beg).count();
+}
+
+FUR_BENCH(executor_contention) {
+  for (int64_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+    const std::string suffix = " (" + std::to_string(threads) + " threads)";
+    bench::report_rate("shared queue" + suffix, CONTENTION_JOBS,
+                       run_shared_queue(threads));
+    bench::report_rate("executor" + suffix, CONTENTION_JOBS,
+                       run_executor(threads));
+  }
+}
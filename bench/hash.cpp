@@ -0,0 +1,63 @@
+#include <chrono>
+#include <vector>
+
+#include "bench.hpp"
+#include "sha1.hpp"
+#include "smallsha1/sha1.hpp"
+
+using namespace fur;
+
+/// Size of the buffer hashed by every measurement
+const int64_t HASH_BYTES = 64 * 1024 * 1024;
+/// Number of times the buffer is hashed
+const int64_t HASH_REPETITIONS = 4;
+
+FUR_BENCH(sha1_kernels) {
+  std::vector<uint8_t> bytes(HASH_BYTES);
+  for (int64_t i = 0; i < HASH_BYTES; i++) bytes[i] = i * 13;
+
+  // The library we used before as a baseline
+  auto clock_beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < HASH_REPETITIONS; i++) {
+    unsigned char hash[20];
+    sha1::calc(bytes.data(), static_cast<int>(bytes.size()), hash);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - clock_beg;
+  bench::report("smallsha1", HASH_BYTES * HASH_REPETITIONS, elapsed.count());
+
+  for (auto kernel : hash::supported_kernels()) {
+    clock_beg = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < HASH_REPETITIONS; i++)
+      hash::Sha1::digest(bytes.data(), HASH_BYTES, kernel);
+    elapsed = std::chrono::steady_clock::now() - clock_beg;
+    bench::report(hash::kernel_name(kernel), HASH_BYTES * HASH_REPETITIONS,
+                  elapsed.count());
+  }
+}
+
+/// Size of every piece hashed by the batch benchmark
+const int64_t BATCH_PIECE_BYTES = 256 * 1024;
+
+FUR_BENCH(sha1_batch) {
+  std::vector<uint8_t> bytes(HASH_BYTES);
+  for (int64_t i = 0; i < HASH_BYTES; i++) bytes[i] = i * 13;
+
+  std::vector<hash::Message> messages;
+  for (int64_t offset = 0; offset < HASH_BYTES; offset += BATCH_PIECE_BYTES)
+    messages.push_back({bytes.data() + offset, BATCH_PIECE_BYTES});
+  std::vector<hash::hash_t> hashes(messages.size());
+
+  for (auto kernel : hash::supported_batch_kernels()) {
+    auto clock_beg = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < HASH_REPETITIONS; i++) {
+      hash::digest_batch(messages.data(),
+                         static_cast<int64_t>(messages.size()), hashes.data(),
+                         kernel);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - clock_beg;
+    bench::report(hash::batch_kernel_name(kernel),
+                  HASH_BYTES * HASH_REPETITIONS, elapsed.count());
+  }
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "bencode/bencode_cursor.hpp"
+#include "furrent.hpp"
+#include "policy/queue.hpp"
+#include "torrent.hpp"
+
+using namespace fur;
+
+/// Length of every piece of the synthetic torrents
+const int64_t SYNTH_PIECE_LENGTH = 256 * 1024;
+/// Number of files of the synthetic torrents, spread over a few folders
+const int64_t SYNTH_FILES = 1000;
+
+/// A bencoded string
+static std::string bencode_string(const std::string& str) {
+  return std::to_string(str.size()) + ':' + str;
+}
+
+/// A multi-file torrent with `pieces` pieces and files of the same length
+static std::string synthetic_torrent(int64_t pieces) {
+  const int64_t file_length = pieces * SYNTH_PIECE_LENGTH / SYNTH_FILES;
+  std::string files;
+  for (int64_t i = 0; i < SYNTH_FILES; i++) {
+    files += "d6:lengthi" + std::to_string(file_length) + "e4:pathl" +
+             bencode_string("folder" + std::to_string(i % 10)) +
+             bencode_string("file" + std::to_string(i)) + "ee";
+  }
+  const int64_t hashes = (file_length * SYNTH_FILES + SYNTH_PIECE_LENGTH - 1) /
+                         SYNTH_PIECE_LENGTH;
+  std::string piece_hashes(hashes * 20, '\x42');
+  return "d8:announce" + bencode_string("http://tracker.example/announce") +
+         "4:infod5:filesl" + files + "e4:name" + bencode_string("synthetic") +
+         "12:piece lengthi" + std::to_string(SYNTH_PIECE_LENGTH) +
+         "e6:pieces" + bencode_string(piece_hashes) + "ee";
+}
+
+/// Measures what adding a torrent keeps in memory for its pieces, once with
+/// every piece generated up front and once with the layout of its files and
+/// a task for every piece
+static void run(int64_t pieces) {
+  const std::string data = synthetic_torrent(pieces);
+  const std::string label = std::to_string(pieces / 1000) + "k pieces";
+
+  int64_t heap_beg = bench::heap_in_use();
+  auto clock_beg = std::chrono::steady_clock::now();
+  {
+    TorrentFile descriptor{bencode::BencodeCursor(data)};
+    const auto all_pieces = descriptor.pieces();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - clock_beg;
+    bench::report_memory(label + ", all pieces",
+                         bench::heap_in_use() - heap_beg, elapsed.count());
+  }
+
+  heap_beg = bench::heap_in_use();
+  clock_beg = std::chrono::steady_clock::now();
+  {
+    const auto descriptor = std::make_shared<const TorrentFile>(
+        bencode::BencodeCursor(data));
+    const FileLayout layout(*descriptor);
+    // A task for every piece, as queued by add_torrent
+    policy::Queue<PieceTask> tasks;
+    for (int64_t index = 0; index < descriptor->pieces_count; index++)
+      tasks.emplace(0, index, descriptor);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - clock_beg;
+    bench::report_memory(label + ", file layout and tasks",
+                         bench::heap_in_use() - heap_beg, elapsed.count());
+  }
+}
+
+FUR_BENCH(add_torrent) {
+  for (int64_t pieces : {100000, 500000}) run(pieces);
+}
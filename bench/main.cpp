@@ -0,0 +1,61 @@
+#include <cstdio>
+#include <string>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "bench.hpp"
+
+namespace fur::bench {
+
+std::vector<Benchmark>& registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+Registration::Registration(const char* name, void (*fn)()) {
+  registry().push_back({name, fn});
+}
+
+void report(const std::string& label, int64_t bytes, double seconds) {
+  const double gbs =
+      seconds > 0.0 ? static_cast<double>(bytes) / 1e9 / seconds : 0.0;
+  std::printf("  %-40s %10.2f MB %8.3f s %8.2f GB/s\n", label.c_str(),
+              static_cast<double>(bytes) / 1e6, seconds, gbs);
+}
+
+void report_rate(const std::string& label, int64_t count, double seconds) {
+  const double rate =
+      seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+  std::printf("  %-40s %10lld ops %8.3f s %12.0f ops/s\n", label.c_str(),
+              static_cast<long long>(count), seconds, rate);
+}
+
+void report_memory(const std::string& label, int64_t bytes, double seconds) {
+  std::printf("  %-40s %10.2f MB %8.3f s     heap\n", label.c_str(),
+              static_cast<double>(bytes) / 1e6, seconds);
+}
+
+int64_t heap_in_use() {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  const auto info = mallinfo2();
+  return static_cast<int64_t>(info.uordblks + info.hblkhd);
+#else
+  return 0;
+#endif
+}
+
+}  // namespace fur::bench
+
+/// Runs all benchmarks whose name contains the first argument, or all of them
+/// if no argument is given
+int main(int argc, char* argv[]) {
+  const std::string filter = argc > 1 ? argv[1] : "";
+  for (const auto& benchmark : fur::bench::registry()) {
+    if (benchmark.name.find(filter) == std::string::npos) continue;
+    std::printf("%s\n", benchmark.name.c_str());
+    benchmark.fn();
+  }
+  return 0;
+}
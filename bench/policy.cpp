@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "policy/heap_queue.hpp"
+#include "policy/policy.hpp"
+#include "policy/queue.hpp"
+
+using namespace fur;
+
+/// Extractions measured for every size, every extracted item goes back in
+const int64_t POLICY_EXTRACTIONS = 200;
+
+/// A task ranked by a random priority
+struct RankedTask {
+  int64_t index;
+  int64_t rank;
+};
+
+/// Ranks tasks as `piece_rank` does for prioritized torrents
+struct TaskRank {
+  int64_t operator()(const RankedTask& task) const { return task.rank; }
+};
+
+/// @return time spent by the extractions and reinsertions
+template <typename Extract>
+static double time_extractions(Extract extract) {
+  const auto beg = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < POLICY_EXTRACTIONS; i++) extract();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - beg).count();
+}
+
+FUR_BENCH(policy_extraction) {
+  for (int64_t size : {1000, 10000, 100000, 1000000}) {
+    const std::string suffix = " (" + std::to_string(size) + " tasks)";
+    std::mt19937 gen(42);
+    // Priorities leave the best rank unused, so the scan never stops early
+    std::uniform_int_distribution<int64_t> ranks(1, 4);
+
+    policy::Queue<RankedTask> list;
+    policy::HeapQueue<RankedTask, TaskRank> heap;
+    for (int64_t index = 0; index < size; index++) {
+      const int64_t rank = ranks(gen);
+      list.insert({index, rank});
+      heap.insert({index, rank});
+    }
+
+    policy::RankPolicy<RankedTask> rank_policy(
+        [](const RankedTask& task) { return task.rank; });
+    const double list_seconds = time_extractions([&] {
+      auto task = list.extract(rank_policy);
+      list.insert(std::move(*task));
+    });
+    bench::report_rate("rank policy scan" + suffix, POLICY_EXTRACTIONS,
+                       list_seconds);
+
+    const double heap_seconds = time_extractions([&] {
+      auto task = heap.extract();
+      heap.insert(std::move(*task));
+    });
+    bench::report_rate("heap queue" + suffix, POLICY_EXTRACTIONS,
+                       heap_seconds);
+  }
+}
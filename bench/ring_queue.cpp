@@ -0,0 +1,71 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "mt/ring_queue.hpp"
+#include "mt/sharing_queue.hpp"
+#include "policy/policy.hpp"
+
+using namespace fur;
+
+/// Number of items moved through the queue by every run
+const int64_t RING_ITEMS = 1000000;
+/// Capacity of the ring, as much as the hashing queue
+const int64_t RING_CAPACITY = 64;
+
+/// Moves `RING_ITEMS` from `pairs` producers to `pairs` consumers
+/// @param push inserts an item, returns false if it must be retried
+/// @param pop extracts an item, returns false if there was none
+template <typename Push, typename Pop>
+static double run_pairs(int64_t pairs, Push push, Pop pop) {
+  const int64_t per_producer = RING_ITEMS / pairs;
+  std::atomic_int64_t remaining{per_producer * pairs};
+
+  const auto beg = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int64_t p = 0; p < pairs; p++) {
+    threads.emplace_back([&] {
+      for (int64_t i = 0; i < per_producer; i++) {
+        while (!push(i)) std::this_thread::yield();
+      }
+    });
+    threads.emplace_back([&] {
+      while (remaining.load(std::memory_order_relaxed) > 0) {
+        if (pop())
+          remaining.fetch_sub(1, std::memory_order_relaxed);
+        else
+          std::this_thread::yield();
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - beg).count();
+}
+
+FUR_BENCH(ring_queue_contention) {
+  for (int64_t pairs : {1, 2, 4, 8, 16}) {
+    const std::string suffix =
+        " (" + std::to_string(pairs) + "+" + std::to_string(pairs) + ")";
+
+    mt::SharedQueue<int64_t> shared;
+    policy::FIFOPolicy<int64_t> fifo;
+    const double shared_seconds = run_pairs(
+        pairs,
+        [&](int64_t item) {
+          shared.insert(std::move(item));
+          return true;
+        },
+        [&] { return shared.try_extract(fifo).valid(); });
+    bench::report_rate("shared queue" + suffix, RING_ITEMS, shared_seconds);
+
+    mt::RingQueue<int64_t> ring(RING_CAPACITY);
+    const double ring_seconds = run_pairs(
+        pairs, [&](int64_t item) { return ring.try_push(std::move(item)); },
+        [&] { return ring.try_pop().has_value(); });
+    bench::report_rate("ring queue" + suffix, RING_ITEMS, ring_seconds);
+  }
+}
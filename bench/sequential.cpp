@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.hpp"
+#include "furrent.hpp"
+#include "policy/heap_queue.hpp"
+
+using namespace fur;
+
+// Downloads are simulated with an event queue instead of real peers, times
+// are simulated seconds
+
+/// Size of the simulated torrent
+const int64_t SIM_TORRENT_BYTES = 1024 * 1024 * 1024;
+/// Size of each piece of the simulated torrent
+const int64_t SIM_PIECE_BYTES = 1024 * 1024;
+/// Number of workers downloading at the same time
+const int64_t SIM_WORKERS = 16;
+/// Average time needed to download a piece
+const double SIM_PIECE_SECONDS = 0.25;
+/// Probability of a download failing, the piece goes back into the queue
+const double SIM_FAILURE_RATE = 0.1;
+
+/// Simulates a download and measures how long it takes before the consumer
+/// can read the first `bytes` from `cursor`
+/// @param sequential rank the pieces with the window of a sequential torrent,
+/// as the workers do, instead of by priority and index only
+/// @param cursor offset in bytes the consumer starts reading from
+static double time_to_first_bytes(bool sequential, int64_t cursor,
+                                  int64_t bytes) {
+  TorrentFile descriptor;
+  descriptor.piece_length = SIM_PIECE_BYTES;
+  descriptor.length = SIM_TORRENT_BYTES;
+  descriptor.pieces_count = SIM_TORRENT_BYTES / SIM_PIECE_BYTES;
+  descriptor.files = {File{{"content"}, SIM_TORRENT_BYTES}};
+
+  const auto shared_descriptor =
+      std::make_shared<const TorrentFile>(descriptor);
+  policy::HeapQueue<PieceTask, PieceFlow::Rank> tasks;
+  for (int64_t index = 0; index < descriptor.pieces_count; index++)
+    tasks.emplace(0, index, shared_descriptor);
+
+  std::vector<bool> completed(descriptor.pieces_count, false);
+  const int64_t cursor_piece = cursor / SIM_PIECE_BYTES;
+  const int64_t target_piece =
+      std::min(cursor_piece + bytes / SIM_PIECE_BYTES, descriptor.pieces_count);
+  int64_t readable = cursor_piece;
+
+  // The window moves as the workers do it, ranking the pieces again
+  auto update_window = [&] {
+    if (!sequential) return;
+    tasks.rank().window = sequential_window(descriptor, readable);
+    tasks.rerank();
+  };
+  update_window();
+
+  std::mt19937 gen(42);
+  std::exponential_distribution<double> duration(1.0 / SIM_PIECE_SECONDS);
+  std::bernoulli_distribution failure(SIM_FAILURE_RATE);
+
+  // Downloads in progress, the one ending first on top
+  using Download = std::pair<double, PieceTask>;
+  auto later = [](const Download& a, const Download& b) {
+    return a.first > b.first;
+  };
+  std::priority_queue<Download, std::vector<Download>, decltype(later)>
+      downloads(later);
+
+  auto start_download = [&](double now) {
+    auto extraction = tasks.extract();
+    if (extraction.valid())
+      downloads.emplace(now + duration(gen), std::move(*extraction));
+  };
+  for (int64_t i = 0; i < SIM_WORKERS; i++) start_download(0.0);
+
+  while (!downloads.empty()) {
+    const double now = downloads.top().first;
+    PieceTask task = downloads.top().second;
+    downloads.pop();
+
+    if (failure(gen)) {
+      tasks.insert(std::move(task));
+    } else {
+      completed[task.index] = true;
+      while (readable < descriptor.pieces_count && completed[readable])
+        readable += 1;
+      if (readable >= target_piece) return now;
+      update_window();
+    }
+    start_download(now);
+  }
+  return 0.0;
+}
+
+FUR_BENCH(sequential_download) {
+  struct Scenario {
+    std::string label;
+    int64_t cursor;
+    int64_t bytes;
+  };
+  const std::vector<Scenario> scenarios = {
+      {"first 16 MB", 0, 16 * 1024 * 1024},
+      {"first 128 MB", 0, 128 * 1024 * 1024},
+      {"16 MB at 50%", SIM_TORRENT_BYTES / 2, 16 * 1024 * 1024},
+  };
+
+  for (const auto& scenario : scenarios) {
+    for (bool sequential : {false, true}) {
+      const double seconds =
+          time_to_first_bytes(sequential, scenario.cursor, scenario.bytes);
+      bench::report((sequential ? "sequential, " : "default, ") +
+                        scenario.label + " (sim)",
+                    scenario.bytes, seconds);
+    }
+  }
+}
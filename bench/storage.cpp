@@ -0,0 +1,87 @@
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "bench.hpp"
+#include "mt/parallel.hpp"
+#include "recheck.hpp"
+#include "smallsha1/sha1.hpp"
+#include "storage/file.hpp"
+#include "storage/memory.hpp"
+
+using namespace fur;
+
+/// Size of the synthetic torrent
+const int64_t TORRENT_BYTES = 256 * 1024 * 1024;
+/// Size of each piece of the synthetic torrent
+const int64_t PIECE_BYTES = 1024 * 1024;
+/// Number of files of the synthetic torrent
+const int64_t FILES_COUNT = 4;
+
+/// Content of a piece of the synthetic torrent
+static std::vector<uint8_t> piece_content(int64_t index) {
+  std::vector<uint8_t> content(PIECE_BYTES);
+  for (int64_t i = 0; i < PIECE_BYTES; i++) content[i] = (index * 31 + i) % 251;
+  return content;
+}
+
+static TorrentFile make_torrent(const std::string& folder_name) {
+  TorrentFile descriptor;
+  descriptor.piece_length = PIECE_BYTES;
+  descriptor.length = TORRENT_BYTES;
+  descriptor.pieces_count = TORRENT_BYTES / PIECE_BYTES;
+  descriptor.name = "bench";
+  descriptor.folder_name = folder_name;
+  for (int64_t i = 0; i < FILES_COUNT; i++)
+    descriptor.files.push_back(
+        File{{"file" + std::to_string(i)}, TORRENT_BYTES / FILES_COUNT});
+
+  descriptor.piece_hashes.resize(descriptor.pieces_count);
+  for (int64_t index = 0; index < descriptor.pieces_count; index++) {
+    auto content = piece_content(index);
+    sha1::calc(content.data(), static_cast<int>(content.size()),
+               descriptor.piece_hashes[index].data());
+  }
+  return descriptor;
+}
+
+/// Measures writing every piece and then rechecking the whole torrent
+static void run(const std::string& label, storage::StorageBackend& storage,
+                TorrentFile descriptor) {
+  if (!storage.prepare(descriptor, false).valid()) return;
+
+  // Content is generated upfront so that only the storage is measured
+  const auto pieces = descriptor.pieces();
+  std::vector<std::vector<uint8_t>> contents;
+  for (const auto& piece : pieces) contents.push_back(piece_content(piece.index));
+
+  auto clock_beg = std::chrono::steady_clock::now();
+  mt::parallel_for(static_cast<int64_t>(pieces.size()), [&](int64_t index) {
+    (void)storage.write_piece(descriptor, pieces[index], contents[index].data(),
+                              PIECE_BYTES);
+  });
+  (void)storage.flush(descriptor);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - clock_beg;
+  bench::report(label + " write", TORRENT_BYTES, elapsed.count());
+
+  auto report = recheck::recheck(descriptor, storage);
+  bench::report(label + " recheck", report.bytes_read, report.seconds);
+}
+
+FUR_BENCH(storage_backends) {
+  auto folder = std::filesystem::temp_directory_path() / "furrent_bench";
+  std::filesystem::remove_all(folder);
+  auto descriptor = make_torrent(folder.string());
+
+  storage::FileBackend file;
+  run("file", file, descriptor);
+  std::filesystem::remove_all(folder);
+
+  storage::MemoryBackend memory;
+  run("memory", memory, descriptor);
+
+  storage::DiscardBackend discard;
+  run("discard", discard, descriptor);
+}
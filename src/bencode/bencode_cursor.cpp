@@ -0,0 +1,221 @@
+#include "bencode_cursor.hpp"
+
+#include <charconv>
+#include <cstdint>
+
+namespace fur::bencode {
+
+namespace {
+
+/// A scalar value and the number of bytes of its encoding
+template <typename T>
+struct Scalar {
+  T value;
+  size_t length;
+};
+
+/// @return True if the token starts a string
+bool is_digit(char token) { return token >= '0' && token <= '9'; }
+
+/// Decodes the integer at the beginning of `data`
+CursorResult<Scalar<int64_t>> decode_int(std::string_view data) {
+  using Result = CursorResult<Scalar<int64_t>>;
+
+  if (data.empty() || data[0] != 'i')
+    return Result::ERROR(BencodeParserError::IntFormat);
+  auto end = data.find('e');
+  if (end == std::string_view::npos)
+    return Result::ERROR(BencodeParserError::IntFormat);
+
+  auto digits = data.substr(1, end - 1);
+  int64_t value = 0;
+  auto [ptr, error] =
+      std::from_chars(digits.data(), digits.data() + digits.size(), value);
+  if (digits == "-0" || error != std::errc() ||
+      ptr != digits.data() + digits.size())
+    return Result::ERROR(BencodeParserError::IntValue);
+  return Result::OK({value, end + 1});
+}
+
+/// Decodes the string at the beginning of `data`
+CursorResult<Scalar<std::string_view>> decode_string(std::string_view data) {
+  using Result = CursorResult<Scalar<std::string_view>>;
+
+  if (data.empty() || !is_digit(data[0]))
+    return Result::ERROR(BencodeParserError::StringFormat);
+  auto colon = data.find(':');
+  if (colon == std::string_view::npos)
+    return Result::ERROR(BencodeParserError::StringFormat);
+
+  int64_t length = 0;
+  auto [ptr, error] =
+      std::from_chars(data.data(), data.data() + colon, length);
+  if (error != std::errc() || ptr != data.data() + colon ||
+      length > static_cast<int64_t>(data.size() - colon - 1))
+    return Result::ERROR(BencodeParserError::InvalidString);
+  return Result::OK(
+      {data.substr(colon + 1, length),
+       colon + 1 + static_cast<size_t>(length)});
+}
+
+/// @return number of bytes of the value at the beginning of `data`, nested
+/// values are walked without recursion
+CursorResult<size_t> value_length(std::string_view data) {
+  using Result = CursorResult<size_t>;
+
+  size_t pos = 0;
+  int64_t depth = 0;
+  do {
+    if (pos >= data.size())
+      return Result::ERROR(BencodeParserError::InvalidString);
+
+    auto token = data[pos];
+    if (token == 'l' || token == 'd') {
+      depth += 1;
+      pos += 1;
+    } else if (token == 'e' && depth > 0) {
+      depth -= 1;
+      pos += 1;
+    } else if (token == 'i') {
+      auto integer = decode_int(data.substr(pos));
+      if (!integer.valid())
+        return Result::ERROR(BencodeParserError(integer.error()));
+      pos += integer->length;
+    } else if (is_digit(token)) {
+      auto string = decode_string(data.substr(pos));
+      if (!string.valid())
+        return Result::ERROR(BencodeParserError(string.error()));
+      pos += string->length;
+    } else {
+      return Result::ERROR(BencodeParserError::InvalidString);
+    }
+  } while (depth > 0);
+
+  return Result::OK(std::move(pos));
+}
+
+}  // namespace
+
+BencodeCursor::BencodeCursor(std::string_view data) : _data{data} {}
+
+CursorResult<BencodeType> BencodeCursor::type() const {
+  using Result = CursorResult<BencodeType>;
+
+  if (_data.empty()) return Result::ERROR(BencodeParserError::InvalidString);
+  switch (_data[0]) {
+    case 'i':
+      return Result::OK(BencodeType::Integer);
+    case 'l':
+      return Result::OK(BencodeType::List);
+    case 'd':
+      return Result::OK(BencodeType::Dict);
+    default:
+      if (is_digit(_data[0])) return Result::OK(BencodeType::String);
+      return Result::ERROR(BencodeParserError::InvalidString);
+  }
+}
+
+CursorResult<int64_t> BencodeCursor::as_int() const {
+  using Result = CursorResult<int64_t>;
+
+  if (_data.empty() || _data[0] != 'i')
+    return Result::ERROR(BencodeParserError::WrongType);
+  auto integer = decode_int(_data);
+  if (!integer.valid())
+    return Result::ERROR(BencodeParserError(integer.error()));
+  return Result::OK(std::move(integer->value));
+}
+
+CursorResult<std::string_view> BencodeCursor::as_string() const {
+  using Result = CursorResult<std::string_view>;
+
+  if (_data.empty() || !is_digit(_data[0]))
+    return Result::ERROR(BencodeParserError::WrongType);
+  auto string = decode_string(_data);
+  if (!string.valid())
+    return Result::ERROR(BencodeParserError(string.error()));
+  return Result::OK(std::move(string->value));
+}
+
+CursorResult<BencodeCursor> BencodeCursor::find(std::string_view key) const {
+  using Result = CursorResult<BencodeCursor>;
+
+  if (_data.empty() || _data[0] != 'd')
+    return Result::ERROR(BencodeParserError::WrongType);
+
+  // Keys are compared in place, values before the wanted one are skipped
+  size_t pos = 1;
+  while (pos < _data.size() && _data[pos] != 'e') {
+    if (!is_digit(_data[pos]))
+      return Result::ERROR(BencodeParserError::DictKey);
+    auto current = decode_string(_data.substr(pos));
+    if (!current.valid())
+      return Result::ERROR(BencodeParserError(current.error()));
+    pos += current->length;
+
+    auto value = _data.substr(pos);
+    if (current->value == key) return Result::OK(BencodeCursor(value));
+
+    auto length = value_length(value);
+    if (!length.valid())
+      return Result::ERROR(BencodeParserError(length.error()));
+    pos += *length;
+  }
+
+  if (pos >= _data.size())
+    return Result::ERROR(BencodeParserError::DictFormat);
+  return Result::ERROR(BencodeParserError::MissingKey);
+}
+
+CursorResult<int64_t> BencodeCursor::find_int(std::string_view key) const {
+  auto value = find(key);
+  if (!value.valid())
+    return CursorResult<int64_t>::ERROR(BencodeParserError(value.error()));
+  return value->as_int();
+}
+
+CursorResult<std::string_view> BencodeCursor::find_string(
+    std::string_view key) const {
+  auto value = find(key);
+  if (!value.valid()) {
+    return CursorResult<std::string_view>::ERROR(
+        BencodeParserError(value.error()));
+  }
+  return value->as_string();
+}
+
+bool BencodeCursor::contains(std::string_view key) const {
+  return find(key).valid();
+}
+
+CursorResult<std::vector<BencodeCursor>> BencodeCursor::items() const {
+  using Result = CursorResult<std::vector<BencodeCursor>>;
+
+  if (_data.empty() || _data[0] != 'l')
+    return Result::ERROR(BencodeParserError::WrongType);
+
+  std::vector<BencodeCursor> items;
+  size_t pos = 1;
+  while (pos < _data.size() && _data[pos] != 'e') {
+    auto length = value_length(_data.substr(pos));
+    if (!length.valid())
+      return Result::ERROR(BencodeParserError(length.error()));
+    items.emplace_back(_data.substr(pos, *length));
+    pos += *length;
+  }
+
+  if (pos >= _data.size())
+    return Result::ERROR(BencodeParserError::ListFormat);
+  return Result::OK(std::move(items));
+}
+
+CursorResult<std::string_view> BencodeCursor::raw() const {
+  using Result = CursorResult<std::string_view>;
+
+  auto length = value_length(_data);
+  if (!length.valid())
+    return Result::ERROR(BencodeParserError(length.error()));
+  return Result::OK(_data.substr(0, *length));
+}
+
+}  // namespace fur::bencode
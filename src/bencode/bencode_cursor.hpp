@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "bencode_parser.hpp"
+#include "bencode_value.hpp"
+#include "util/result.hpp"
+
+namespace fur::bencode {
+
+/// Result of reading through a cursor
+template <typename T>
+using CursorResult = util::Result<T, BencodeParserError>;
+
+/// Lazy read-only view of a bencoded value. Nothing is decoded until it is
+/// asked for and nothing is copied: looking up a key only skips over the
+/// values before it, so the cost depends on the fields actually read and not
+/// on the size of the data. Skipped values are not validated. A cursor is
+/// only valid as long as the data it points to.
+class BencodeCursor {
+  /// Encoded value, from its first byte up to the end of the data
+  std::string_view _data;
+
+ public:
+  /// @param data encoded value, trailing bytes after it are ignored
+  explicit BencodeCursor(std::string_view data);
+
+  /// @return type of the value
+  [[nodiscard]] CursorResult<BencodeType> type() const;
+
+  /// @return value of an integer
+  [[nodiscard]] CursorResult<int64_t> as_int() const;
+  /// @return content of a string, pointing inside the data
+  [[nodiscard]] CursorResult<std::string_view> as_string() const;
+
+  /// @return cursor to the value of a key of a dictionary
+  [[nodiscard]] CursorResult<BencodeCursor> find(std::string_view key) const;
+  /// @return value of an integer key of a dictionary
+  [[nodiscard]] CursorResult<int64_t> find_int(std::string_view key) const;
+  /// @return content of a string key of a dictionary, pointing inside the data
+  [[nodiscard]] CursorResult<std::string_view> find_string(
+      std::string_view key) const;
+  /// @return True if the value is a dictionary containing the key
+  [[nodiscard]] bool contains(std::string_view key) const;
+  /// @return cursors to all the elements of a list
+  [[nodiscard]] CursorResult<std::vector<BencodeCursor>> items() const;
+
+  /// @return encoded bytes of the whole value, pointing inside the data
+  [[nodiscard]] CursorResult<std::string_view> raw() const;
+};
+
+}  // namespace fur::bencode
@@ -1,7 +1,7 @@
 #include "bencode_parser.hpp"
 
+#include <charconv>
 #include <limits>
-#include <regex>
 #include <stdexcept>
 
 namespace fur::bencode {
@@ -23,22 +23,40 @@ std::string error_to_string(const BencodeParserError error) {
       return "DictKey";
     case BencodeParserError::DictKeyOrder:
       return "DictKeyOrder";
+    case BencodeParserError::MissingKey:
+      return "MissingKey";
+    case BencodeParserError::WrongType:
+      return "WrongType";
     default:
       return "<invalid parser error>";
   }
 }
 
 std::string BencodeParser::encode(const BencodeValue& value) {
-  return value.to_string();
+  std::string out;
+  encode(value, out);
+  return out;
 }
 
-BencodeResult BencodeParser::decode(const std::string& decoded) {
+void BencodeParser::encode(const BencodeValue& value, std::string& out) {
+  value.encode(out);
+}
+
+std::optional<std::string_view> BencodeParser::span(
+    std::string_view key) const {
+  auto it = _spans.find(key);
+  if (it == _spans.end()) return std::nullopt;
+  return it->second;
+}
+
+BencodeResult BencodeParser::decode(std::string_view decoded) {
   if (decoded.length() > static_cast<size_t>(std::numeric_limits<int64_t>::max())) {
     throw std::invalid_argument("string to decode is too large");
   }
 
   _tokens = decoded;
   _index = 0;  // Reset the index
+  _spans.clear();
 
   auto r = decode();
   if (r.valid() && _index != static_cast<int64_t>(_tokens.length())) {
@@ -50,7 +68,7 @@ BencodeResult BencodeParser::decode(const std::string& decoded) {
 
 // Given a vector of tokens, returns a BencodeValue object
 auto BencodeParser::decode() -> BencodeResult {
-  if (!_tokens.empty()) {
+  if (_index < static_cast<int64_t>(_tokens.size())) {
     auto token = _tokens[_index];
     if (token == 'i') {
       return BencodeParser::decode_int();
@@ -72,65 +90,67 @@ auto BencodeParser::decode_int() -> BencodeResult {
   }
   // Skip the 'i' token already checked before entering this function
   _index++;
-  // Decoding the integer
-  std::string integer{};
-  while (_index < static_cast<int64_t>(_tokens.size()) &&
-         _tokens[_index] != 'e') {
-    integer += _tokens[_index];
-    _index++;
-  }
-  if (_index == static_cast<int64_t>(_tokens.size())) {
-    // No space for the 'e' token
+  // Find the 'e' at the end of the integer
+  auto end = _tokens.find('e', _index);
+  if (end == std::string_view::npos) {
     return BencodeResult::ERROR(BencodeParserError::IntFormat);
-  } else if (_tokens[_index] != 'e') {
-    // Missing 'e' at the end of the integer
-    return BencodeResult::ERROR(BencodeParserError::IntFormat);
-  } else if (integer == "-0") {
+  }
+  auto integer = _tokens.substr(_index, end - _index);
+  if (integer == "-0") {
     // The "-0" is not a valid integer
     return BencodeResult::ERROR(BencodeParserError::IntValue);
-  } else if (!std::regex_match(integer, std::regex("^-?\\d+$"))) {
-    // Check if the integer is a string of digits with sign
+  }
+  // Every character must be part of the number, which must fit in 64 bits
+  int64_t value = 0;
+  auto [ptr, error] =
+      std::from_chars(integer.data(), integer.data() + integer.size(), value);
+  if (error != std::errc() || ptr != integer.data() + integer.size()) {
     return BencodeResult::ERROR(BencodeParserError::IntValue);
   }
   // Skip 'e' at the end
-  _index++;
-  return BencodeResult::OK(std::make_unique<BencodeInt>(std::stol(integer)));
+  _index = static_cast<int64_t>(end) + 1;
+  return BencodeResult::OK(std::make_unique<BencodeInt>(value));
 }
 
 auto BencodeParser::decode_string() -> BencodeResult {
+  auto str = decode_string_view();
+  if (!str.valid()) {
+    return BencodeResult::ERROR(BencodeParserError(str.error()));
+  }
+  // The only copy of the string
+  return BencodeResult::OK(std::make_unique<BencodeString>(std::string(*str)));
+}
+
+auto BencodeParser::decode_string_view()
+    -> util::Result<std::string_view, BencodeParserError> {
+  using Result = util::Result<std::string_view, BencodeParserError>;
+
   // The token must be in the form ['length', ':', 'string']
   if (static_cast<int64_t>(_tokens.size()) - _index < 3) {
-    return BencodeResult::ERROR(BencodeParserError::StringFormat);
+    return Result::ERROR(BencodeParserError::StringFormat);
   }
-  // Calculate the string length until the ':' token
-  std::string len{};
-  while (_index < static_cast<int64_t>(_tokens.size()) &&
-         _tokens[_index] != ':') {
-    len += _tokens[_index];
-    _index++;
+  // The length is a positive integer ending at the ':' token
+  auto colon = _tokens.find(':', _index);
+  if (colon == std::string_view::npos || _tokens[_index] < '0' ||
+      _tokens[_index] > '9') {
+    return Result::ERROR(BencodeParserError::InvalidString);
   }
-  if (!std::regex_match(len, std::regex("^\\d+$"))) {
-    // Check if the length is a positive integer
-    return BencodeResult::ERROR(BencodeParserError::InvalidString);
+  int64_t length_str = 0;
+  auto [ptr, error] = std::from_chars(_tokens.data() + _index,
+                                      _tokens.data() + colon, length_str);
+  if (error != std::errc() || ptr != _tokens.data() + colon) {
+    return Result::ERROR(BencodeParserError::InvalidString);
   }
   // Skip the ':' token
-  _index++;
-  // Calculate the string using the length previously calculated
-  int64_t length_str = std::stol(len);
-
-  std::string str{};
-  for (int64_t i = 0;
-       i < length_str && _index < static_cast<int64_t>(_tokens.size()); i++) {
-    str += _tokens[_index];
-    _index++;
-  }
+  _index = static_cast<int64_t>(colon) + 1;
 
-  if (str.size() > static_cast<size_t>(std::numeric_limits<int64_t>::max()) ||
-      static_cast<int64_t>(str.size()) != length_str) {
+  if (length_str > static_cast<int64_t>(_tokens.size()) - _index) {
     // Exit because the string is not the same length as the given length
-    return BencodeResult::ERROR(BencodeParserError::InvalidString);
+    return Result::ERROR(BencodeParserError::InvalidString);
   }
-  return BencodeResult::OK(std::make_unique<BencodeString>(str));
+  auto str = _tokens.substr(_index, length_str);
+  _index += length_str;
+  return Result::OK(std::move(str));
 }
 
 auto BencodeParser::decode_list() -> BencodeResult {
@@ -155,10 +175,6 @@ auto BencodeParser::decode_list() -> BencodeResult {
   if (_index >= static_cast<int64_t>(_tokens.size())) {
     return BencodeResult::ERROR(BencodeParserError::ListFormat);
   }
-  // Check if the list is closed with 'e'
-  if (_tokens[_index] != 'e') {
-    return BencodeResult::ERROR(BencodeParserError::ListFormat);
-  }
   // Increment index to skip the last 'e'
   _index += 1;
   return BencodeResult::OK(std::make_unique<BencodeList>(std::move(ptr)));
@@ -169,48 +185,53 @@ auto BencodeParser::decode_dict() -> BencodeResult {
   if (static_cast<int64_t>(_tokens.size()) - _index < 2) {
     return BencodeResult::ERROR(BencodeParserError::DictFormat);
   }
+  // Only the values of the outermost dictionary have their span recorded
+  const bool outermost = _index == 0;
   // Increment index to skip the first 'd' already checked before enter the
   // function
   _index += 1;
   auto ptr = std::map<std::string, std::unique_ptr<BencodeValue>>();
-  std::vector<std::string> keys = std::vector<std::string>();
+  // Keys are views of the data, only those inserted in the map are copied
+  std::string_view previous_key;
+  bool sorted = true;
   while (_index < static_cast<int64_t>(_tokens.size()) &&
          _tokens[_index] != 'e') {
-    auto r_key = decode();
-    if (!r_key.valid()) {
-      // An error occurred while decoding a dictionary key
-      return r_key;
-    }
-    auto key = std::move(*r_key);
     // The key must be a string
-    if (key->get_type() != BencodeType::String) {
+    auto token = _tokens[_index];
+    if (token > '9' || token < '0') {
+      auto r_key = decode();
+      if (!r_key.valid()) {
+        // An error occurred while decoding a dictionary key
+        return r_key;
+      }
       return BencodeResult::ERROR(BencodeParserError::DictKey);
     }
-    // Cast the key to a BencodeString
+    auto r_key = decode_string_view();
+    if (!r_key.valid()) {
+      return BencodeResult::ERROR(BencodeParserError(r_key.error()));
+    }
+    const auto value_begin = _index;
     auto r_value = BencodeParser::decode();
     if (!r_value.valid()) {
       // An error occurred while decoding the value of a key
       return r_value;
     }
-    auto key_str = dynamic_cast<BencodeString&>(*key).value();
-    keys.push_back(key_str);
-    ptr.insert({key_str, std::move(*r_value)});
+    if (outermost) {
+      _spans.insert_or_assign(
+          std::string(*r_key),
+          _tokens.substr(value_begin, _index - value_begin));
+    }
+    // Check if the keys are sorted by lexicographical order
+    if (!ptr.empty() && previous_key > *r_key) sorted = false;
+    previous_key = *r_key;
+    ptr.emplace(std::string(*r_key), std::move(*r_value));
   }
   // Push all items but not space for 'e'
   if (_index >= static_cast<int64_t>(_tokens.size())) {
     return BencodeResult::ERROR(BencodeParserError::DictFormat);
   }
-  // Check if the list is closed with 'e'
-  if (_tokens[_index] != 'e') {
-    return BencodeResult::ERROR(BencodeParserError::DictFormat);
-  }
-  // Check if the keys array is sorted by lexicographical order
-  if (!keys.empty()) {
-    for (int64_t i = 0; i < static_cast<int64_t>(keys.size()) - 1; i++) {
-      if (keys[i] > keys[i + 1]) {
-        return BencodeResult::ERROR(BencodeParserError::DictKeyOrder);
-      }
-    }
+  if (!sorted) {
+    return BencodeResult::ERROR(BencodeParserError::DictKeyOrder);
   }
   // increment index to skip the last 'e'
   _index += 1;
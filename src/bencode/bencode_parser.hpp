@@ -1,6 +1,10 @@
 #pragma once
 
+#include <functional>
+#include <map>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "bencode_value.hpp"
@@ -25,7 +29,11 @@ enum class BencodeParserError {
   /// A dictionary key was not a string
   DictKey,
   /// The keys of the dictionary were not in lexicographical order
-  DictKeyOrder
+  DictKeyOrder,
+  /// A dictionary doesn't contain the requested key
+  MissingKey,
+  /// A value is not of the requested type
+  WrongType
 };
 
 /// Function to translate a BencodeParserError into a string
@@ -39,14 +47,19 @@ class BencodeParser {
  private:
   /// The index of the current token used for decoding
   int64_t _index{};
-  /// The list of tokens to be decoded
-  std::string _tokens;
+  /// The bencoded data being decoded, never copied
+  std::string_view _tokens;
+  /// Raw bytes of every value of the outermost dictionary, views of `_tokens`
+  std::map<std::string, std::string_view, std::less<>> _spans;
   /// Private method used recursively to decode the bencode data
   BencodeResult decode();
   /// Private method used to decode a bencode integer
   BencodeResult decode_int();
   /// Private method used to decode a bencode string
   BencodeResult decode_string();
+  /// Private method used to find the content of a bencode string, without
+  /// copying it
+  util::Result<std::string_view, BencodeParserError> decode_string_view();
   /// Private method used to decode a bencode list
   BencodeResult decode_list();
   /// Private method used to decode a bencode dictionary
@@ -57,11 +70,21 @@ class BencodeParser {
   ~BencodeParser() = default;
   /// Parses a bencode string and returns a BencodeValue object, this is public
   /// and it is not called recursively, in fact it initialize the attributes
-  /// _tokens and _index and then calls the private method decode()
-  BencodeResult decode(std::string const& decoded);
+  /// _tokens and _index and then calls the private method decode(). The data
+  /// is only read while decoding, it can be a memory mapped file.
+  BencodeResult decode(std::string_view decoded);
+
+  /// Raw bytes of a value of the outermost dictionary decoded last, exactly as
+  /// they were in the data. They can be hashed without encoding the value
+  /// again, but are only valid as long as the decoded data is.
+  [[nodiscard]] std::optional<std::string_view> span(
+      std::string_view key) const;
 
   /// Encodes a BencodeValue object into a bencode string
   static std::string encode(BencodeValue const& value);
+  /// Encodes a BencodeValue object at the end of `out`, which can be reused
+  /// across calls to avoid allocations
+  static void encode(BencodeValue const& value, std::string& out);
 };
 
 }  // namespace fur::bencode
@@ -0,0 +1,147 @@
+#include "bencode_reader.hpp"
+
+#include <charconv>
+#include <cstdint>
+
+namespace fur::bencode {
+
+/// Longest integer in decimal with its sign
+const size_t MAX_INT_DIGITS = 20;
+
+BencodeReader::BencodeReader(BencodeHandler& handler)
+    : _handler{handler}, _expect_key{false}, _done{false} {}
+
+util::Outcome<BencodeParserError> BencodeReader::feed(std::string_view chunk) {
+  using Outcome = util::Outcome<BencodeParserError>;
+  if (_error.has_value()) return Outcome::ERROR(BencodeParserError(*_error));
+
+  // Chunks are decoded in place unless a value was split
+  if (!_pending.empty()) _pending.append(chunk);
+  std::string_view data = _pending.empty() ? chunk : _pending;
+
+  size_t pos = 0;
+  while (pos < data.size()) {
+    auto consumed = step(data.substr(pos));
+    if (!consumed.valid()) {
+      _error = consumed.error();
+      return Outcome::ERROR(BencodeParserError(consumed.error()));
+    }
+    if (*consumed == 0) break;
+    pos += *consumed;
+  }
+
+  // Keep what is left of a split value
+  if (_pending.empty()) {
+    _pending.assign(data.substr(pos));
+  } else {
+    _pending.erase(0, pos);
+  }
+  return Outcome::OK({});
+}
+
+util::Outcome<BencodeParserError> BencodeReader::finish() {
+  using Outcome = util::Outcome<BencodeParserError>;
+  if (_error.has_value()) return Outcome::ERROR(BencodeParserError(*_error));
+  if (!_done || !_pending.empty())
+    return Outcome::ERROR(BencodeParserError::InvalidString);
+  return Outcome::OK({});
+}
+
+auto BencodeReader::step(std::string_view data)
+    -> util::Result<size_t, BencodeParserError> {
+  using Result = util::Result<size_t, BencodeParserError>;
+
+  // Nothing can follow the outermost value
+  if (_done) return Result::ERROR(BencodeParserError::InvalidString);
+
+  const bool in_dict = !_containers.empty() && _containers.back();
+  auto token = data[0];
+
+  if (token == 'e') {
+    if (_containers.empty())
+      return Result::ERROR(BencodeParserError::InvalidString);
+    // A key without its value
+    if (in_dict && !_expect_key)
+      return Result::ERROR(BencodeParserError::DictFormat);
+    _containers.pop_back();
+    _handler.on_end();
+    value_done();
+    return Result::OK(1);
+  }
+
+  const bool key = in_dict && _expect_key;
+  if (key && (token < '0' || token > '9'))
+    return Result::ERROR(BencodeParserError::DictKey);
+
+  if (token == 'l' || token == 'd') {
+    _containers.push_back(token == 'd');
+    _expect_key = token == 'd';
+    if (token == 'd') {
+      _handler.on_dict_begin();
+    } else {
+      _handler.on_list_begin();
+    }
+    return Result::OK(1);
+  }
+
+  if (token == 'i') {
+    auto end = data.find('e');
+    if (end == std::string_view::npos) {
+      if (data.size() > MAX_INT_DIGITS + 1)
+        return Result::ERROR(BencodeParserError::IntFormat);
+      return Result::OK(0);
+    }
+
+    auto digits = data.substr(1, end - 1);
+    int64_t value = 0;
+    auto [ptr, error] =
+        std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (digits == "-0" || error != std::errc() ||
+        ptr != digits.data() + digits.size())
+      return Result::ERROR(BencodeParserError::IntValue);
+
+    _handler.on_int(value);
+    value_done();
+    return Result::OK(end + 1);
+  }
+
+  if (token >= '0' && token <= '9') {
+    auto colon = data.find(':');
+    if (colon == std::string_view::npos) {
+      if (data.size() > MAX_INT_DIGITS)
+        return Result::ERROR(BencodeParserError::StringFormat);
+      return Result::OK(0);
+    }
+
+    int64_t length = 0;
+    auto [ptr, error] =
+        std::from_chars(data.data(), data.data() + colon, length);
+    if (error != std::errc() || ptr != data.data() + colon)
+      return Result::ERROR(BencodeParserError::InvalidString);
+    // The string continues in the next chunk
+    if (length > static_cast<int64_t>(data.size() - colon - 1))
+      return Result::OK(0);
+
+    auto value = data.substr(colon + 1, length);
+    if (key) {
+      _handler.on_key(value);
+      _expect_key = false;
+    } else {
+      _handler.on_string(value);
+      value_done();
+    }
+    return Result::OK(colon + 1 + static_cast<size_t>(length));
+  }
+
+  return Result::ERROR(BencodeParserError::InvalidString);
+}
+
+void BencodeReader::value_done() {
+  if (_containers.empty()) {
+    _done = true;
+  } else if (_containers.back()) {
+    _expect_key = true;
+  }
+}
+
+}  // namespace fur::bencode
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bencode_parser.hpp"
+#include "util/result.hpp"
+
+namespace fur::bencode {
+
+/// Receives the values found by a `BencodeReader` as they are decoded.
+/// Strings passed to the handler are only valid during the call.
+class BencodeHandler {
+ public:
+  virtual ~BencodeHandler() = default;
+
+  virtual void on_int(int64_t value) = 0;
+  virtual void on_string(std::string_view value) = 0;
+  /// A list starts, its elements follow until `on_end`
+  virtual void on_list_begin() = 0;
+  /// A dictionary starts, its keys and values follow until `on_end`
+  virtual void on_dict_begin() = 0;
+  /// Key of a dictionary, its value follows
+  virtual void on_key(std::string_view key) = 0;
+  /// The innermost list or dictionary ends
+  virtual void on_end() = 0;
+};
+
+/// Event driven bencode decoder for data that arrives in chunks, such as a
+/// large response still being received. Values are reported to a handler as
+/// soon as they are complete and no tree is built: only the bytes of a value
+/// split between two chunks are kept until the rest arrives. The order of the
+/// keys of dictionaries is not checked.
+class BencodeReader {
+  /// Where the values are reported
+  BencodeHandler& _handler;
+  /// Bytes of a value split between chunks, waiting for the next chunk
+  std::string _pending;
+  /// Lists and dictionaries not yet closed, true for dictionaries
+  std::vector<bool> _containers;
+  /// True if the next value of the innermost dictionary is a key
+  bool _expect_key;
+  /// True once the outermost value is complete
+  bool _done;
+  /// First error found, every later chunk is ignored
+  std::optional<BencodeParserError> _error;
+
+ public:
+  explicit BencodeReader(BencodeHandler& handler);
+
+  /// Decode the next chunk of data
+  /// @return an error as soon as the data is found to be invalid
+  util::Outcome<BencodeParserError> feed(std::string_view chunk);
+
+  /// Signal the end of the data
+  /// @return an error if the data ended in the middle of a value
+  util::Outcome<BencodeParserError> finish();
+
+ private:
+  /// Decode the token at the beginning of `data`
+  /// @return bytes of the token or 0 if more data is needed to complete it
+  util::Result<size_t, BencodeParserError> step(std::string_view data);
+  /// Called after every complete value
+  void value_done();
+};
+
+}  // namespace fur::bencode
@@ -1,19 +1,43 @@
 #include "bencode_value.hpp"
 
-#include <regex>
+#include <charconv>
+#include <iterator>
 #include <string>
 #include <utility>
 
 using namespace fur::bencode;
 
+std::string BencodeValue::to_string() const {
+  std::string ret;
+  encode(ret);
+  return ret;
+}
+
+/// Appends the decimal representation of `value` to `out`
+static void encode_integer(std::string& out, int64_t value) {
+  // Enough for the sign and the digits of any 64 bit integer
+  char digits[20];
+  auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+  out.append(digits, result.ptr);
+}
+
+/// Appends `str` as a bencode string to `out`
+static void encode_string(std::string& out, const std::string& str) {
+  encode_integer(out, static_cast<int64_t>(str.size()));
+  out += ':';
+  out += str;
+}
+
 // ================
 // BencodeInt
 // ================
 BencodeInt::BencodeInt(int64_t data) { _val = data; }
 
-std::string BencodeInt::to_string() const {
-  // Return the encoded string of the BencodeInt i + val + e
-  return "i" + std::to_string(_val) + "e";
+void BencodeInt::encode(std::string& out) const {
+  // The encoded string of the BencodeInt is i + val + e
+  out += 'i';
+  encode_integer(out, _val);
+  out += 'e';
 }
 
 BencodeType BencodeInt::get_type() const { return BencodeType::Integer; }
@@ -25,9 +49,9 @@ int64_t BencodeInt::value() const { return _val; }
 // ================
 BencodeString::BencodeString(std::string data) { _val = std::move(data); }
 
-std::string BencodeString::to_string() const {
-  // Return the encoded string of the BencodeString size: + val
-  return std::to_string(_val.size()) + ":" + _val;
+void BencodeString::encode(std::string& out) const {
+  // The encoded string of the BencodeString is size: + val
+  encode_string(out, _val);
 }
 
 BencodeType BencodeString::get_type() const { return BencodeType::String; }
@@ -41,14 +65,13 @@ BencodeList::BencodeList(std::vector<std::unique_ptr<BencodeValue>> data) {
   _val = std::move(data);
 }
 
-std::string BencodeList::to_string() const {
-  // Return the encoded string of the BencodeList l + ... + e
-  std::string ret = "l";
+void BencodeList::encode(std::string& out) const {
+  // The encoded string of the BencodeList is l + ... + e
+  out += 'l';
   for (auto& v : _val) {
-    ret += v->to_string();
+    v->encode(out);
   }
-  ret += "e";
-  return ret;
+  out += 'e';
 }
 
 BencodeType BencodeList::get_type() const { return BencodeType::List; }
@@ -64,17 +87,16 @@ BencodeDict::BencodeDict(
     std::map<std::string, std::unique_ptr<BencodeValue>> data) {
   _val = std::move(data);
 }
-std::string BencodeDict::to_string() const {
-  // Return the encoded string of the BencodeDict d + ... + e
-  std::string ret = "d";
+void BencodeDict::encode(std::string& out) const {
+  // The encoded string of the BencodeDict is d + ... + e
+  out += 'd';
   // Map is already sorted by key, so we can just iterate over it
   for (auto const& [key, val] : _val) {
     // Format of element is size:key + value
-    ret += std::to_string(key.size()) + ":" + key;
-    ret += val->to_string();
+    encode_string(out, key);
+    val->encode(out);
   }
-  ret += "e";
-  return ret;
+  out += 'e';
 }
 
 BencodeType BencodeDict::get_type() const { return BencodeType::Dict; }
@@ -14,7 +14,10 @@ enum class BencodeType { Integer, String, List, Dict };
 class BencodeValue {
  public:
   /// Returns the string representation of the bencode value
-  [[nodiscard]] virtual std::string to_string() const = 0;
+  [[nodiscard]] virtual std::string to_string() const;
+  /// Appends the string representation of the bencode value to `out`, nested
+  /// values are written in the same buffer without temporary strings
+  virtual void encode(std::string& out) const = 0;
   /// Returns the type of the bencode value as a BencodeType enum
   [[nodiscard]] virtual BencodeType get_type() const = 0;
   virtual ~BencodeValue() = default;
@@ -27,7 +30,7 @@ class BencodeInt : public BencodeValue {
 
  public:
   explicit BencodeInt(int64_t data);
-  [[nodiscard]] std::string to_string() const override;
+  void encode(std::string& out) const override;
   [[nodiscard]] BencodeType get_type() const override;
   /// Returns the integer value of the bencode value
   [[nodiscard]] int64_t value() const;
@@ -40,7 +43,7 @@ class BencodeString : public BencodeValue {
 
  public:
   explicit BencodeString(std::string data);
-  [[nodiscard]] std::string to_string() const override;
+  void encode(std::string& out) const override;
   [[nodiscard]] BencodeType get_type() const override;
   /// Returns the string value of the bencode value
   [[nodiscard]] std::string& value();
@@ -53,7 +56,7 @@ class BencodeList : public BencodeValue {
 
  public:
   explicit BencodeList(std::vector<std::unique_ptr<BencodeValue>> data);
-  [[nodiscard]] std::string to_string() const override;
+  void encode(std::string& out) const override;
   [[nodiscard]] BencodeType get_type() const override;
   /// Returns the list of BencodeValue objects that are contained in the list
   [[nodiscard]] std::vector<std::unique_ptr<BencodeValue>>& value();
@@ -68,7 +71,7 @@ class BencodeDict : public BencodeValue {
   /// Constructs a BencodeDict object from a map of strings and BencodeValue
   explicit BencodeDict(
       std::map<std::string, std::unique_ptr<BencodeValue>> data);
-  [[nodiscard]] std::string to_string() const override;
+  void encode(std::string& out) const override;
   [[nodiscard]] BencodeType get_type() const override;
   /// Returns the dictionary of BencodeValue objects that are contained in the
   /// dict
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <platform/io.hpp>
 #include <string>
 
 namespace fur::config {
@@ -7,4 +9,51 @@ namespace fur::config {
 /// Where newly downloaded files are to be stored
 static std::string DOWNLOAD_FOLDER = "output";
 
+/// Where resume files are stored, relative to the download folder
+static std::string RESUME_FOLDER = ".furrent";
+
+/// Completed pieces recorded together in the resume file of a torrent, pieces
+/// completed since the last write are downloaded again after a crash
+const int64_t RESUME_BATCH_PIECES = 32;
+
+/// Pieces completed this long after the last write of the resume file are
+/// recorded right away
+const int64_t RESUME_BATCH_MS = 2000;
+
+/// Where the session snapshot is stored, relative to the download folder
+static std::string SESSION_FILE = ".furrent/session";
+
+/// How the files of a newly added torrent are reserved on disk
+const platform::io::Preallocation PREALLOCATION =
+    platform::io::Preallocation::Sparse;
+
+/// Maximum number of bytes of unused piece buffers kept for reuse
+const int64_t PIECE_BUFFERS_BYTES = 256 * 1024 * 1024;
+
+/// Back large piece buffers with huge pages
+const bool PIECE_BUFFERS_HUGE_PAGES = true;
+
+/// Maximum number of downloaded pieces waiting to be verified, workers wait
+/// for the hashing threads past this limit
+const int64_t HASH_QUEUE_CAPACITY = 32;
+
+/// Number of threads verifying downloaded pieces, 0 means one per core
+const int64_t HASH_THREADS = 0;
+
+/// Number of threads saving verified pieces to storage, pieces of different
+/// torrents or files are written at the same time
+const int64_t SAVING_THREADS = 2;
+
+/// How far ahead of the read cursor of a sequential torrent pieces are
+/// downloaded first
+const int64_t SEQUENTIAL_WINDOW_BYTES = 32 * 1024 * 1024;
+
+/// Maximum number of torrents added at the same time by
+/// `Furrent::add_torrents`, most of the time is spent waiting for trackers
+const int64_t ADMISSION_THREADS = 16;
+
+/// Shortest wait before a torrent is announced again when none of its peers
+/// could provide some of its pieces, trackers can ask for a longer one
+const int64_t STALLED_ANNOUNCE_SECONDS = 60;
+
 }  // namespace fur::config
@@ -49,6 +49,14 @@ bool Bitfield::get(int64_t index) const {
   return storage[_byte_index] & (INDEX_ZERO >> byte_offset(index));
 }
 
+int64_t Bitfield::count() const {
+  int64_t result = 0;
+  for (uint8_t byte : storage) {
+    for (; byte != 0; byte &= byte - 1) result += 1;
+  }
+  return result;
+}
+
 std::ostream& operator<<(std::ostream& os, const Bitfield& bf) {
   const char BIT_0 = '.';
   const char BIT_1 = '#';
@@ -43,6 +43,9 @@ class Bitfield {
   /// Get the value of the bit at the provided index.
   [[nodiscard]] bool get(int64_t index) const;
 
+  /// Count the number of bits set to 1.
+  [[nodiscard]] int64_t count() const;
+
   /// Get the bitfield as an array of bytes.
   [[nodiscard]] std::vector<uint8_t> get_bytes() const {
     // Basically just return a copy of `storage`.
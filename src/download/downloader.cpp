@@ -6,6 +6,7 @@
 
 #include "download/util.hpp"
 #include "hash.hpp"
+#include "sha1.hpp"
 #include "log/logger.hpp"
 
 using fur::download::message::MessageKind;
@@ -23,8 +24,9 @@ DownloaderError from_socket_error(const socket::SocketError& err) {
   }
 }
 
-Downloader::Downloader(const TorrentFile& torrent, const Peer& peer)
-    : torrent{torrent}, peer{peer} {}
+Downloader::Downloader(const TorrentFile& torrent, const Peer& peer,
+                       PieceBufferPool* pool, Verification verification)
+    : torrent{torrent}, peer{peer}, pool{pool}, verification{verification} {}
 
 Outcome<DownloaderError> Downloader::ensure_connected() {
   using Outcome = Outcome<DownloaderError>;
@@ -176,9 +178,9 @@ Outcome<DownloaderError> Downloader::handshake() {
   return Outcome::OK({});
 }
 
-Result<Downloaded, DownloaderError> Downloader::try_download(
+Result<int64_t, DownloaderError> Downloader::start_download(
     const Piece& task) {
-  using Result = Result<Downloaded, DownloaderError>;
+  using Result = Result<int64_t, DownloaderError>;
 
   if (torrent.pieces_count <= 0) {
     throw std::invalid_argument("expected torrent to have at least a piece");
@@ -186,8 +188,6 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
     throw std::invalid_argument("piece index outside valid range");
   }
 
-  auto logger = spdlog::get("custom");
-
   auto maybe_connected = ensure_connected();
   if (!maybe_connected.valid())
     return Result::ERROR(DownloaderError(maybe_connected.error()));
@@ -196,9 +196,6 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
   if (!bitfield->get(task.index))
     return Result::ERROR(DownloaderError::MissingPiece);
 
-  // The resulting piece
-  std::vector<uint8_t> piece;
-
   auto piece_length = torrent.piece_length;
   // Might have to download less bytes if this is the last piece
   if (task.index == torrent.pieces_count - 1) {
@@ -211,8 +208,15 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
     throw std::invalid_argument("expected piece to have at least a byte");
   }
 
-  // Always safe to cast a positive int64_t to size_t
-  piece.resize(piece_length);
+  return Result::OK(std::move(piece_length));
+}
+
+Outcome<DownloaderError> Downloader::receive_blocks(const Piece& task,
+                                                    int64_t piece_length,
+                                                    const BlockFn& on_block) {
+  using Outcome = Outcome<DownloaderError>;
+
+  auto logger = spdlog::get("custom");
 
   // How many bytes to demand in a `RequestMessage`. Should be 16KB.
   constexpr int64_t BLOCK_SIZE = 16384;
@@ -246,9 +250,7 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
         auto maybe_sent =
             send_message(RequestMessage(task.index, offset, length),
                          std::chrono::seconds(5));
-        if (!maybe_sent.valid()) {
-          return Result::ERROR(DownloaderError(maybe_sent.error()));
-        }
+        if (!maybe_sent.valid()) return maybe_sent;
 
         blocks_requested++;
         logger->debug("Requested {} bytes at offset {} of piece {} from {}",
@@ -258,7 +260,7 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
 
     auto maybe_message = recv_message(timeout);
     if (!maybe_message.valid())
-      return Result::ERROR(DownloaderError(maybe_message.error()));
+      return Outcome::ERROR(DownloaderError(maybe_message.error()));
     auto message = std::unique_ptr<Message>(maybe_message->release());
 
     switch (message->kind()) {
@@ -285,8 +287,16 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
       case MessageKind::Piece: {
         // There it is
         auto& piece_message = dynamic_cast<PieceMessage&>(*message);
-        std::copy(piece_message.block.begin(), piece_message.block.end(),
-                  piece.begin() + piece_message.begin);
+        if (piece_message.begin < 0 ||
+            piece_message.begin + static_cast<int64_t>(
+                                      piece_message.block.size()) >
+                piece_length) {
+          destroy_socket();
+          return Outcome::ERROR(DownloaderError::InvalidMessage);
+        }
+        auto stored = on_block(piece_message.begin, piece_message.block);
+        if (!stored.valid()) return stored;
+
         blocks_received++;
         logger->debug("{} sent us {} bytes at offset {} of piece {}",
                       peer.address(), piece_message.block.size(),
@@ -297,7 +307,43 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
     }
   }
 
-  if (!hash::verify_piece(piece, torrent.piece_hashes[task.index])) {
+  return Outcome::OK({});
+}
+
+Result<Downloaded, DownloaderError> Downloader::try_download(
+    const Piece& task) {
+  using Result = Result<Downloaded, DownloaderError>;
+
+  auto logger = spdlog::get("custom");
+
+  auto piece_length = start_download(task);
+  if (!piece_length.valid())
+    return Result::ERROR(DownloaderError(piece_length.error()));
+
+  // The resulting piece, a recycled buffer is not cleared because every byte
+  // is going to be overwritten
+  PieceBuffer piece = pool != nullptr ? pool->acquire(*piece_length)
+                                      : PieceBuffer(*piece_length);
+  // Blocks are hashed as they arrive, verification is almost free once the
+  // last one is received
+  std::optional<hash::StreamingHasher> hasher;
+  if (verification == Verification::Inline)
+    hasher.emplace(piece.data(), piece.size());
+
+  auto received = receive_blocks(
+      task, *piece_length,
+      [&](int64_t begin, const std::vector<uint8_t>& block) {
+        std::copy(block.begin(), block.end(), piece.data() + begin);
+        if (hasher.has_value())
+          hasher->received(begin, static_cast<int64_t>(block.size()));
+        return Outcome<DownloaderError>::OK({});
+      });
+  if (!received.valid())
+    return Result::ERROR(DownloaderError(received.error()));
+
+  if (hasher.has_value() &&
+      (!hasher->complete() ||
+       hasher->finish() != torrent.piece_hashes[task.index])) {
     logger->debug("{} sent corrupt piece {}", peer.address(), task.index);
     return Result::ERROR(DownloaderError::CorruptPiece);
   }
@@ -308,6 +354,40 @@ Result<Downloaded, DownloaderError> Downloader::try_download(
   return Result::OK({task.index, std::move(piece)});
 }
 
+Outcome<DownloaderError> Downloader::try_stream(const Piece& task,
+                                                const BlockSink& sink) {
+  using Outcome = Outcome<DownloaderError>;
+
+  auto logger = spdlog::get("custom");
+
+  auto piece_length = start_download(task);
+  if (!piece_length.valid())
+    return Outcome::ERROR(DownloaderError(piece_length.error()));
+
+  hash::BlockHasher hasher(*piece_length);
+  auto received = receive_blocks(
+      task, *piece_length,
+      [&](int64_t begin, const std::vector<uint8_t>& block) {
+        const auto len = static_cast<int64_t>(block.size());
+        if (!sink(begin, block.data(), len))
+          return Outcome::ERROR(DownloaderError::CannotStore);
+        hasher.received(begin, block.data(), len);
+        return Outcome::OK({});
+      });
+  if (!received.valid()) return received;
+
+  if (!hasher.complete() ||
+      hasher.finish() != torrent.piece_hashes[task.index]) {
+    logger->debug("{} sent corrupt piece {}", peer.address(), task.index);
+    return Outcome::ERROR(DownloaderError::CorruptPiece);
+  }
+
+  logger->debug("Piece {} completely streamed from {}", task.index,
+                peer.address());
+
+  return Outcome::OK({});
+}
+
 Outcome<DownloaderError> Downloader::send_message(const Message& msg,
                                                   timeout timeout) {
   auto outcome = socket->write(msg.encode(), timeout);
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 
 #include "download/bitfield.hpp"
 #include "download/message.hpp"
+#include "download/piece_buffer.hpp"
 #include "download/socket.hpp"
 #include "peer.hpp"
 #include "tfriend_fw.hpp"
@@ -22,7 +24,7 @@ namespace fur::download {
 /// A downloaded piece for a torrent file.
 struct Downloaded {
   int64_t index;
-  std::vector<uint8_t> content;
+  PieceBuffer content;
 };
 
 }  // namespace fur::download
@@ -44,17 +46,39 @@ enum class DownloaderError {
   SocketTimeout,
   /// The socket experienced some other, generic, error
   SocketOther,
+  /// A block could not be stored while streaming the piece
+  CannotStore,
 };
 
 DownloaderError from_socket_error(const socket::SocketError& err);
 
+/// When the content of a downloaded piece is checked against its hash
+enum class Verification {
+  /// While the blocks arrive, corrupt pieces are reported by `try_download`
+  Inline,
+  /// Never by the `Downloader`, the caller must verify the piece itself
+  Deferred,
+};
+
+/// Receives the blocks of a streamed piece as soon as they arrive
+/// @param offset offset of the block from the beginning of the piece
+/// @param bytes content of the block, only valid during the call
+/// @param len length of the block
+/// @return false if the block could not be stored
+using BlockSink =
+    std::function<bool(int64_t offset, const uint8_t* bytes, int64_t len)>;
+
 /// Handles downloading of torrent pieces. Must be initialized with a
 /// `TorrentFile` and a `Peer` discovered from that same torrent. This type is
 /// intrinsically not copyable because it embeds an ASIO socket.
 class Downloader {
  public:
   /// Construct a new `Downloader`. No TCP socket is established at this time.
-  explicit Downloader(const TorrentFile& torrent, const Peer& peer);
+  /// Pieces are downloaded into buffers taken from `pool` when present,
+  /// otherwise a new buffer is allocated for every piece.
+  explicit Downloader(const TorrentFile& torrent, const Peer& peer,
+                      PieceBufferPool* pool = nullptr,
+                      Verification verification = Verification::Inline);
 
   /// Attempt downloading a piece using this `Downloader`. The function tries
   /// it best not to throw any exception (unless something truly exceptional
@@ -62,12 +86,25 @@ class Downloader {
   /// `std::nullopt` being returned. Errors such as:
   ///  - This peer not having the requested piece available
   ///  - The connection timing out
-  ///  - The downloaded piece being corrupt
+  ///  - The downloaded piece being corrupt, unless verification is deferred
   [[nodiscard]] Result<Downloaded, DownloaderError> try_download(const Piece&);
 
+  /// Attempt downloading a piece without keeping it in memory. Every block is
+  /// handed to `sink` as soon as it arrives and hashed incrementally, only
+  /// blocks arriving out of order are copied until the gap before them is
+  /// filled. Errors are the same of `try_download`, the piece is always
+  /// verified and the blocks already stored are left as they are when it
+  /// turns out to be corrupt.
+  [[nodiscard]] Outcome<DownloaderError> try_stream(const Piece&,
+                                                    const BlockSink& sink);
+
  private:
   const TorrentFile& torrent;
   const Peer& peer;
+  /// Where piece buffers come from, may be missing
+  PieceBufferPool* pool;
+  /// Whether pieces are verified by `try_download`
+  Verification verification;
 
   /// Socket that this `Downloader` has established with a `Peer`. This is
   /// lazily initialized when needed and kept in good health thanks to
@@ -94,6 +131,18 @@ class Downloader {
   /// Performs the BitTorrent handshake.
   Outcome<DownloaderError> handshake();
 
+  /// Called with every block received from the peer
+  using BlockFn = std::function<Outcome<DownloaderError>(
+      int64_t begin, const std::vector<uint8_t>& block)>;
+
+  /// Connects to the peer and checks that it has the piece
+  /// @return length of the piece
+  Result<int64_t, DownloaderError> start_download(const Piece&);
+  /// Requests every block of a piece, keeping a few requests in flight, and
+  /// hands them to `on_block` in the order they arrive
+  Outcome<DownloaderError> receive_blocks(const Piece&, int64_t piece_length,
+                                          const BlockFn& on_block);
+
   Outcome<DownloaderError> send_message(const Message& msg, timeout timeout);
   Result<std::unique_ptr<Message>, DownloaderError> recv_message(
       timeout timeout);
@@ -0,0 +1,187 @@
+#include "download/hash_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sha1.hpp"
+
+namespace fur::download {
+
+/// Maximum number of pieces a worker hashes at once, as many as the widest
+/// batch kernel has lanes
+const int64_t HASH_BATCH = 16;
+
+HashPool::HashPool(int64_t capacity, int64_t threads)
+    : _capacity{capacity},
+      _jobs{std::max<int64_t>(capacity, 1)},
+      _queued{0},
+      _running{0},
+      _stopping{false},
+      _sleeping{0},
+      _blocked{0},
+      _max_queue_depth{0},
+      _verified{0},
+      _corrupt{0},
+      _total_latency{0.0},
+      _max_latency{0.0},
+      _total_hash_time{0.0} {
+  if (capacity <= 0) throw std::invalid_argument("capacity must be positive");
+  _workers.launch([this](mt::Runner runner, util::Empty&,
+                         size_t) { thread_main(runner); },
+                  threads);
+}
+
+HashPool::~HashPool() { shutdown(); }
+
+void HashPool::submit(Downloaded piece, const hash::hash_t& expected,
+                      Callback done) {
+  // Reserve room in the queue, waiting while it's full
+  int64_t queued = _queued.load();
+  while (true) {
+    if (_stopping.load()) return;
+    if (queued < _capacity) {
+      if (_queued.compare_exchange_weak(queued, queued + 1)) break;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    // Announced before checking for room, see `thread_main`
+    _blocked.fetch_add(1);
+    _job_done.wait(
+        lock, [&] { return _stopping.load() || _queued.load() < _capacity; });
+    _blocked.fetch_sub(1);
+    queued = _queued.load();
+  }
+
+  int64_t max_depth = _max_queue_depth.load(std::memory_order_relaxed);
+  while (max_depth < queued + 1 &&
+         !_max_queue_depth.compare_exchange_weak(max_depth, queued + 1,
+                                                 std::memory_order_relaxed)) {
+  }
+
+  // There is always room in the ring, but a worker may still be moving the
+  // previous job out of the slot
+  Job job{std::move(piece), expected, std::move(done), Clock::now()};
+  while (!_jobs.try_push(std::move(job))) std::this_thread::yield();
+
+  // A sleeping worker either is seen here or sees the new job
+  if (_sleeping.load() > 0) {
+    { std::scoped_lock<std::mutex> lock(_mutex); }
+    _job_available.notify_one();
+  }
+}
+
+void HashPool::wait_idle() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _blocked.fetch_add(1);
+  _job_done.wait(lock, [&] {
+    return _stopping.load() || (_queued.load() == 0 && _running.load() == 0);
+  });
+  _blocked.fetch_sub(1);
+}
+
+void HashPool::shutdown() {
+  {
+    std::scoped_lock<std::mutex> lock(_mutex);
+    if (_stopping.exchange(true)) return;
+  }
+  _job_available.notify_all();
+  _job_done.notify_all();
+  _workers.terminate();
+
+  // Buffers go back to their pool, callbacks are never called
+  while (_jobs.try_pop().has_value()) _queued.fetch_sub(1);
+}
+
+HashPoolStats HashPool::stats() const {
+  std::scoped_lock<std::mutex> lock(_mutex);
+  const double verified = std::max<double>(1.0, _verified);
+  return {_queued.load(),
+          _max_queue_depth.load(),
+          _verified,
+          _corrupt,
+          _total_latency / verified,
+          _max_latency,
+          _total_hash_time / verified};
+}
+
+void HashPool::wake_blocked() {
+  if (_blocked.load() == 0) return;
+  { std::scoped_lock<std::mutex> lock(_mutex); }
+  _job_done.notify_all();
+}
+
+void HashPool::thread_main(mt::Runner runner) {
+  std::vector<Job> batch;
+  std::vector<hash::Message> messages;
+  std::vector<hash::hash_t> hashes;
+
+  while (runner.alive()) {
+    if (_stopping.load()) return;
+    while (static_cast<int64_t>(batch.size()) < HASH_BATCH) {
+      auto job = _jobs.try_pop();
+      if (!job.has_value()) break;
+      batch.push_back(std::move(*job));
+    }
+
+    if (batch.empty()) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      // Announced before checking for jobs, so that a submission either sees
+      // this worker sleeping or is seen by it
+      _sleeping.fetch_add(1);
+      _job_available.wait(
+          lock, [&] { return _stopping.load() || _queued.load() > 0; });
+      _sleeping.fetch_sub(1);
+      continue;
+    }
+
+    // Never both zero while a job is in flight, see `wait_idle`
+    const int64_t count = static_cast<int64_t>(batch.size());
+    _running.fetch_add(count);
+    _queued.fetch_sub(count);
+    // Room in the queue for more submissions
+    wake_blocked();
+
+    messages.clear();
+    for (const auto& job : batch)
+      messages.push_back({job.piece.content.data(), job.piece.content.size()});
+    hashes.resize(batch.size());
+
+    const auto hash_beg = Clock::now();
+    hash::digest_batch(messages.data(), static_cast<int64_t>(messages.size()),
+                       hashes.data());
+    const auto hash_end = Clock::now();
+
+    int64_t corrupt = 0;
+    double total_latency = 0.0;
+    double max_latency = 0.0;
+    for (size_t i = 0; i < batch.size(); i++) {
+      Job& job = batch[i];
+      const std::chrono::duration<double> latency = hash_end - job.submitted;
+      total_latency += latency.count();
+      max_latency = std::max(max_latency, latency.count());
+
+      const bool valid = hashes[i] == job.expected;
+      if (!valid) corrupt += 1;
+      job.done(std::move(job.piece), valid);
+    }
+
+    const std::chrono::duration<double> hash_time = hash_end - hash_beg;
+    batch.clear();
+    {
+      std::scoped_lock<std::mutex> lock(_mutex);
+      _running.fetch_sub(count);
+      _verified += count;
+      _corrupt += corrupt;
+      _total_latency += total_latency;
+      _max_latency = std::max(_max_latency, max_latency);
+      _total_hash_time += hash_time.count();
+    }
+    wake_blocked();
+  }
+}
+
+}  // namespace fur::download
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "download/downloader.hpp"
+#include "hash.hpp"
+#include "mt/group.hpp"
+#include "mt/ring_queue.hpp"
+
+namespace fur::download {
+
+/// Statistics of a `HashPool`, times are in seconds
+struct HashPoolStats {
+  /// Pieces waiting to be hashed right now
+  int64_t queue_depth;
+  /// Highest number of pieces ever waiting at the same time
+  int64_t max_queue_depth;
+  /// Pieces verified so far, valid or not
+  int64_t verified;
+  /// Pieces that didn't match their hash
+  int64_t corrupt;
+  /// Average time from submission to the end of the verification
+  double mean_latency;
+  /// Longest time from submission to the end of the verification
+  double max_latency;
+  /// Average time spent hashing a single piece
+  double mean_hash_time;
+};
+
+/// Pool of threads dedicated to verifying downloaded pieces, so that the
+/// workers holding peer connections never wait for the CPU-bound hashing.
+/// Pieces are queued up to a fixed capacity, after which submitters wait.
+/// Every worker takes as many pieces as are waiting, up to a limit, and hashes
+/// them together with `hash::digest_batch`.
+/// Pieces go through a lock-free ring, the mutex is only taken to sleep, to
+/// wake up sleeping threads and once per batch to update the statistics.
+class HashPool {
+ public:
+  /// Invoked on a pool thread once a piece has been verified, it must be
+  /// short: the thread hashes nothing else in the meantime and the latency in
+  /// the statistics leaves it out. Saving the piece belongs elsewhere.
+  using Callback = std::function<void(Downloaded piece, bool valid)>;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /// A piece waiting to be verified
+  struct Job {
+    Downloaded piece;
+    hash::hash_t expected;
+    Callback done;
+    Clock::time_point submitted;
+  };
+
+  /// Maximum number of jobs waiting in the queue
+  int64_t _capacity;
+
+  /// Jobs waiting to be picked by a worker
+  mt::RingQueue<Job> _jobs;
+  /// Jobs submitted and not yet picked by a worker, room is reserved here
+  /// before a job is pushed to the ring
+  std::atomic_int64_t _queued;
+  /// Jobs taken by a worker and not yet completed
+  std::atomic_int64_t _running;
+  /// True once the pool is shutting down
+  std::atomic_bool _stopping;
+  /// Workers sleeping until a job is available
+  std::atomic_int64_t _sleeping;
+  /// Threads sleeping until there is room in the queue or the pool is idle
+  std::atomic_int64_t _blocked;
+  std::atomic_int64_t _max_queue_depth;
+
+  /// Used to sleep and protects the statistics below
+  mutable std::mutex _mutex;
+  /// Signals new jobs to the workers
+  std::condition_variable _job_available;
+  /// Signals free space in the queue and completed jobs
+  std::condition_variable _job_done;
+
+  int64_t _verified;
+  int64_t _corrupt;
+  double _total_latency;
+  double _max_latency;
+  double _total_hash_time;
+
+  /// Threads hashing the pieces, must be the last member so that they are
+  /// stopped before the rest of the state is destroyed
+  mt::ThreadGroup<util::Empty> _workers;
+
+ public:
+  /// @param capacity maximum number of pieces waiting to be verified
+  /// @param threads number of hashing threads, 0 means one per core
+  explicit HashPool(int64_t capacity, int64_t threads = 0);
+  /// Stops the pool, see `shutdown`
+  ~HashPool();
+
+  HashPool(const HashPool&) = delete;
+  HashPool& operator=(const HashPool&) = delete;
+
+  /// Queue a piece for verification, waits while the queue is full. After the
+  /// pool has been shut down the piece is dropped without calling `done`.
+  /// @param expected hash the content of the piece must have
+  /// @param done called with the piece and the outcome of the verification
+  void submit(Downloaded piece, const hash::hash_t& expected, Callback done);
+
+  /// Wait until every submitted piece has been verified
+  void wait_idle();
+
+  /// Stop all threads, pieces still in the queue are dropped. Submitters
+  /// waiting for space return immediately.
+  void shutdown();
+
+  /// @return a snapshot of the statistics of the pool
+  [[nodiscard]] HashPoolStats stats() const;
+
+ private:
+  /// Main function of the hashing threads
+  void thread_main(mt::Runner runner);
+  /// Wake up the threads waiting for room in the queue or for the pool to be
+  /// idle, if any
+  void wake_blocked();
+};
+
+}  // namespace fur::download
@@ -0,0 +1,174 @@
+#include "download/piece_buffer.hpp"
+
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "platform/memory.hpp"
+
+namespace fur::download {
+
+using namespace fur::platform;
+
+/// Unused memory kept by a pool
+struct FreeBuffer {
+  uint8_t* data;
+  int64_t capacity;
+  bool huge_pages;
+};
+
+struct PieceBuffer::Shared {
+  /// Protects all following fields
+  std::mutex mtx;
+  /// Unused buffers
+  std::vector<FreeBuffer> free;
+  /// Bytes of all unused buffers
+  int64_t retained_bytes = 0;
+  /// Number of fresh allocations
+  int64_t allocations = 0;
+
+  const int64_t max_bytes;
+  const bool huge_pages;
+
+  Shared(int64_t max_bytes, bool huge_pages)
+      : max_bytes{max_bytes}, huge_pages{huge_pages} {}
+
+  ~Shared() {
+    for (const auto& buffer : free)
+      memory::free_pages(buffer.data, buffer.capacity, buffer.huge_pages);
+  }
+};
+
+/// Reserve fresh memory from the OS
+static uint8_t* allocate(int64_t capacity, bool huge_pages) {
+  if (capacity == 0) return nullptr;
+  uint8_t* data = memory::allocate_pages(capacity, huge_pages);
+  if (data == nullptr) throw std::bad_alloc();
+  return data;
+}
+
+PieceBuffer::PieceBuffer()
+    : _pool{nullptr},
+      _data{nullptr},
+      _size{0},
+      _capacity{0},
+      _huge_pages{false} {}
+
+PieceBuffer::PieceBuffer(int64_t size)
+    : _pool{nullptr},
+      _data{allocate(size, false)},
+      _size{size},
+      _capacity{memory::round_to_pages(size, false)},
+      _huge_pages{false} {}
+
+PieceBuffer::PieceBuffer(std::shared_ptr<Shared> pool, uint8_t* data,
+                         int64_t size, int64_t capacity, bool huge_pages)
+    : _pool{std::move(pool)},
+      _data{data},
+      _size{size},
+      _capacity{capacity},
+      _huge_pages{huge_pages} {}
+
+PieceBuffer::~PieceBuffer() { release(); }
+
+PieceBuffer::PieceBuffer(PieceBuffer&& other) noexcept
+    : _pool{std::move(other._pool)},
+      _data{other._data},
+      _size{other._size},
+      _capacity{other._capacity},
+      _huge_pages{other._huge_pages} {
+  other._data = nullptr;
+  other._size = 0;
+  other._capacity = 0;
+}
+
+PieceBuffer& PieceBuffer::operator=(PieceBuffer&& other) noexcept {
+  if (this != &other) {
+    release();
+    _pool = std::move(other._pool);
+    _data = other._data;
+    _size = other._size;
+    _capacity = other._capacity;
+    _huge_pages = other._huge_pages;
+    other._data = nullptr;
+    other._size = 0;
+    other._capacity = 0;
+  }
+  return *this;
+}
+
+uint8_t* PieceBuffer::data() { return _data; }
+const uint8_t* PieceBuffer::data() const { return _data; }
+int64_t PieceBuffer::size() const { return _size; }
+
+void PieceBuffer::release() {
+  if (_data == nullptr) return;
+
+  bool recycled = false;
+  if (_pool) {
+    std::scoped_lock<std::mutex> lock(_pool->mtx);
+    if (_pool->retained_bytes + _capacity <= _pool->max_bytes) {
+      _pool->free.push_back({_data, _capacity, _huge_pages});
+      _pool->retained_bytes += _capacity;
+      recycled = true;
+    }
+  }
+
+  if (!recycled) memory::free_pages(_data, _capacity, _huge_pages);
+  _pool.reset();
+  _data = nullptr;
+  _size = 0;
+  _capacity = 0;
+}
+
+// ======================================================================================
+
+PieceBufferPool::PieceBufferPool(int64_t max_bytes, bool huge_pages)
+    : _shared{std::make_shared<PieceBuffer::Shared>(max_bytes, huge_pages)} {}
+
+PieceBuffer PieceBufferPool::acquire(int64_t size) {
+  if (size < 0) throw std::invalid_argument("negative buffer size");
+
+  {
+    std::scoped_lock<std::mutex> lock(_shared->mtx);
+
+    // Smallest unused buffer that fits, pieces of the same torrent all have
+    // the same size so the first match is usually exact
+    auto& free = _shared->free;
+    auto best = free.end();
+    for (auto it = free.begin(); it != free.end(); ++it) {
+      if (it->capacity >= size &&
+          (best == free.end() || it->capacity < best->capacity))
+        best = it;
+    }
+
+    if (best != free.end()) {
+      FreeBuffer buffer = *best;
+      *best = free.back();
+      free.pop_back();
+      _shared->retained_bytes -= buffer.capacity;
+      return PieceBuffer(_shared, buffer.data, size, buffer.capacity,
+                         buffer.huge_pages);
+    }
+    _shared->allocations += 1;
+  }
+
+  // Huge pages would waste most of the memory of small buffers
+  const bool huge_pages =
+      _shared->huge_pages && size >= memory::HUGE_PAGE_SIZE;
+  const int64_t capacity = memory::round_to_pages(size, huge_pages);
+  return PieceBuffer(_shared, allocate(capacity, huge_pages), size, capacity,
+                     huge_pages);
+}
+
+int64_t PieceBufferPool::allocations() const {
+  std::scoped_lock<std::mutex> lock(_shared->mtx);
+  return _shared->allocations;
+}
+
+int64_t PieceBufferPool::retained_bytes() const {
+  std::scoped_lock<std::mutex> lock(_shared->mtx);
+  return _shared->retained_bytes;
+}
+
+}  // namespace fur::download
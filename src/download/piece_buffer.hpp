@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace fur::download {
+
+class PieceBufferPool;
+
+/// Memory holding the content of a single piece. A buffer is created once,
+/// moved from the download to the verification and saving stages without
+/// copies, and returned to its pool when destroyed. The content of a recycled
+/// buffer is not cleared.
+class PieceBuffer {
+ public:
+  /// Shared state of a pool, outlives the pool if buffers are still around
+  struct Shared;
+
+ private:
+  /// Pool to return the memory to, missing for buffers outside any pool
+  std::shared_ptr<Shared> _pool;
+  /// Start of the memory
+  uint8_t* _data;
+  /// Number of bytes in use
+  int64_t _size;
+  /// Number of bytes reserved
+  int64_t _capacity;
+  /// True if the memory is backed by huge pages
+  bool _huge_pages;
+
+ public:
+  /// Construct an empty buffer
+  PieceBuffer();
+  /// Construct a buffer outside any pool, its memory is freed on destruction
+  /// @param size number of bytes of the buffer
+  explicit PieceBuffer(int64_t size);
+  ~PieceBuffer();
+
+  PieceBuffer(const PieceBuffer&) = delete;
+  PieceBuffer& operator=(const PieceBuffer&) = delete;
+  PieceBuffer(PieceBuffer&& other) noexcept;
+  PieceBuffer& operator=(PieceBuffer&& other) noexcept;
+
+  [[nodiscard]] uint8_t* data();
+  [[nodiscard]] const uint8_t* data() const;
+  /// @return number of bytes in use
+  [[nodiscard]] int64_t size() const;
+
+ private:
+  PieceBuffer(std::shared_ptr<Shared> pool, uint8_t* data, int64_t size,
+              int64_t capacity, bool huge_pages);
+
+  /// Give the memory back to the pool or to the OS
+  void release();
+
+  friend PieceBufferPool;
+};
+
+/// Bounded pool of reusable piece buffers. Buffers larger than a huge page can
+/// be backed by huge pages. At most `max_bytes` are kept around while unused,
+/// buffers returned past that limit are freed.
+class PieceBufferPool {
+  std::shared_ptr<PieceBuffer::Shared> _shared;
+
+ public:
+  /// @param max_bytes maximum number of bytes of unused buffers to keep
+  /// @param huge_pages back large buffers with huge pages
+  PieceBufferPool(int64_t max_bytes, bool huge_pages);
+
+  /// Hand out a buffer, recycled if possible
+  /// @param size number of bytes of the buffer
+  PieceBuffer acquire(int64_t size);
+
+  /// @return number of times memory had to be requested to the OS
+  [[nodiscard]] int64_t allocations() const;
+  /// @return number of bytes of unused buffers currently kept
+  [[nodiscard]] int64_t retained_bytes() const;
+};
+
+}  // namespace fur::download
@@ -0,0 +1,81 @@
+#include "download/retry.hpp"
+
+#include <algorithm>
+
+namespace fur::download::retry {
+
+Failure classify(downloader::DownloaderError error) {
+  using downloader::DownloaderError;
+  switch (error) {
+    case DownloaderError::MissingPiece:
+      return Failure::Missing;
+    case DownloaderError::SocketTimeout:
+      return Failure::Timeout;
+    case DownloaderError::CorruptPiece:
+      return Failure::Corrupt;
+    case DownloaderError::CannotStore:
+      return Failure::Storage;
+    case DownloaderError::DifferentInfoHash:
+    case DownloaderError::InvalidMessage:
+    case DownloaderError::NoBitfield:
+    case DownloaderError::SocketOther:
+      break;
+  }
+  return Failure::Protocol;
+}
+
+int64_t budget(Failure failure) {
+  switch (failure) {
+    case Failure::Missing:
+      return MISSING_ATTEMPTS;
+    case Failure::Timeout:
+      return TIMEOUT_ATTEMPTS;
+    case Failure::Corrupt:
+      return CORRUPT_ATTEMPTS;
+    case Failure::Protocol:
+      return PROTOCOL_ATTEMPTS;
+    case Failure::Storage:
+      break;
+  }
+  return STORAGE_ATTEMPTS;
+}
+
+std::chrono::milliseconds backoff(int64_t failures) {
+  int64_t wait = BACKOFF_MS;
+  for (int64_t i = 1; i < failures && wait < BACKOFF_MAX_MS; i++)
+    wait *= 2;
+  return std::chrono::milliseconds(std::min(wait, BACKOFF_MAX_MS));
+}
+
+Retries::Retries() : _failures{} {}
+
+std::optional<std::chrono::milliseconds> Retries::fail(Failure failure) {
+  int64_t& failures = _failures[static_cast<size_t>(failure)];
+  failures += 1;
+  if (failures >= budget(failure)) return std::nullopt;
+  return backoff(total());
+}
+
+int64_t Retries::failures(Failure failure) const {
+  return _failures[static_cast<size_t>(failure)];
+}
+
+int64_t Retries::total() const {
+  int64_t total = 0;
+  for (int64_t failures : _failures) total += failures;
+  return total;
+}
+
+FailureCounters::FailureCounters() {
+  for (auto& count : _counts) count.store(0, std::memory_order_relaxed);
+}
+
+void FailureCounters::add(Failure failure) {
+  _counts[static_cast<size_t>(failure)].fetch_add(1, std::memory_order_relaxed);
+}
+
+int64_t FailureCounters::get(Failure failure) const {
+  return _counts[static_cast<size_t>(failure)].load(std::memory_order_relaxed);
+}
+
+}  // namespace fur::download::retry
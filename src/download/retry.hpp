@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "download/downloader.hpp"
+
+namespace fur::download::retry {
+
+/// Why an attempt at a piece failed, every class has its own retry budget
+enum class Failure {
+  /// The peer doesn't have the piece
+  Missing,
+  /// The peer didn't answer in time
+  Timeout,
+  /// The piece doesn't match its hash
+  Corrupt,
+  /// The connection failed or the peer didn't follow the protocol
+  Protocol,
+  /// The piece could not be written to storage
+  Storage,
+};
+
+/// Number of classes of `Failure`
+const int64_t FAILURE_CLASSES = 5;
+
+/// Failed attempts at a piece, for every class of failure, after which the
+/// piece is set aside until the peers of its torrent change
+const int64_t MISSING_ATTEMPTS = 8;
+const int64_t TIMEOUT_ATTEMPTS = 6;
+const int64_t CORRUPT_ATTEMPTS = 4;
+const int64_t PROTOCOL_ATTEMPTS = 6;
+const int64_t STORAGE_ATTEMPTS = 4;
+
+/// Wait before the second attempt at a piece, doubled at every further
+/// failure up to `BACKOFF_MAX_MS`
+const int64_t BACKOFF_MS = 100;
+const int64_t BACKOFF_MAX_MS = 30 * 1000;
+
+/// @return class of the error of a failed download
+Failure classify(downloader::DownloaderError error);
+
+/// @return failed attempts of a class after which a piece is set aside until
+/// the peers of its torrent change
+int64_t budget(Failure failure);
+
+/// @return wait before the next attempt at a piece, doubled at every failure
+/// up to `BACKOFF_MAX_MS`
+/// @param failures failed attempts at the piece so far, at least 1
+std::chrono::milliseconds backoff(int64_t failures);
+
+/// Failed attempts at a single piece
+class Retries {
+  std::array<int64_t, FAILURE_CLASSES> _failures;
+
+ public:
+  Retries();
+
+  /// Record a failed attempt
+  /// @return wait before the next attempt, nothing if the budget of the class
+  /// is spent and the piece must be set aside
+  std::optional<std::chrono::milliseconds> fail(Failure failure);
+
+  /// @return failed attempts of a class
+  [[nodiscard]] int64_t failures(Failure failure) const;
+
+  /// @return failed attempts of all classes
+  [[nodiscard]] int64_t total() const;
+};
+
+/// Failed attempts of every class, shared by all the workers
+class FailureCounters {
+  std::array<std::atomic<int64_t>, FAILURE_CLASSES> _counts;
+
+ public:
+  FailureCounters();
+
+  /// Count a failed attempt
+  void add(Failure failure);
+
+  /// @return failed attempts of a class so far
+  [[nodiscard]] int64_t get(Failure failure) const;
+};
+
+}  // namespace fur::download::retry
@@ -1,44 +1,51 @@
-#include <bencode/bencode_parser.hpp>
+#include <bencode/bencode_cursor.hpp>
 #include <config.hpp>
 #include <fstream>
 #include <furrent.hpp>
 #include <iostream>
 #include <log/logger.hpp>
+#include <mt/parallel.hpp>
 #include <platform/io.hpp>
 #include <policy/policy.hpp>
 #include <random>
+#include <recheck.hpp>
+#include <resume.hpp>
+#include <session.hpp>
+#include <storage/file.hpp>
 
 namespace fur {
 
 /// Constructs a new empty piece task
-PieceTask::PieceTask() : _data{std::nullopt}, tid{0} {}
+PieceTask::PieceTask() : tid{0}, index{0} {}
 
 /// Constructs a new piece task
-PieceTask::PieceTask(TorrentID tid, Piece piece, const TorrentFile& descriptor)
-    : _data{std::nullopt},
-      tid{tid},
-      piece{std::move(piece)},
-      descriptor{descriptor} {}
-
-/// Process piece, downloads it from a peer and saves it to file
-PieceTaskStats PieceTask::process(const peer::Peer& peer) {
-  PieceTaskStats stats{};
-  stats.completed = download(peer) && save();
-  return stats;
-}
-
-/// Download the PieceTask from the provided peer and inserts it into the _data
-/// member variable.
-bool PieceTask::download(const peer::Peer& peer) {
+PieceTask::PieceTask(TorrentID tid, int64_t index,
+                     std::shared_ptr<const TorrentFile> descriptor,
+                     FilePriority priority)
+    : tid{tid},
+      index{index},
+      descriptor{std::move(descriptor)},
+      priority{priority} {}
+
+/// Download the PieceTask from the provided peer
+auto PieceTask::download(const Piece& piece, const peer::Peer& peer,
+                         download::PieceBufferPool& buffers)
+    -> util::Result<download::Downloaded,
+                    download::downloader::DownloaderError> {
+  using Result = util::Result<download::Downloaded,
+                              download::downloader::DownloaderError>;
   auto logger = spdlog::get("custom");
   auto clock_beg = std::chrono::high_resolution_clock::now();
 
-  download::downloader::Downloader d(descriptor, peer);
+  // Verification happens later on the hashing threads
+  download::downloader::Downloader d(*descriptor, peer, &buffers,
+                                     download::downloader::Verification::Deferred);
   auto download = d.try_download(piece);
   if (!download.valid()) {
     logger->trace("Error while downloading piece [{:4}] of T{} from {}",
                   piece.index, tid, peer.address());
-    return false;
+    return Result::ERROR(
+        download::downloader::DownloaderError(download.error()));
   }
 
   auto clock_end = std::chrono::high_resolution_clock::now();
@@ -48,28 +55,20 @@ bool PieceTask::download(const peer::Peer& peer) {
   logger->info("Downloaded piece [{:4}] of T{} from {} ({} ms)", piece.index,
                tid, peer.address(), clock_elapsed.count());
 
-  std::optional<download::Downloaded> data(*download);
-  _data.swap(data);
-
-  return true;
+  return Result::OK(std::move(*download));
 }
 
-/// Save to file
-bool PieceTask::save() const {
+/// Save to storage
+bool PieceTask::save(const Piece& piece, const download::Downloaded& data,
+                     storage::StorageBackend& storage) const {
   auto logger = spdlog::get("custom");
 
-  // Write every subpiece
-  for (const auto& subpiece : piece.subpieces) {
-    const std::string filepath =
-        descriptor.folder_name + '/' + subpiece.filepath;
-    const auto maybe_write = fur::platform::io::write_bytes(
-        filepath, _data.value().content, subpiece.file_offset);
-
-    if (!maybe_write.valid()) {
-      logger->error("Error while saving piece [{:4}] of T{} to {}", piece.index,
-                    tid, piece.subpieces[0].filepath);
-      return false;
-    }
+  auto write = storage.write_piece(*descriptor, piece, data.content.data(),
+                                   data.content.size());
+  if (!write.valid()) {
+    logger->error("Error while saving piece [{:4}] of T{} to {}", piece.index,
+                  tid, piece.subpieces[0].filepath);
+    return false;
   }
 
   logger->info("Saved piece [{:4}] of T{} to {}", piece.index, tid,
@@ -77,9 +76,64 @@ bool PieceTask::save() const {
   return true;
 }
 
+/// Download the PieceTask from the provided peer straight to storage
+auto PieceTask::stream(const Piece& piece, const peer::Peer& peer,
+                       storage::StorageBackend& storage)
+    -> util::Outcome<download::downloader::DownloaderError> {
+  using Outcome = util::Outcome<download::downloader::DownloaderError>;
+  auto logger = spdlog::get("custom");
+  auto clock_beg = std::chrono::high_resolution_clock::now();
+
+  download::downloader::Downloader d(*descriptor, peer);
+  auto stream = d.try_stream(
+      piece, [&](int64_t offset, const uint8_t* bytes, int64_t len) {
+        return storage.write_block(*descriptor, piece, offset, bytes, len)
+            .valid();
+      });
+  if (!stream.valid()) {
+    logger->trace("Error while streaming piece [{:4}] of T{} from {}",
+                  piece.index, tid, peer.address());
+    return Outcome::ERROR(
+        download::downloader::DownloaderError(stream.error()));
+  }
+
+  auto clock_end = std::chrono::high_resolution_clock::now();
+  auto clock_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      clock_end - clock_beg);
+
+  logger->info("Streamed piece [{:4}] of T{} from {} to {} ({} ms)",
+               piece.index, tid, peer.address(), piece.subpieces[0].filepath,
+               clock_elapsed.count());
+  return Outcome::OK({});
+}
+
+SequentialWindow sequential_window(const TorrentFile& descriptor,
+                                   int64_t first) {
+  const int64_t window_pieces = std::max<int64_t>(
+      1, config::SEQUENTIAL_WINDOW_BYTES / descriptor.piece_length);
+  return {first, std::min(first + window_pieces, descriptor.pieces_count)};
+}
+
+int64_t piece_rank(const std::optional<SequentialWindow>& window,
+                   const PieceTask& task) {
+  if (window.has_value() && task.index >= window->first &&
+      task.index < window->last)
+    return task.index - window->first;
+
+  const int64_t lower = static_cast<int64_t>(FilePriority::High) -
+                        static_cast<int64_t>(task.priority);
+  return RANK_UNORDERED + lower * RANK_PRIORITY_STRIDE + task.index;
+}
+
 // ======================================================================================
 
-Furrent::Furrent() : _descriptor_next_uid{0u}, _download_folder{"."} {
+Furrent::Furrent()
+    : _buffers{config::PIECE_BUFFERS_BYTES, config::PIECE_BUFFERS_HUGE_PAGES},
+      _saving{config::SAVING_THREADS},
+      _hashing{config::HASH_QUEUE_CAPACITY, config::HASH_THREADS},
+      _descriptor_next_uid{0},
+      _download_folder{"."},
+      _storage{std::make_shared<storage::FileBackend>(config::PREALLOCATION)} {
   // Default global logger
   auto logger = spdlog::get("custom");
 
@@ -97,10 +151,21 @@ Furrent::Furrent() : _descriptor_next_uid{0u}, _download_folder{"."} {
 
   _workers.launch(std::bind(&Furrent::thread_main, this, _1, _2, _3),
                   threads_cnt);
+  _announcer.launch(
+      [this](mt::Runner runner, util::Empty&, size_t) {
+        announcer_main(runner);
+      },
+      1);
 }
 
 Furrent::~Furrent() {
+  _announces.begin_skip_waiting();
+  _announcer.terminate();
   _tasks.begin_skip_waiting();
+  // Workers waiting to submit a piece are released, verified pieces not yet
+  // saved are downloaded again next time
+  _hashing.shutdown();
+  _saving.shutdown();
   _workers.terminate();
 }
 
@@ -129,9 +194,16 @@ auto Furrent::set_download_folder(const std::string& folder) -> Result<Empty> {
   return Result<Empty>::OK({});
 }
 
+void Furrent::set_storage(std::shared_ptr<storage::StorageBackend> storage) {
+  // Lock against concurrent additions of torrents
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  _storage = std::move(storage);
+}
+
 /// Print the peers distribution of a torrent
 static void thread_print_torrent_stats(
-    std::mt19937& gen, PieceTask& task, const std::vector<peer::Peer>& peers,
+    std::mt19937& gen, const PieceTask& task,
+    const std::vector<peer::Peer>& peers,
     std::discrete_distribution<int64_t>& distr) {
   std::vector<int64_t> rolls(peers.size());
   for (int i = 0; i < 10000; i++) rolls[distr(gen)] += 1;
@@ -162,14 +234,20 @@ void Furrent::thread_main(mt::Runner runner, WorkerState& state,
   thread_local std::random_device rng;
   thread_local std::mt19937 gen(rng());
 
-  policy::LIFOPolicy<PieceTask> piece_policy;
   while (runner.alive()) {
-    // Try to extract
-    auto extraction = _tasks.try_extract(piece_policy);
+    // Failed tasks whose wait is over compete again with all the others
+    const auto next_due = release_delayed();
+
+    // Pieces right after the read cursor of sequential torrents go first,
+    // the spare bandwidth is used for all the others by priority
+    auto extraction = _tasks.try_extract();
     if (extraction.valid()) {
       PieceTask task = *extraction;
+      Piece piece;
       std::discrete_distribution<int64_t> peers_distribution;
       std::vector<peer::Peer> peers;
+      std::shared_ptr<storage::StorageBackend> storage;
+      bool streaming = false;
 
       // TODO: update peers if necessary, for now peers are constant!
       {
@@ -177,173 +255,696 @@ void Furrent::thread_main(mt::Runner runner, WorkerState& state,
         std::shared_lock<std::shared_mutex> lock(_mtx);
         const Torrent& torrent = _torrents[task.tid];
 
-        // If the torrent is paused then skip processing and add
-        // task to queue again
-        if (torrent.state.load(std::memory_order_relaxed) ==
-            TorrentState::Paused) {
-          _tasks.emplace(task.tid, task.piece, torrent.descriptor());
+        // The torrent has been paused after the task was extracted, the task
+        // goes back to the parked tasks of the torrent
+        const TorrentState torrent_state =
+            torrent.state.load(std::memory_order_relaxed);
+        if (torrent_state == TorrentState::Paused) {
+          _tasks.insert(std::move(task));
           continue;
         }
+        // The torrent has been removed while the task was failing
+        if (torrent_state == TorrentState::Stopped) continue;
+
+        // Files are looked up only when the piece is about to be downloaded
+        piece = torrent.layout().piece(task.index);
 
         // Generate peers score distribution
         peers_distribution = torrent.distribution();
         peers = torrent.peers();
+        storage = torrent.storage;
+        streaming = torrent.streaming.load(std::memory_order_relaxed);
       }
 
-      while (true) {
-        int64_t peer_index = peers_distribution(gen);
-        PieceTaskStats stats = task.process(peers[peer_index]);
-        if (!stats.completed) {
+      // A single attempt from a random peer, failed tasks wait before they
+      // are attempted again so that the worker can move on
+      const int64_t peer_index = peers_distribution(gen);
+
+      // Blocks are stored and verified while they arrive, nothing is left for
+      // the hashing threads
+      if (streaming) {
+        auto streamed = task.stream(piece, peers[peer_index], *storage);
+        if (!streamed.valid()) {
+          task_failed(std::move(task),
+                      download::retry::classify(streamed.error()));
           continue;
         }
 
         state.piece_processed += 1;
+        piece_completed(task, peer_index, *storage);
+        continue;
+      }
 
-        // Lock against writes to the _torrents map
-        std::shared_lock<std::shared_mutex> lock(_mtx);
-        Torrent& torrent = _torrents[task.tid];
-
-        // Update score of used peer
-        torrent.atomic_add_peer_score(peer_index);
-        int64_t processed =
-            torrent.pieces_processed.fetch_add(1, std::memory_order_relaxed) +
-            1;
-
-        // Show peers score distribution every 100 pieces processed
-        if (processed % 100 == 0)
-          thread_print_torrent_stats(gen, task, peers, peers_distribution);
-
-        // Change state to completed if there are no more pieces to process
-        if (processed == torrent.descriptor().pieces_count) {
-          torrent.state.exchange(TorrentState::Completed,
-                                 std::memory_order_relaxed);
-          logger->info("Completed T[{}]", torrent.tid());
-        }
-        break;
+      auto downloaded = task.download(piece, peers[peer_index], _buffers);
+      if (!downloaded.valid()) {
+        task_failed(std::move(task),
+                    download::retry::classify(downloaded.error()));
+        continue;
       }
+
+      state.piece_processed += 1;
+
+      // Verification happens on the hashing threads and saving on the saving
+      // threads, this worker can move on to the next piece right away
+      const hash::hash_t expected = task.descriptor->piece_hashes[task.index];
+      _hashing.submit(
+          std::move(*downloaded), expected,
+          [this, task = std::move(task), piece = std::move(piece), peer_index,
+           storage](download::Downloaded data, bool valid) mutable {
+            // Jobs are copyable, the buffer of the piece is not
+            auto verified = std::make_shared<VerifiedPiece>(
+                VerifiedPiece{std::move(task), std::move(piece), peer_index,
+                              std::move(storage), std::move(data), valid});
+            _saving.submit([this, verified] {
+              piece_verified(verified->task, verified->piece,
+                             verified->peer_index, *verified->storage,
+                             verified->data, verified->valid);
+            });
+          });
     }
 
     // Extraction failure or no more elements
     else {
       switch (extraction.error()) {
         // No more work to do
-        case policy::Queue<PieceTask>::Error::Empty: {
+        case TaskQueue::Error::Empty: {
           logger->info("thread {:02d} is waiting for work, queue is empty",
                        index);
-          _tasks.wait_work();
           break;
         }
 
         // Policy failed to return an element
-        case policy::Queue<PieceTask>::Error::PolicyFailure: {
+        case TaskQueue::Error::PolicyFailure: {
           logger->info(
               "thread {:02d} is waiting for work, policy extraction returned "
               "nothing",
               index);
-          _tasks.wait_work();
           break;
         }
       }
+
+      // Delayed tasks are due even if nothing is inserted in the meantime
+      if (next_due.has_value()) {
+        _tasks.wait_work_until(*next_due);
+      } else {
+        _tasks.wait_work();
+      }
+    }
+  }
+}
+
+/// @return True if both lists hold the same peers, in any order
+static bool same_peers(const std::vector<peer::Peer>& a,
+                       const std::vector<peer::Peer>& b) {
+  auto endpoints = [](const std::vector<peer::Peer>& peers) {
+    std::vector<std::pair<uint32_t, uint16_t>> result;
+    for (const auto& peer : peers) result.emplace_back(peer.ip, peer.port);
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  return endpoints(a) == endpoints(b);
+}
+
+void Furrent::announcer_main(mt::Runner runner) {
+  using std::chrono::steady_clock;
+  auto logger = spdlog::get("custom");
+
+  // Torrents whose pieces set aside are still waiting for other peers, they
+  // are announced again once their time comes
+  std::vector<std::pair<steady_clock::time_point, TorrentID>> later;
+
+  policy::FIFOPolicy<TorrentID> announce_policy;
+  while (runner.alive()) {
+    const auto now = steady_clock::now();
+    for (auto it = later.begin(); it != later.end();) {
+      if (it->first > now) {
+        ++it;
+        continue;
+      }
+      _announces.insert(TorrentID(it->second));
+      it = later.erase(it);
     }
+
+    auto extraction = _announces.try_extract(announce_policy);
+    if (!extraction.valid()) {
+      if (later.empty()) {
+        _announces.wait_work();
+      } else {
+        _announces.wait_work_until(
+            std::min_element(later.begin(), later.end())->first);
+      }
+      continue;
+    }
+
+    const TorrentID tid = *extraction;
+    std::shared_ptr<const TorrentFile> descriptor;
+    {
+      // Lock against writes to the _torrents map
+      std::shared_lock<std::shared_mutex> lock(_mtx);
+      auto it = _torrents.find(tid);
+      if (it == _torrents.end()) continue;
+      descriptor = it->second.shared_descriptor();
+    }
+
+    // The tracker can take a long time, the workers keep downloading from the
+    // peers they have in the meantime
+    auto response = peer::announce(*descriptor);
+    bool changed = false;
+    int64_t interval = 0;
+    if (!response.valid() || response->peers.empty()) {
+      logger->error("Error announcing T{} to tracker, keeping its peers", tid);
+    } else {
+      {
+        // Workers copy the peers under the shared lock
+        std::unique_lock<std::shared_mutex> lock(_mtx);
+        Torrent& torrent = _torrents[tid];
+        interval = response->interval;
+        // Scores of the peers are kept if nothing changed
+        changed = !same_peers(torrent.peers(), response->peers);
+        if (changed) torrent.set_peers(std::move(*response));
+      }
+      logger->info("Announced T{} to tracker", tid);
+    }
+
+    // Pieces set aside only get another chance from different peers, until
+    // then the tracker is asked again as often as it allows
+    if (changed) {
+      release_stalled(tid);
+      continue;
+    }
+
+    bool stalled = false;
+    {
+      std::scoped_lock<std::mutex> lock(_retry_mtx);
+      stalled = _stalled.count(tid) > 0;
+    }
+    const bool scheduled =
+        std::any_of(later.begin(), later.end(),
+                    [&](const auto& entry) { return entry.second == tid; });
+    if (stalled && !scheduled) {
+      const int64_t wait = std::max(interval, config::STALLED_ANNOUNCE_SECONDS);
+      later.emplace_back(steady_clock::now() + std::chrono::seconds(wait), tid);
+    }
+  }
+}
+
+void Furrent::update_window(const Torrent& torrent) {
+  if (!torrent.sequential.load(std::memory_order_relaxed)) return;
+
+  // Computed under the lock of the queue, so that a stale window never
+  // replaces a newer one. The cursor is never behind the content already
+  // readable.
+  _tasks.access([&](auto& queue) {
+    const TorrentFile& descriptor = torrent.descriptor();
+    const int64_t first = std::max(
+        torrent.read_cursor.load(std::memory_order_relaxed) /
+            descriptor.piece_length,
+        torrent.contiguous_pieces());
+    const SequentialWindow window = sequential_window(descriptor, first);
+
+    auto& rank = queue.rank(torrent.tid());
+    if (rank.window.has_value() && rank.window->first == window.first &&
+        rank.window->last == window.last)
+      return;
+    rank.window = window;
+    queue.rerank(torrent.tid());
+  });
+}
+
+void Furrent::piece_verified(const PieceTask& task, const Piece& piece,
+                             int64_t peer_index,
+                             storage::StorageBackend& storage,
+                             const download::Downloaded& data, bool valid) {
+  auto logger = spdlog::get("custom");
+
+  // The torrent has been removed while the piece was being verified
+  if (torrent_removed(task.tid)) return;
+
+  // Try again later, most likely from another peer
+  if (!valid) {
+    logger->debug("Corrupt piece [{:4}] of T{}", task.index, task.tid);
+    task_failed(PieceTask(task), download::retry::Failure::Corrupt);
+    return;
+  }
+
+  // Storage errors are not the fault of the peers, but a full disk doesn't
+  // go away by downloading the piece again right away either
+  if (!task.save(piece, data, storage)) {
+    task_failed(PieceTask(task), download::retry::Failure::Storage);
+    return;
+  }
+  piece_completed(task, peer_index, storage);
+}
+
+void Furrent::task_failed(PieceTask task, download::retry::Failure failure) {
+  auto logger = spdlog::get("custom");
+  _failures.add(failure);
+
+  // Tasks of a removed torrent that were in flight are not attempted again
+  if (torrent_removed(task.tid)) return;
+
+  const auto wait = task.retries.fail(failure);
+  if (wait.has_value()) {
+    using namespace std::chrono;
+    const auto deadline = steady_clock::now() + *wait;
+    const int64_t due =
+        duration_cast<milliseconds>(deadline.time_since_epoch()).count();
+    bool earliest = false;
+    {
+      std::scoped_lock<std::mutex> lock(_retry_mtx);
+      _delayed.insert({due, std::move(task)});
+      earliest = _delayed.top().due == due;
+    }
+    // Workers may be sleeping without a deadline or with a later one, one of
+    // them must wake up to wait for the new deadline instead
+    if (earliest) _tasks.wake_one();
+    return;
   }
+
+  // Most likely none of the peers can provide the piece, only the first
+  // piece set aside asks for other peers
+  logger->warn("Setting aside piece [{:4}] of T{} after {} failed attempts",
+               task.index, task.tid, task.retries.total());
+  TorrentID tid = task.tid;
+  bool first = false;
+  {
+    std::scoped_lock<std::mutex> lock(_retry_mtx);
+    auto& stalled = _stalled[tid];
+    first = stalled.empty();
+    stalled.push_back(std::move(task));
+  }
+  if (first) _announces.insert(std::move(tid));
 }
 
-bool Furrent::prepare_torrent_files(TorrentFile& descriptor) {
-  using namespace fur::platform;  // For IO operations
+auto Furrent::release_delayed()
+    -> std::optional<std::chrono::steady_clock::time_point> {
+  using namespace std::chrono;
+  const int64_t now =
+      duration_cast<milliseconds>(steady_clock::now().time_since_epoch())
+          .count();
+
+  std::vector<PieceTask> due;
+  std::optional<steady_clock::time_point> next;
+  {
+    std::scoped_lock<std::mutex> lock(_retry_mtx);
+    while (_delayed.size() > 0 && _delayed.top().due <= now)
+      due.push_back(std::move(_delayed.extract()->task));
+    if (_delayed.size() > 0)
+      next = steady_clock::time_point(milliseconds(_delayed.top().due));
+  }
 
-  std::string torrent_base_path = _download_folder + '/' + descriptor.name;
-  auto existence = io::exists(torrent_base_path);
+  // Inserted outside of the lock, the task queue has its own
+  for (auto& task : due) {
+    if (!torrent_removed(task.tid)) _tasks.insert(std::move(task));
+  }
+  return next;
+}
 
-  const int64_t MAX_COPY_ATTEMPTS = 10;
-  int64_t attempts = 0;
+void Furrent::release_stalled(TorrentID tid) {
+  auto logger = spdlog::get("custom");
 
-  // If directory already exists then keep adding "COPY"
-  while (attempts < MAX_COPY_ATTEMPTS && existence.valid() && *existence) {
-    torrent_base_path += " COPY";
-    existence = io::exists(torrent_base_path);
-    attempts += 1;
+  std::vector<PieceTask> stalled;
+  {
+    std::scoped_lock<std::mutex> lock(_retry_mtx);
+    auto it = _stalled.find(tid);
+    if (it == _stalled.end()) return;
+    stalled = std::move(it->second);
+    _stalled.erase(it);
   }
+  if (torrent_removed(tid)) return;
 
-  // If we tried to many times to generate new folders copy
-  if (attempts > MAX_COPY_ATTEMPTS) return false;
+  logger->info("Attempting again {} pieces of T{} set aside", stalled.size(),
+               tid);
+  for (auto& task : stalled) {
+    task.retries = download::retry::Retries();
+    _tasks.insert(std::move(task));
+  }
+}
 
-  // Create output directory
-  auto torrent_dirpath = io::create_directories(torrent_base_path);
-  if (!torrent_dirpath.valid()) return false;
+void Furrent::piece_completed(const PieceTask& task, int64_t peer_index,
+                              storage::StorageBackend& storage) {
+  auto logger = spdlog::get("custom");
+  thread_local std::random_device rng;
+  thread_local std::mt19937 gen(rng());
 
-  // Create output files
-  bool must_cleanup = false;
-  descriptor.folder_name = *torrent_dirpath;
-  for (const auto& file : descriptor.files) {
-    // Create nested folders
-    auto file_dirpath = io::create_directories(
-        descriptor.folder_name + '/' + file.filename(), true);
-    if (!file_dirpath.valid()) {
-      must_cleanup = true;
-      break;
+  std::shared_ptr<resume::ResumeFile> resume;
+  bool torrent_completed = false;
+  {
+    // Lock against writes to the _torrents map
+    std::shared_lock<std::shared_mutex> lock(_mtx);
+    Torrent& torrent = _torrents[task.tid];
+
+    // Update score of used peer
+    torrent.atomic_add_peer_score(peer_index);
+    torrent.mark_completed(task.index);
+    update_window(torrent);
+    int64_t processed =
+        torrent.pieces_processed.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    // Show peers score distribution every 100 pieces processed
+    if (processed % 100 == 0) {
+      auto distribution = torrent.distribution();
+      thread_print_torrent_stats(gen, task, torrent.peers(), distribution);
+      logger->info("T{} got {:.1f}% of the bytes handed to the workers",
+                   task.tid, worker_share(task.tid) * 100.0);
+
+      auto hashing = _hashing.stats();
+      logger->info(
+          "Hashing: {} pieces queued (max {}), {} verified, {} corrupt, "
+          "latency {:.1f} ms (max {:.1f} ms), {:.1f} ms per piece",
+          hashing.queue_depth, hashing.max_queue_depth, hashing.verified,
+          hashing.corrupt, hashing.mean_latency * 1e3,
+          hashing.max_latency * 1e3, hashing.mean_hash_time * 1e3);
+
+      auto retries = get_retry_stats();
+      logger->info(
+          "Failed attempts: {} missing, {} timeout, {} corrupt, {} protocol, "
+          "{} storage, {} pieces delayed, {} set aside",
+          retries.failures[0], retries.failures[1], retries.failures[2],
+          retries.failures[3], retries.failures[4], retries.delayed,
+          retries.stalled);
     }
 
-    // Create single output file
-    std::string filepath = *file_dirpath + '/' + file.filepath.back();
-    auto creation = io::touch(filepath, file.length);
-    if (!creation.valid()) {
-      must_cleanup = true;
-      break;
+    // Change state to completed if there are no more pieces to process, a
+    // removed torrent whose last pieces were in flight stays stopped
+    if (processed == torrent.pieces_wanted.load(std::memory_order_relaxed)) {
+      TorrentState state = torrent.state.load(std::memory_order_relaxed);
+      while (state != TorrentState::Stopped &&
+             !torrent.state.compare_exchange_weak(state,
+                                                  TorrentState::Completed,
+                                                  std::memory_order_relaxed)) {
+      }
+      if (state != TorrentState::Stopped) {
+        logger->info("Completed T[{}]", torrent.tid());
+        torrent_completed = true;
+      }
     }
+    resume = torrent.resume;
   }
 
-  // Remove created content if we failed to create all files
-  if (must_cleanup) {
-    io::remove(descriptor.folder_name);
-    return false;
+  // Persist progress outside of the lock, writing can be slow
+  if (torrent_completed && !storage.flush(*task.descriptor).valid()) {
+    logger->error("Error while flushing content of T{}", task.tid);
   }
+  if (resume) {
+    bool recorded = resume->mark_completed(task.index);
+    // The last pieces don't wait for a batch that never fills up
+    if (torrent_completed) recorded = resume->save() && recorded;
+    if (!recorded)
+      logger->error("Error while updating resume file of T{}", task.tid);
+  }
+}
 
-  return true;
+bool Furrent::prepare_torrent_files(
+    TorrentFile& descriptor, storage::StorageBackend& storage,
+    bool reuse_existing, const std::vector<FilePriority>& priorities) {
+  descriptor.folder_name = _download_folder + '/' + descriptor.name;
+  return storage.prepare(descriptor, reuse_existing, priorities).valid();
+}
+
+std::string Furrent::resume_filepath(const TorrentFile& descriptor) const {
+  return _download_folder + '/' + config::RESUME_FOLDER + '/' +
+         hash::hash_to_hex(descriptor.info_hash) + ".resume";
+}
+
+/// @return pieces recorded as saved that are still valid, the suspect ones
+/// are verified and only the pieces whose content matches are kept
+static download::bitfield::Bitfield confirm_pieces(
+    const TorrentFile& descriptor, storage::StorageBackend& storage,
+    resume::Validation validation) {
+  auto logger = spdlog::get("custom");
+  const int64_t suspect = validation.suspect.count();
+  if (suspect == 0) return std::move(validation.trusted);
+
+  auto report = recheck::recheck(descriptor, storage, 0, &validation.suspect);
+  logger->info(
+      "Rechecked {} pieces of {} changed after its resume file: {} valid",
+      suspect, descriptor.name, report.valid_pieces.count());
+  for (int64_t index = 0; index < descriptor.pieces_count; index++) {
+    if (report.valid_pieces.get(index)) validation.trusted.set(index);
+  }
+  return std::move(validation.trusted);
+}
+
+auto Furrent::resume_torrent_files(TorrentFile& descriptor,
+                                   storage::StorageBackend& storage,
+                                   const resume::ResumeData* fallback) const
+    -> std::optional<download::bitfield::Bitfield> {
+  auto data = resume::load(resume_filepath(descriptor));
+  if (data.valid()) {
+    auto validation = resume::validate(*data, descriptor);
+    if (validation.has_value()) {
+      descriptor.folder_name = data->folder_name;
+      return confirm_pieces(descriptor, storage, std::move(*validation));
+    }
+  }
+  if (fallback == nullptr) return std::nullopt;
+
+  auto validation = resume::validate(*fallback, descriptor);
+  if (!validation.has_value()) return std::nullopt;
+
+  descriptor.folder_name = fallback->folder_name;
+  return confirm_pieces(descriptor, storage, std::move(*validation));
+}
+
+auto Furrent::recheck_torrent_files(
+    TorrentFile& descriptor, storage::StorageBackend& storage,
+    const std::vector<FilePriority>& priorities)
+    -> std::optional<download::bitfield::Bitfield> {
+  auto logger = spdlog::get("custom");
+  if (!prepare_torrent_files(descriptor, storage, true, priorities))
+    return std::nullopt;
+
+  logger->info("Rechecking {} content at {}", descriptor.name,
+               descriptor.folder_name);
+  auto report = recheck::recheck(descriptor, storage);
+  logger->info(
+      "Rechecked {}: {}/{} pieces valid, {:.2f} GB in {:.2f} s ({:.2f} GB/s)",
+      descriptor.name, report.valid_pieces.count(), descriptor.pieces_count,
+      static_cast<double>(report.bytes_read) / 1e9, report.seconds,
+      report.throughput());
+
+  return std::move(report.valid_pieces);
 }
 
 /// Begin download of a torrent
-auto Furrent::add_torrent(const std::string& filename) -> Result<TorrentID> {
+auto Furrent::add_torrent(const std::string& filename,
+                          const TorrentOptions& options) -> Result<TorrentID> {
+  auto admission = load_torrent(filename, options);
+  if (!admission.valid())
+    return Result<TorrentID>::ERROR(Error(admission.error()));
+
+  auto prepared = prepare_torrent(*admission, options);
+  if (!prepared.valid())
+    return Result<TorrentID>::ERROR(Error(prepared.error()));
+
+  announce_torrent(*admission);
+  return register_torrent(std::move(*admission), options);
+}
+
+auto Furrent::add_torrents(const std::string& folder,
+                           const TorrentOptions& options)
+    -> Result<std::vector<TorrentID>> {
+  auto logger = spdlog::get("custom");
+
+  auto files = fur::platform::io::list_files(folder, ".torrent");
+  if (!files.valid()) {
+    logger->critical("Error listing torrents in folder [{}]", folder);
+    return Result<std::vector<TorrentID>>::ERROR(Error::LoadingTorrentFailed);
+  }
+
+  // Every addition waits for its own tracker, many of them are in flight
+  std::vector<std::optional<TorrentID>> added(files->size());
+  mt::parallel_for(
+      static_cast<int64_t>(files->size()),
+      [&](int64_t index) {
+        auto tid = add_torrent((*files)[index], options);
+        if (tid.valid()) added[index] = *tid;
+      },
+      config::ADMISSION_THREADS);
+
+  std::vector<TorrentID> tids;
+  for (const auto& tid : added) {
+    if (tid.has_value()) tids.push_back(*tid);
+  }
+  logger->info("Added {}/{} torrents from folder [{}]", tids.size(),
+               files->size(), folder);
+  return Result<std::vector<TorrentID>>::OK(std::move(tids));
+}
+
+auto Furrent::load_torrent(const std::string& filename,
+                           const TorrentOptions& options) -> Result<Admission> {
   auto logger = spdlog::get("custom");
 
-  TorrentID tid = _descriptor_next_uid;
-  _descriptor_next_uid += 1;
+  const TorrentID tid = _descriptor_next_uid.fetch_add(1);
 
-  // Load .torrent content
-  auto reading = fur::platform::io::load_file_text(filename);
+  // Map .torrent content, the parser reads it in place
+  auto reading = fur::platform::io::MappedFile::open(filename);
   if (!reading.valid()) {
     logger->critical("Error loading torrent T{} from file [{}]", tid, filename);
-    return Result<TorrentID>::ERROR(Error::LoadingTorrentFailed);
+    return Result<Admission>::ERROR(Error::LoadingTorrentFailed);
   }
 
-  // Parse content
-  auto parser = fur::bencode::BencodeParser();
-  auto btree = parser.decode(*reading);
-  if (!btree.valid()) {
-    logger->critical("Error parsing torrent T{} described at [{}]", tid,
-                     filename);
-    return Result<TorrentID>::ERROR(Error::LoadingTorrentFailed);
+  // Parse content, only the fields we need are decoded
+  std::optional<TorrentFile> parsed;
+  try {
+    parsed.emplace(fur::bencode::BencodeCursor(reading->view()));
+  } catch (const std::exception& error) {
+    logger->critical("Error parsing torrent T{} described at [{}]: {}", tid,
+                     filename, error.what());
+    return Result<Admission>::ERROR(Error::LoadingTorrentFailed);
   }
 
-  // Create new torrent object and mapped files
-  TorrentFile descriptor(*(*btree));
-  if (!prepare_torrent_files(descriptor)) {
-    logger->critical("Error preparing torrent T{} described at [{}]", tid,
-                     filename);
-    return Result<TorrentID>::ERROR(Error::LoadingTorrentFailed);
+  if (!options.file_priorities.empty() &&
+      options.file_priorities.size() != parsed->files.size()) {
+    logger->critical("T{} has {} files but {} priorities were given", tid,
+                     parsed->files.size(), options.file_priorities.size());
+    return Result<Admission>::ERROR(Error::LoadingTorrentFailed);
   }
 
-  logger->info("Announcing T{} to tracker at {}", tid, descriptor.announce_url);
+  if (options.weight <= 0) {
+    logger->critical("T{} has weight {}, it must be positive", tid,
+                     options.weight);
+    return Result<Admission>::ERROR(Error::LoadingTorrentFailed);
+  }
 
-  // Lock against concurrent read/write of the _torrents map
-  std::unique_lock<std::shared_mutex> lock(_mtx);
-  // This creates the Torrent instance and makes the announcement to the tracker
-  _torrents.try_emplace(tid, tid, descriptor);
-  Torrent& torrent = _torrents[tid];
+  Admission admission;
+  admission.tid = tid;
+  admission.descriptor = std::move(*parsed);
+  admission.priorities =
+      piece_priorities(admission.descriptor, options.file_priorities);
+  return Result<Admission>::OK(std::move(admission));
+}
+
+auto Furrent::prepare_torrent(Admission& admission,
+                              const TorrentOptions& options,
+                              const resume::ResumeData* snapshot)
+    -> Result<Empty> {
+  auto logger = spdlog::get("custom");
+  TorrentFile& descriptor = admission.descriptor;
+
+  {
+    std::shared_lock<std::shared_mutex> lock(_mtx);
+    admission.storage = _storage;
+  }
+  auto& storage = *admission.storage;
+
+  // Create new torrent object and mapped files, unless a previous download of
+  // the same torrent can be resumed or the content is already stored. Only
+  // persistent storage can be resumed.
+  auto resumed = options.recheck ? recheck_torrent_files(
+                                       descriptor, storage,
+                                       options.file_priorities)
+                 : storage.persistent()
+                     ? resume_torrent_files(descriptor, storage, snapshot)
+                     : std::optional<download::bitfield::Bitfield>();
+
+  // Files deleted since the resume data was written are created again in
+  // the same folder, their pieces are downloaded again
+  if (resumed.has_value() && !options.recheck &&
+      !storage.prepare(descriptor, true, options.file_priorities).valid()) {
+    logger->critical("Error preparing resumed torrent T{} named {}",
+                     admission.tid, descriptor.name);
+    return Result<Empty>::ERROR(Error::LoadingTorrentFailed);
+  }
+
+  if (resumed.has_value()) {
+    logger->info("Resuming T{} from {} ({}/{} pieces already saved)",
+                 admission.tid, descriptor.folder_name, resumed->count(),
+                 descriptor.pieces_count);
+  } else if (options.recheck ||
+             !prepare_torrent_files(descriptor, storage, false,
+                                    options.file_priorities)) {
+    logger->critical("Error preparing torrent T{} named {}", admission.tid,
+                     descriptor.name);
+    return Result<Empty>::ERROR(Error::LoadingTorrentFailed);
+  }
+
+  if (resumed.has_value())
+    admission.completed.emplace(std::move(*resumed));
+  else
+    admission.completed.emplace(descriptor.pieces_count);
+
+  // Record where the files are as soon as possible, a restart will find them
+  if (storage.persistent()) {
+    auto resume_dirpath = fur::platform::io::create_directories(
+        _download_folder + '/' + config::RESUME_FOLDER);
+    admission.resume = std::make_shared<resume::ResumeFile>(
+        resume_filepath(descriptor), descriptor, *admission.completed,
+        config::RESUME_BATCH_PIECES,
+        std::chrono::milliseconds(config::RESUME_BATCH_MS));
+    if (!resume_dirpath.valid() || !admission.resume->save()) {
+      logger->error("Error while creating resume file of T{}", admission.tid);
+    }
+  }
+  return Result<Empty>::OK({});
+}
+
+void Furrent::announce_torrent(Admission& admission) {
+  auto logger = spdlog::get("custom");
+  logger->info("Announcing T{} to tracker at {}", admission.tid,
+               admission.descriptor.announce_url);
+
+  auto response = peer::announce(admission.descriptor);
+  if (!response.valid()) {
+    logger->critical("Error announcing T{} to tracker!", admission.tid);
+    return;
+  }
+  admission.announce = std::move(*response);
+}
+
+auto Furrent::register_torrent(Admission admission,
+                               const TorrentOptions& options)
+    -> Result<TorrentID> {
+  auto logger = spdlog::get("custom");
+  const TorrentID tid = admission.tid;
+  const TorrentFile& descriptor = admission.descriptor;
+  const download::bitfield::Bitfield& completed = *admission.completed;
+  const std::vector<FilePriority>& priorities = admission.priorities;
+
+  Torrent* registered = nullptr;
+  {
+    // Lock against concurrent read/write of the _torrents map, the torrent
+    // is ready to be inserted and nothing slow happens here
+    std::unique_lock<std::shared_mutex> lock(_mtx);
+    registered = &_torrents.try_emplace(tid, tid, descriptor).first->second;
+    registered->resume = std::move(admission.resume);
+    registered->storage = std::move(admission.storage);
+    registered->file_priorities = options.file_priorities;
+    if (admission.announce.has_value())
+      registered->set_peers(std::move(*admission.announce));
+  }
+  // Elements of the map are never removed nor moved
+  Torrent& torrent = *registered;
+  torrent.sequential.store(options.sequential);
+  torrent.streaming.store(options.streaming);
+  set_torrent_share(tid, options.weight, options.priority);
+
+  // Only the pieces of skipped files don't count, completed or not
+  int64_t wanted = 0;
+  int64_t wanted_completed = 0;
+  for (int64_t index = 0; index < descriptor.pieces_count; index++) {
+    if (completed.get(index)) torrent.mark_completed(index);
+    if (priorities[index] == FilePriority::Skip) continue;
+
+    wanted += 1;
+    if (completed.get(index)) wanted_completed += 1;
+  }
+  torrent.pieces_wanted.store(wanted);
+  torrent.pieces_processed.store(wanted_completed);
+
+  // Nothing left to download
+  if (wanted_completed == wanted) {
+    logger->info("T{} was already completed", tid);
+    torrent.state.exchange(TorrentState::Completed);
+    return Result<TorrentID>::OK(TorrentID(tid));
+  }
 
   // Popolate peers
   std::stringstream ss;
   ss << "Peers:\n";
-  if(torrent.peers().empty()) {
+  const bool peerless = torrent.peers().empty();
+  if (peerless && !admission.announce_later) {
     torrent.state.exchange(TorrentState::Error);
     return Result<TorrentID>::ERROR(Furrent::Error::GenericError);
   }
@@ -351,31 +952,228 @@ auto Furrent::add_torrent(const std::string& filename) -> Result<TorrentID> {
   for (auto& peer : torrent.peers()) ss << "  " << peer.address() << "\n";
   logger->info("{}", ss.str());
 
-  // Create a task for each piece
-  logger->info("Generating {} pieces for T{} ", descriptor.pieces_count, tid);
-  std::vector<Piece> pieces = torrent.pieces();
-  for (Piece& piece : pieces) _tasks.emplace(tid, piece, torrent.descriptor());
+  // Create a task for each piece that is not already on disk, ranked with
+  // the window of the torrent from the start
+  update_window(torrent);
+  logger->info("Generating {} pieces for T{} ", wanted - wanted_completed,
+               tid);
+  const auto shared_descriptor = torrent.shared_descriptor();
+  std::vector<PieceTask> stalled;
+  for (int64_t index = 0; index < descriptor.pieces_count; index++) {
+    const FilePriority priority = priorities[index];
+    if (completed.get(index) || priority == FilePriority::Skip) continue;
+    if (peerless)
+      stalled.emplace_back(tid, index, shared_descriptor, priority);
+    else
+      _tasks.emplace(tid, index, shared_descriptor, priority);
+  }
+  // The pieces come back once the announcer finds peers
+  if (peerless) {
+    logger->info("Setting aside T{} until its tracker answers", tid);
+    std::scoped_lock<std::mutex> lock(_retry_mtx);
+    _stalled[tid] = std::move(stalled);
+  }
   logger->info("Begin downloading T{}", tid);
 
   torrent.state.exchange(TorrentState::Downloading);
   _tasks.force_wakeup();
 
-  return Result<TorrentID>::OK(std::move(tid));
+  return Result<TorrentID>::OK(TorrentID(tid));
 }
 
 /// Removes a torrent descriptor and all of his tasks
 void Furrent::remove_torrent(TorrentID tid) {
-  // Remove all tasks refering to the removed torrent
-  _tasks.mutate([&](PieceTask& task) -> bool { return task.tid == tid; });
+  std::shared_ptr<storage::StorageBackend> storage;
+  std::shared_ptr<const TorrentFile> descriptor;
+  {
+    // Lock against writes to _torrents map
+    std::shared_lock<std::shared_mutex> lock(_mtx);
+    Torrent& torrent = _torrents[tid];
+    storage = torrent.storage;
+    descriptor = torrent.shared_descriptor();
+
+    // Stopped first, tasks in flight that fail from now on are dropped
+    TorrentState state = torrent.state.load(std::memory_order_relaxed);
+    if (state != TorrentState::Completed && state != TorrentState::Error)
+      _torrents[tid].state.exchange(TorrentState::Stopped,
+                                    std::memory_order_relaxed);
+  }
 
+  // Remove all tasks refering to the removed torrent, they are all in its
+  // own flow
+  _tasks.access([&](auto& queue) { queue.erase(tid); });
+  // Writes still in flight reopen their files, at worst they stay open until
+  // the backend needs room for others
+  if (storage && descriptor) storage->release(*descriptor);
+  std::scoped_lock<std::mutex> lock(_retry_mtx);
+  _delayed.mutate(
+      [&](DelayedTask& delayed) -> bool { return delayed.task.tid == tid; });
+  _stalled.erase(tid);
+}
+
+bool Furrent::torrent_removed(TorrentID tid) const {
   // Lock against writes to _torrents map
   std::shared_lock<std::shared_mutex> lock(_mtx);
-  Torrent& torrent = _torrents[tid];
+  auto it = _torrents.find(tid);
+  return it != _torrents.end() &&
+         it->second.state.load(std::memory_order_relaxed) ==
+             TorrentState::Stopped;
+}
 
-  TorrentState state = torrent.state.load(std::memory_order_relaxed);
-  if (state != TorrentState::Completed && state != TorrentState::Error)
-    _torrents[tid].state.exchange(TorrentState::Stopped,
-                                  std::memory_order_relaxed);
+bool Furrent::pause_torrent(TorrentID tid) {
+  // Lock against writes to _torrents map
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  auto it = _torrents.find(tid);
+  if (it == _torrents.end())
+    throw std::invalid_argument("asked for a torrent id that doesn't exist");
+  Torrent& torrent = it->second;
+
+  // The state changes with the tasks locked, a worker finding the torrent
+  // paused always puts its task back among the parked ones
+  return _tasks.access([&](auto& queue) {
+    TorrentState expected = TorrentState::Downloading;
+    if (!torrent.state.compare_exchange_strong(expected, TorrentState::Paused))
+      return false;
+    queue.park(tid);
+    return true;
+  });
+}
+
+bool Furrent::resume_torrent(TorrentID tid) {
+  bool resumed = false;
+  {
+    // Lock against writes to _torrents map
+    std::shared_lock<std::shared_mutex> lock(_mtx);
+    auto it = _torrents.find(tid);
+    if (it == _torrents.end())
+      throw std::invalid_argument("asked for a torrent id that doesn't exist");
+    Torrent& torrent = it->second;
+
+    resumed = _tasks.access([&](auto& queue) {
+      TorrentState expected = TorrentState::Paused;
+      if (!torrent.state.compare_exchange_strong(expected,
+                                                 TorrentState::Downloading))
+        return false;
+      queue.unpark(tid);
+      return true;
+    });
+  }
+  // All the tasks are back at once
+  if (resumed) _tasks.force_wakeup();
+  return resumed;
+}
+
+auto Furrent::save_session(const std::string& filepath) const
+    -> Result<Empty> {
+  auto logger = spdlog::get("custom");
+
+  session::SessionData data;
+  std::vector<download::bitfield::Bitfield> completed;
+  {
+    // Lock against writes to the _torrents map, only copies are taken here
+    std::shared_lock<std::shared_mutex> lock(_mtx);
+    for (const auto& [tid, torrent] : _torrents) {
+      if (torrent.state.load(std::memory_order_relaxed) ==
+          TorrentState::Stopped)
+        continue;
+
+      session::SessionTorrent saved;
+      saved.descriptor = *torrent.shared_descriptor();
+      saved.file_priorities = torrent.file_priorities;
+      saved.sequential = torrent.sequential.load(std::memory_order_relaxed);
+      saved.streaming = torrent.streaming.load(std::memory_order_relaxed);
+      saved.weight = torrent.weight.load(std::memory_order_relaxed);
+      saved.priority = torrent.priority.load(std::memory_order_relaxed);
+      saved.update_interval = torrent.update_interval();
+      saved.peers = torrent.peers();
+      data.torrents.push_back(std::move(saved));
+      completed.push_back(torrent.completed());
+    }
+  }
+
+  // Files are stat'ed after the pieces are copied, a piece saved in between
+  // makes its files look modified and is downloaded again
+  for (size_t i = 0; i < data.torrents.size(); i++) {
+    session::SessionTorrent& saved = data.torrents[i];
+    const TorrentFile& descriptor = saved.descriptor;
+    saved.resume.info_hash = descriptor.info_hash;
+    saved.resume.folder_name = descriptor.folder_name;
+    saved.resume.pieces_count = descriptor.pieces_count;
+    saved.resume.completed = completed[i].get_bytes();
+    for (const auto& file : descriptor.files) {
+      auto stat = platform::io::stat(descriptor.folder_name + '/' +
+                                     file.filename());
+      saved.resume.files.push_back(stat.valid()
+                                       ? *stat
+                                       : platform::io::FileStat{-1, -1});
+    }
+  }
+
+  if (!session::save(filepath, data)) {
+    logger->error("Error while saving session to {}", filepath);
+    return Result<Empty>::ERROR(Error::GenericError);
+  }
+  logger->info("Saved session of {} torrents to {}", data.torrents.size(),
+               filepath);
+  return Result<Empty>::OK({});
+}
+
+auto Furrent::restore_session(const std::string& filepath)
+    -> Result<std::vector<TorrentID>> {
+  auto logger = spdlog::get("custom");
+
+  auto data = session::load(filepath);
+  if (!data.valid()) {
+    logger->error("Error loading session from {}", filepath);
+    return Result<std::vector<TorrentID>>::ERROR(Error::LoadingTorrentFailed);
+  }
+
+  // Torrents are admitted in parallel like those added from a folder, none
+  // of them waits for its tracker
+  std::vector<std::optional<TorrentID>> restored(data->torrents.size());
+  mt::parallel_for(
+      static_cast<int64_t>(data->torrents.size()),
+      [&](int64_t index) {
+        session::SessionTorrent& saved = data->torrents[index];
+        TorrentOptions options;
+        options.sequential = saved.sequential;
+        options.streaming = saved.streaming;
+        options.weight = saved.weight;
+        options.priority = saved.priority;
+        options.file_priorities = std::move(saved.file_priorities);
+
+        Admission admission;
+        admission.tid = _descriptor_next_uid.fetch_add(1);
+        admission.descriptor = std::move(saved.descriptor);
+        admission.priorities =
+            piece_priorities(admission.descriptor, options.file_priorities);
+
+        // The snapshot is only trusted if the resume file isn't
+        if (!prepare_torrent(admission, options, &saved.resume).valid())
+          return;
+
+        // Torrents without peers start once the announcer finds some
+        if (!saved.peers.empty())
+          admission.announce = peer::Announce{saved.update_interval,
+                                              std::move(saved.peers)};
+        admission.announce_later = true;
+
+        auto tid = register_torrent(std::move(admission), options);
+        if (!tid.valid()) return;
+
+        _announces.insert(TorrentID(*tid));
+        restored[index] = *tid;
+      },
+      config::ADMISSION_THREADS);
+
+  std::vector<TorrentID> tids;
+  for (const auto& tid : restored) {
+    if (tid.has_value()) tids.push_back(*tid);
+  }
+
+  logger->info("Restored {}/{} torrents from session {}", tids.size(),
+               data->torrents.size(), filepath);
+  return Result<std::vector<TorrentID>>::OK(std::move(tids));
 }
 
 // Extract torrents stats
@@ -385,12 +1183,70 @@ TorrentGuiData Furrent::get_gui_data(TorrentID target_tid) const {
   for (const auto& [tid, torrent] : _torrents) {
     if (target_tid == tid) {
       const TorrentFile& d = torrent.descriptor();
-      return TorrentGuiData{tid, torrent.state.load(), d.name,
-                            torrent.pieces_processed.load(), d.pieces_count};
+      return TorrentGuiData{tid,
+                            torrent.state.load(),
+                            d.name,
+                            torrent.pieces_processed.load(),
+                            torrent.pieces_wanted.load(),
+                            torrent.contiguous_bytes(),
+                            worker_share(tid)};
     }
   }
 
   throw std::invalid_argument("asked for a torrent id that doesn't exist");
 }
 
+void Furrent::set_torrent_share(TorrentID tid, int64_t weight,
+                                TorrentPriority priority) {
+  if (weight <= 0) throw std::invalid_argument("weight must be positive");
+  {
+    // Lock against writes to the _torrents map
+    std::shared_lock<std::shared_mutex> lock(_mtx);
+    auto it = _torrents.find(tid);
+    if (it == _torrents.end())
+      throw std::invalid_argument("asked for a torrent id that doesn't exist");
+    it->second.weight.store(weight, std::memory_order_relaxed);
+    it->second.priority.store(priority, std::memory_order_relaxed);
+  }
+  _tasks.access([&](auto& queue) {
+    queue.set_share(tid, weight, static_cast<int64_t>(priority));
+  });
+}
+
+double Furrent::worker_share(TorrentID tid) const {
+  return _tasks.access([&](const auto& queue) {
+    const auto total = queue.total();
+    if (total.cost == 0) return 0.0;
+    return static_cast<double>(queue.stats(tid).cost) / total.cost;
+  });
+}
+
+void Furrent::set_read_cursor(TorrentID tid, int64_t offset) {
+  // Lock against writes to the _torrents map
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  auto it = _torrents.find(tid);
+  if (it == _torrents.end())
+    throw std::invalid_argument("asked for a torrent id that doesn't exist");
+  it->second.read_cursor.store(offset, std::memory_order_relaxed);
+  update_window(it->second);
+}
+
+download::HashPoolStats Furrent::get_hashing_stats() const {
+  return _hashing.stats();
+}
+
+RetryStats Furrent::get_retry_stats() const {
+  RetryStats stats{{}, 0, 0};
+  for (int64_t i = 0; i < download::retry::FAILURE_CLASSES; i++) {
+    stats.failures[i] =
+        _failures.get(static_cast<download::retry::Failure>(i));
+  }
+
+  std::scoped_lock<std::mutex> lock(_retry_mtx);
+  stats.delayed = _delayed.size();
+  for (const auto& [tid, stalled] : _stalled)
+    stats.stalled += static_cast<int64_t>(stalled.size());
+  return stats;
+}
+
 }  // namespace fur
@@ -1,9 +1,21 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <download/downloader.hpp>
+#include <download/hash_pool.hpp>
+#include <download/retry.hpp>
+#include <mt/executor.hpp>
 #include <mt/group.hpp>
 #include <mt/sharing_queue.hpp>
+#include <mutex>
+#include <optional>
+#include <platform/io.hpp>
+#include <policy/fair_queue.hpp>
+#include <policy/heap_queue.hpp>
 #include <shared_mutex>
+#include <storage/backend.hpp>
 #include <torrent.hpp>
 #include <types.hpp>
 #include <unordered_map>
@@ -17,44 +29,143 @@ struct TorrentGuiData {
   std::string filename;
 
   int64_t pieces_processed;
+  /// Pieces to download, skipped files don't count
   int64_t pieces_count;
+  /// Bytes that can be read from the beginning without gaps
+  int64_t contiguous_bytes;
+  /// Fraction of all the bytes handed to the workers that belonged to this
+  /// torrent
+  double worker_share;
 };
 
-/// Contains usefull statistics retrived
-/// during the processing of a piece
-struct PieceTaskStats {
-  /// True if the operation was successfull
-  bool completed;
+/// Options used when adding a torrent
+struct TorrentOptions {
+  /// Verify the content already present in the download folder, for example
+  /// left there by another client, and only download the pieces that fail
+  /// the check
+  bool recheck = false;
+  /// Download the pieces in order, so that the content can be consumed while
+  /// the download is in progress, see `Furrent::set_read_cursor`. The order
+  /// only holds among the pieces of the torrent, give it a higher `priority`
+  /// to keep other torrents from taking workers away from it.
+  bool sequential = false;
+  /// Priority of every file in the same order of `TorrentFile::files`, all
+  /// files are downloaded with the same priority if empty
+  std::vector<FilePriority> file_priorities;
+  /// Write every block to storage as soon as it arrives and verify the piece
+  /// incrementally, memory used by a piece in flight no longer depends on its
+  /// length
+  bool streaming = false;
+  /// Share of the workers relative to the other torrents of the same
+  /// priority, must be positive
+  int64_t weight = 1;
+  /// Torrents of a higher priority always get the workers first
+  TorrentPriority priority = TorrentPriority::Normal;
 };
 
 /// Class responsible for processing a piece
 class PieceTask {
-  // Downloaded piece content
-  std::optional<download::Downloaded> _data;
-
  public:
   /// Identifier of the owner torrent
   TorrentID tid;
-  /// Piece to process
-  Piece piece;
-  /// .torrent descriptor
-  TorrentFile descriptor;
+  /// Index of the piece to process, the files it is stored in are found with
+  /// the layout of the torrent only once the piece is processed
+  int64_t index;
+  /// .torrent descriptor, shared by all the tasks of the torrent
+  std::shared_ptr<const TorrentFile> descriptor;
+  /// Highest priority of the files the piece belongs to
+  FilePriority priority;
+  /// Failed attempts at the piece since it was last handed to the workers
+  /// with a fresh budget
+  download::retry::Retries retries;
 
  public:
   /// Constructs an empty temporary piece task
   explicit PieceTask();
   /// Constructs a new piece task
-  PieceTask(TorrentID tid, Piece piece, const TorrentFile& descriptor);
+  PieceTask(TorrentID tid, int64_t index,
+            std::shared_ptr<const TorrentFile> descriptor,
+            FilePriority priority = FilePriority::Normal);
 
-  /// Process piece from downloading to saving
+  /// Download from a peer, the piece is not verified
+  /// @param piece the piece of this task with the files it is stored in
   /// @param peer peer to use for the download
-  PieceTaskStats process(const peer::Peer& peer);
+  /// @param buffers where the memory of the piece comes from
+  [[nodiscard]] util::Result<download::Downloaded,
+                             download::downloader::DownloaderError>
+  download(const Piece& piece, const peer::Peer& peer,
+           download::PieceBufferPool& buffers);
+  /// Save to storage
+  /// @param piece the piece of this task with the files it is stored in
+  [[nodiscard]] bool save(const Piece& piece, const download::Downloaded& data,
+                          storage::StorageBackend& storage) const;
+  /// Download from a peer writing every block to storage as soon as it
+  /// arrives, the piece is verified once the last block is stored
+  /// @param piece the piece of this task with the files it is stored in
+  /// @return an error unless the whole piece was stored and is valid
+  [[nodiscard]] util::Outcome<download::downloader::DownloaderError> stream(
+      const Piece& piece, const peer::Peer& peer,
+      storage::StorageBackend& storage);
+};
 
- private:
-  /// Download from a peer
-  [[nodiscard]] bool download(const peer::Peer& peer);
-  /// Save to file
-  [[nodiscard]] bool save() const;
+/// Pieces a sequential torrent needs first, from `first` up to `last`
+/// excluded
+struct SequentialWindow {
+  int64_t first;
+  int64_t last;
+};
+
+/// @return window of a sequential torrent
+/// @param first first piece the consumer cannot read yet
+SequentialWindow sequential_window(const TorrentFile& descriptor,
+                                   int64_t first);
+
+/// Rank of the first task outside the window of a sequential torrent
+const int64_t RANK_UNORDERED = int64_t(1) << 60;
+/// Distance between the ranks of tasks of consecutive priorities outside the
+/// window, more than the pieces of any torrent
+const int64_t RANK_PRIORITY_STRIDE = int64_t(1) << 40;
+
+/// Used by the workers to choose the next task of a torrent, pieces inside
+/// the window of a sequential torrent go first and in order, everything else
+/// comes after by decreasing priority and then in order
+/// @param window window of the torrent if it's sequential
+/// @return rank of the task, lower goes first
+int64_t piece_rank(const std::optional<SequentialWindow>& window,
+                   const PieceTask& task);
+
+/// Pieces of the same torrent form a flow of the task queue, the cost of a
+/// piece is its length so that torrents share bytes rather than pieces
+struct PieceFlow {
+  static TorrentID key(const PieceTask& task) { return task.tid; }
+  static int64_t cost(const PieceTask& task) {
+    return task.descriptor->piece_length;
+  }
+
+  /// Ranks the pieces of a torrent with `piece_rank`
+  struct Rank {
+    /// Window of the torrent if it's sequential
+    std::optional<SequentialWindow> window;
+
+    int64_t operator()(const PieceTask& task) const {
+      return piece_rank(window, task);
+    }
+  };
+};
+
+/// Queue of all the pieces to process, shared fairly between torrents
+using TaskQueue =
+    mt::SharedQueue<PieceTask, policy::FairQueue<PieceTask, PieceFlow>>;
+
+/// Statistics of the failed attempts at pieces
+struct RetryStats {
+  /// Failed attempts of every class so far, indexed by
+  /// `download::retry::Failure`
+  std::array<int64_t, download::retry::FAILURE_CLASSES> failures;
+  /// Pieces waiting before they are attempted again
+  int64_t delayed;
+  /// Pieces set aside until the peers of their torrent change
+  int64_t stalled;
 };
 
 /// Main state of the program
@@ -69,17 +180,64 @@ class Furrent : public Singleton<Furrent> {
   /// Pool managing worker threads
   mt::ThreadGroup<WorkerState> _workers;
   /// All pieces to process
-  mt::SharedQueue<PieceTask> _tasks;
+  TaskQueue _tasks;
+  /// Memory of the pieces being downloaded, shared by all workers
+  download::PieceBufferPool _buffers;
+  /// A downloaded piece verified by the hashing threads, waiting to be saved
+  struct VerifiedPiece {
+    PieceTask task;
+    Piece piece;
+    int64_t peer_index;
+    std::shared_ptr<storage::StorageBackend> storage;
+    download::Downloaded data;
+    bool valid;
+  };
+  /// Threads saving verified pieces, so that neither the hashing threads nor
+  /// the workers wait for the disk
+  mt::Executor _saving;
+  /// Threads verifying downloaded pieces
+  download::HashPool _hashing;
+  /// Torrents waiting to be announced again, either restored with the peers
+  /// of a session snapshot or with pieces none of their peers could provide
+  mt::SharedQueue<TorrentID> _announces;
+  /// Thread announcing torrents again in the background
+  mt::ThreadGroup<util::Empty> _announcer;
+
+  /// A failed task waiting before it is attempted again
+  struct DelayedTask {
+    /// When the task goes back to the workers, in milliseconds of the steady
+    /// clock
+    int64_t due;
+    PieceTask task;
+  };
+  /// Delayed tasks due first are extracted first
+  struct DueRank {
+    int64_t operator()(const DelayedTask& delayed) const {
+      return delayed.due;
+    }
+  };
+
+  /// Protects the delayed and stalled tasks
+  mutable std::mutex _retry_mtx;
+  /// Failed tasks waiting before they are attempted again
+  policy::HeapQueue<DelayedTask, DueRank> _delayed;
+  /// Tasks that spent their retry budget, set aside for every torrent until
+  /// an announce brings different peers
+  std::unordered_map<TorrentID, std::vector<PieceTask>> _stalled;
+  /// Failed attempts of every class
+  download::retry::FailureCounters _failures;
 
   /// Mutex protecting furrent state
   mutable std::shared_mutex _mtx;
   /// All torrent to manage, even those that have been stopped or have errors
   std::unordered_map<TorrentID, Torrent> _torrents;
-  /// Incremental torrent descriptor next id
-  TorrentID _descriptor_next_uid;
+  /// Incremental torrent descriptor next id, torrents are added concurrently
+  std::atomic<TorrentID> _descriptor_next_uid;
 
   /// Filepath of the folder containing all downloaded content
   std::string _download_folder;
+  /// Where the content of torrents added from now on is stored
+  std::shared_ptr<storage::StorageBackend> _storage;
 
  public:
   /// All possible Furrent errors
@@ -97,25 +255,194 @@ class Furrent : public Singleton<Furrent> {
   /// Set the download folder
   Result<Empty> set_download_folder(const std::string& folder);
 
-  /// Begin download of a torrent
+  /// Set where the content of torrents added from now on is stored, torrents
+  /// already added keep their storage
+  void set_storage(std::shared_ptr<storage::StorageBackend> storage);
+
+  /// Begin download of a torrent. Loading, preparing the files and
+  /// announcing to the tracker don't block the workers nor other additions,
+  /// the torrent is locked into the registry only at the end.
   /// @param filename filename of the .torrent file
+  /// @param options how to add the torrent
   /// @return the id of the new torrent
-  Result<TorrentID> add_torrent(const std::string& filename);
+  Result<TorrentID> add_torrent(const std::string& filename,
+                                const TorrentOptions& options = {});
+
+  /// Begin download of all the .torrent files of a folder, many of them are
+  /// added at the same time
+  /// @param folder folder containing the .torrent files
+  /// @param options how to add every torrent
+  /// @return the ids of the torrents added successfully, in alphabetical order
+  /// of their files
+  Result<std::vector<TorrentID>> add_torrents(
+      const std::string& folder, const TorrentOptions& options = {});
 
   /// Removes a torrent descriptor and all of his tasks
   /// @param uid uid of the torrent to remove
   void remove_torrent(TorrentID tid);
 
+  /// Stop downloading a torrent, its pending pieces are set aside and cost
+  /// nothing until the torrent is resumed. Pieces already being downloaded
+  /// are completed.
+  /// @return True if the torrent was downloading and is now paused
+  bool pause_torrent(TorrentID tid);
+
+  /// Download a paused torrent again
+  /// @return True if the torrent was paused and is now downloading
+  bool resume_torrent(TorrentID tid);
+
+  /// Save every torrent that hasn't been removed to a session snapshot, see
+  /// `restore_session`
+  /// @param filepath where the snapshot is written
+  Result<Empty> save_session(const std::string& filepath) const;
+
+  /// Bring back the torrents of a session snapshot, many of them at the same
+  /// time. Nothing is parsed and trackers are announced to again in the
+  /// background, the restored torrents begin with the peers they had when the
+  /// snapshot was taken. Those without peers begin once their tracker
+  /// answers.
+  /// @param filepath where the snapshot is read from
+  /// @return the ids of the torrents restored successfully
+  Result<std::vector<TorrentID>> restore_session(const std::string& filepath);
+
   /// Extract torrents stats
   TorrentGuiData get_gui_data(TorrentID tid) const;
 
+  /// Change how many workers a torrent gets, see `TorrentOptions`
+  /// @param weight share of the workers relative to the other torrents of
+  /// the same priority, must be positive
+  void set_torrent_share(TorrentID tid, int64_t weight,
+                         TorrentPriority priority);
+
+  /// Move the read cursor of a sequential torrent, the pieces right after it
+  /// are downloaded first. The cursor never needs to be moved back before the
+  /// content already downloaded without gaps.
+  /// @param offset offset in bytes from the beginning of the torrent
+  void set_read_cursor(TorrentID tid, int64_t offset);
+
+  /// Statistics of the verification of downloaded pieces
+  download::HashPoolStats get_hashing_stats() const;
+
+  /// Statistics of the failed attempts at pieces
+  RetryStats get_retry_stats() const;
+
  private:
+  /// A torrent going through the stages of its addition
+  struct Admission {
+    /// Identifier reserved for the torrent
+    TorrentID tid;
+    /// Parsed .torrent file descriptor
+    TorrentFile descriptor;
+    /// Priority of every piece
+    std::vector<FilePriority> priorities;
+    /// Pieces already saved to storage, known once the files are prepared
+    std::optional<download::bitfield::Bitfield> completed;
+    /// Where the content of the torrent is stored
+    std::shared_ptr<storage::StorageBackend> storage;
+    /// Persistent record of the pieces saved to disk, may be missing
+    std::shared_ptr<resume::ResumeFile> resume;
+    /// Response of the tracker, missing if it couldn't be reached
+    std::optional<peer::Announce> announce;
+    /// The tracker is asked in the background, without peers the pieces are
+    /// set aside until it answers
+    bool announce_later = false;
+  };
+
+  /// Load and parse a .torrent file, first stage of an addition
+  Result<Admission> load_torrent(const std::string& filename,
+                                 const TorrentOptions& options);
+  /// Find or create the files of a torrent and its resume file
+  /// @param snapshot resume data to use when the resume file is unusable
+  Result<Empty> prepare_torrent(
+      Admission& admission, const TorrentOptions& options,
+      const resume::ResumeData* snapshot = nullptr);
+  /// Announce a torrent to its tracker, can take a long time
+  void announce_torrent(Admission& admission);
+  /// Insert a torrent into the registry and queue its pieces, last stage of
+  /// an addition and the only one holding the lock
+  Result<TorrentID> register_torrent(Admission admission,
+                                     const TorrentOptions& options);
+
   /// Main function of all workers
   void thread_main(mt::Runner runner, WorkerState& state, int64_t index);
 
+  /// Main function of the thread announcing torrents again
+  void announcer_main(mt::Runner runner);
+
+  /// Move the window of a sequential torrent after its read cursor or its
+  /// content readable without gaps changed, the pieces of the torrent are
+  /// ranked again only if the window moved
+  void update_window(const Torrent& torrent);
+
+  /// @return fraction of all the bytes handed to the workers that belonged
+  /// to a torrent
+  double worker_share(TorrentID tid) const;
+
+  /// Called by the saving threads once a downloaded piece has been verified,
+  /// saves
+  /// valid pieces while corrupt ones are attempted again later
+  /// @param piece the piece of the task with the files it is stored in
+  /// @param peer_index index of the peer the piece came from
+  /// @param storage where the content of the torrent is stored
+  void piece_verified(const PieceTask& task, const Piece& piece,
+                      int64_t peer_index, storage::StorageBackend& storage,
+                      const download::Downloaded& data, bool valid);
+  /// Called when an attempt at a piece fails, the task waits longer at every
+  /// failure before it goes back to the workers. Once the budget of the
+  /// class of the failure is spent the task is set aside and its torrent is
+  /// announced again to look for other peers.
+  void task_failed(PieceTask task, download::retry::Failure failure);
+  /// Give the delayed tasks whose wait is over back to the workers
+  /// @return when the next delayed task is due, nothing if there are none
+  std::optional<std::chrono::steady_clock::time_point> release_delayed();
+  /// Give the tasks set aside for a torrent back to the workers with a fresh
+  /// budget, called once an announce brought different peers
+  void release_stalled(TorrentID tid);
+  /// @return True if the torrent has been removed, tasks of a removed
+  /// torrent still in flight must be dropped rather than attempted again
+  bool torrent_removed(TorrentID tid) const;
+
+  /// Called once a piece is valid and stored, updates the progress of its
+  /// torrent
+  /// @param peer_index index of the peer the piece came from
+  /// @param storage where the content of the torrent is stored
+  void piece_completed(const PieceTask& task, int64_t peer_index,
+                       storage::StorageBackend& storage);
+
   /// Prepare all folders and files for a torrent
+  /// @param storage where the content of the torrent is stored
+  /// @param reuse_existing use the content already present in the download
+  /// folder instead of creating a new copy, missing files are still created
+  /// @param priorities priority of every file, all files are wanted if empty
   /// @return True if the operation was a success, false otherwise
-  bool prepare_torrent_files(TorrentFile& descriptor);
+  bool prepare_torrent_files(TorrentFile& descriptor,
+                             storage::StorageBackend& storage,
+                             bool reuse_existing = false,
+                             const std::vector<FilePriority>& priorities = {});
+
+  /// Try to pick up a previous download of the same torrent from its resume
+  /// file, on success the folder name of the descriptor is updated
+  /// @param storage where the content of the torrent is stored, pieces of
+  /// files changed since the resume file was written are verified again
+  /// @param fallback resume data to use when the resume file is unusable
+  /// @return pieces already saved to disk or nothing if there is no usable
+  /// previous download
+  std::optional<download::bitfield::Bitfield> resume_torrent_files(
+      TorrentFile& descriptor, storage::StorageBackend& storage,
+      const resume::ResumeData* fallback = nullptr) const;
+
+  /// Verify the content of a torrent already present in the download folder,
+  /// missing files are created
+  /// @param priorities priority of every file, skipped files are not created
+  /// @return pieces whose content is valid or nothing if the files cannot be
+  /// prepared
+  std::optional<download::bitfield::Bitfield> recheck_torrent_files(
+      TorrentFile& descriptor, storage::StorageBackend& storage,
+      const std::vector<FilePriority>& priorities);
+
+  /// @return Filepath of the resume file of a torrent
+  [[nodiscard]] std::string resume_filepath(
+      const TorrentFile& descriptor) const;
 };
 
 }  // namespace fur
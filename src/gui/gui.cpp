@@ -65,6 +65,10 @@ void Window::set_torrent_insert_fn(torrent_insert_fn fn) {
   _insert_fn = std::move(fn);
 }
 
+void Window::insert_torrent(const TorrentGuiData& torrent) {
+  _scroller.torrents.push_back(torrent);
+}
+
 void Window::set_torrent_update_fn(torrent_update_fn fn) {
   _update_fn = std::move(fn);
 }
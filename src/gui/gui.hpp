@@ -61,6 +61,9 @@ class Window {
   void set_torrent_update_fn(torrent_update_fn fn);
   void set_torrent_remove_fn(torrent_remove_fn fn);
 
+  /// Show a torrent that wasn't added from the file dialog
+  void insert_torrent(const TorrentGuiData& torrent);
+
  private:
   /// Configure window style
   void configure_style();
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "sha1.hpp"
 #include "smallsha1/sha1.hpp"
 #include "spdlog/spdlog.h"
 
@@ -32,20 +33,14 @@ std::string hash_to_hex(const hash_t& hash) {
   return std::string{result, 40};
 }
 
-hash_t compute_info_hash(const std::string& bencoded_info_dict) {
-  if (bencoded_info_dict.length() > static_cast<size_t>(std::numeric_limits<int>::max())) {
-    throw std::invalid_argument("input info dict is too large");
-  }
-  // smallsha1 uses int for the length
-  int len = static_cast<int>(bencoded_info_dict.length());
-
-  hash_t buffer;
-  sha1::calc(bencoded_info_dict.data(), len, buffer.begin());
-  return buffer;
+hash_t compute_info_hash(std::string_view bencoded_info_dict) {
+  return Sha1::digest(
+      reinterpret_cast<const uint8_t*>(bencoded_info_dict.data()),
+      static_cast<int64_t>(bencoded_info_dict.length()));
 }
 
 util::Result<std::vector<hash_t>, HashError> split_piece_hashes(
-    const std::string& piece_hashes_str) {
+    std::string_view piece_hashes_str) {
   using Result = util::Result<std::vector<hash_t>, HashError>;
 
   if (piece_hashes_str.length() > static_cast<size_t>(std::numeric_limits<int64_t>::max())) {
@@ -56,6 +51,7 @@ util::Result<std::vector<hash_t>, HashError> split_piece_hashes(
   auto s_len = static_cast<int64_t>(piece_hashes_str.length());
 
   std::vector<hash_t> result;
+  result.reserve(s_len / 20);
   // Forced to use unsigned because that's what "std::string::length" returns
   // even though signed integers are generally the better idea for iterator
   // variables
@@ -77,15 +73,29 @@ util::Result<std::vector<hash_t>, HashError> split_piece_hashes(
 }
 
 bool verify_piece(const std::vector<uint8_t>& piece, hash_t hash) {
-  if (piece.size() > static_cast<size_t>(std::numeric_limits<int>::max())) {
+  if (piece.size() > static_cast<size_t>(std::numeric_limits<int64_t>::max())) {
     throw std::invalid_argument("piece is too big");
   }
-  // smallsha1 uses int for the length
-  int len = static_cast<int>(piece.size());
+  return verify_piece(piece.data(), static_cast<int64_t>(piece.size()), hash);
+}
+
+bool verify_piece(const uint8_t* piece, int64_t len, const hash_t& hash) {
+  return Sha1::digest(piece, len) == hash;
+}
+
+std::vector<bool> verify_pieces(const std::vector<PieceView>& pieces) {
+  std::vector<Message> messages;
+  messages.reserve(pieces.size());
+  for (const auto& piece : pieces) messages.push_back({piece.data, piece.len});
+
+  std::vector<hash_t> hashes(pieces.size());
+  digest_batch(messages.data(), static_cast<int64_t>(messages.size()),
+               hashes.data());
 
-  hash_t buffer;
-  sha1::calc(piece.data(), len, buffer.begin());
-  return buffer == hash;
+  std::vector<bool> valid(pieces.size());
+  for (size_t i = 0; i < pieces.size(); i++)
+    valid[i] = hashes[i] == *pieces[i].hash;
+  return valid;
 }
 
 }  // namespace fur::hash
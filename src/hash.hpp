@@ -3,6 +3,7 @@
 #include <array>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "util/result.hpp"
@@ -28,13 +29,28 @@ std::string hash_to_str(const hash_t& hash);
 std::string hash_to_hex(const hash_t& hash);
 
 /// Computes the info hash given a bencoded string for the .torrent info dict
-hash_t compute_info_hash(const std::string& bencoded_info_dict);
+hash_t compute_info_hash(std::string_view bencoded_info_dict);
 
 /// Takes a string with the hashes of pieces from a torrent file and parses
 /// them into a vector of "hash_t". Each hash is 20 bytes long
 util::Result<std::vector<hash_t>, HashError> split_piece_hashes(
-    const std::string& pieces);
+    std::string_view pieces);
 
 /// Checks that a downloaded piece matches the provided hash
 bool verify_piece(const std::vector<uint8_t>& piece, hash_t hash);
+
+/// Checks that a piece stored in a raw buffer matches the provided hash
+bool verify_piece(const uint8_t* piece, int64_t len, const hash_t& hash);
+
+/// A piece stored in a raw buffer along with its expected hash
+struct PieceView {
+  const uint8_t* data;
+  int64_t len;
+  const hash_t* hash;
+};
+
+/// Checks many pieces at once, faster than calling "verify_piece" for each of
+/// them because pieces are hashed in parallel in the lanes of vector registers
+/// @return for every piece, true if it matches its hash
+std::vector<bool> verify_pieces(const std::vector<PieceView>& pieces);
 }  // namespace fur::hash
@@ -2,6 +2,7 @@
 #include <furrent.hpp>
 #include <gui/gui.hpp>
 #include <log/logger.hpp>
+#include <platform/io.hpp>
 #include <stdexcept>
 
 using namespace fur;
@@ -24,6 +25,19 @@ int main(int, char* argv[]) {
 
   fur::gui::Window window("Furrent", 800, 600);
 
+  // Bring back the torrents of the last session
+  const std::string session_filepath = path_base +
+                                       fur::config::DOWNLOAD_FOLDER + '/' +
+                                       fur::config::SESSION_FILE;
+  auto session_exists = fur::platform::io::exists(session_filepath);
+  if (session_exists.valid() && *session_exists) {
+    auto restored = furrent.restore_session(session_filepath);
+    if (restored.valid()) {
+      for (TorrentID tid : *restored)
+        window.insert_torrent(furrent.get_gui_data(tid));
+    }
+  }
+
   window.set_torrent_insert_fn(
       [&](const std::string& filepath,
           const std::string&) -> std::optional<TorrentGuiData> {
@@ -43,4 +57,12 @@ int main(int, char* argv[]) {
   });
 
   window.run();
+
+  auto session_dirpath = fur::platform::io::create_directories(
+      path_base + fur::config::DOWNLOAD_FOLDER + '/' +
+      fur::config::RESUME_FOLDER);
+  if (!session_dirpath.valid() ||
+      !furrent.save_session(session_filepath).valid()) {
+    logger->error("Unable to save the session to {}", session_filepath);
+  }
 }
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <mt/executor.hpp>
+#include <random>
+#include <stdexcept>
+
+namespace fur::mt {
+
+/// Executor owning the current thread, if any
+static thread_local const Executor* current_executor = nullptr;
+/// Index of the current thread inside its executor
+static thread_local int64_t current_index = 0;
+
+Executor::Executor(int64_t threads)
+    : _queued{0},
+      _pending{0},
+      _stopping{false},
+      _next_worker{0},
+      _parked{0} {
+  if (threads < 0) {
+    throw std::invalid_argument("expected positive number of threads");
+  }
+
+  int64_t threads_cnt = std::thread::hardware_concurrency();
+  if (threads_cnt <= 0) threads_cnt = 1;
+  if (threads != 0) threads_cnt = threads;
+
+  for (int64_t i = 0; i < threads_cnt; i++)
+    _workers.push_back(std::make_unique<Worker>());
+  for (int64_t i = 0; i < threads_cnt; i++)
+    _threads.emplace_back([this, i] { thread_main(i); });
+}
+
+Executor::~Executor() { shutdown(); }
+
+void Executor::submit(Job job) {
+  if (_stopping.load(std::memory_order_acquire)) return;
+
+  const bool inside = current_executor == this;
+  const int64_t index =
+      inside ? current_index
+             : _next_worker.fetch_add(1, std::memory_order_relaxed) %
+                   thread_count();
+
+  _pending.fetch_add(1, std::memory_order_relaxed);
+  {
+    Worker& worker = *_workers[index];
+    std::scoped_lock<std::mutex> lock(worker.mutex);
+    worker.jobs.push_back(std::move(job));
+  }
+  // Must be ordered before reading the number of parked threads, see `park`
+  _queued.fetch_add(1, std::memory_order_seq_cst);
+  unpark();
+}
+
+void Executor::wait_idle() {
+  std::unique_lock<std::mutex> lock(_park_mutex);
+  _idle.wait(lock, [&] {
+    return _stopping.load(std::memory_order_acquire) ||
+           _pending.load(std::memory_order_acquire) == 0;
+  });
+}
+
+void Executor::shutdown() {
+  {
+    std::scoped_lock<std::mutex> lock(_park_mutex);
+    if (_stopping.exchange(true)) return;
+  }
+  _job_available.notify_all();
+  _idle.notify_all();
+  for (auto& thread : _threads) thread.join();
+
+  for (auto& worker : _workers) {
+    std::scoped_lock<std::mutex> lock(worker->mutex);
+    worker->jobs.clear();
+  }
+}
+
+int64_t Executor::thread_count() const {
+  return static_cast<int64_t>(_workers.size());
+}
+
+void Executor::thread_main(int64_t index) {
+  current_executor = this;
+  current_index = index;
+
+  Job job;
+  while (!_stopping.load(std::memory_order_acquire)) {
+    if (!pop(index, job) && !steal(index, job)) {
+      park();
+      continue;
+    }
+
+    job();
+    job = nullptr;
+
+    if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // Taking the lock orders the notification after the check of waiters
+      std::scoped_lock<std::mutex> lock(_park_mutex);
+      _idle.notify_all();
+    }
+  }
+}
+
+bool Executor::pop(int64_t index, Job& job) {
+  Worker& worker = *_workers[index];
+  std::scoped_lock<std::mutex> lock(worker.mutex);
+  if (worker.jobs.empty()) return false;
+
+  job = std::move(worker.jobs.back());
+  worker.jobs.pop_back();
+  _queued.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool Executor::steal(int64_t index, Job& job) {
+  thread_local std::minstd_rand gen(std::random_device{}());
+  const int64_t count = thread_count();
+  if (count <= 1) return false;
+
+  std::uniform_int_distribution<int64_t> victims(0, count - 1);
+  const int64_t first = victims(gen);
+  for (int64_t i = 0; i < count; i++) {
+    const int64_t victim = (first + i) % count;
+    if (victim == index) continue;
+
+    Worker& worker = *_workers[victim];
+    std::scoped_lock<std::mutex> lock(worker.mutex);
+    if (worker.jobs.empty()) continue;
+
+    job = std::move(worker.jobs.front());
+    worker.jobs.pop_front();
+    _queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void Executor::park() {
+  std::unique_lock<std::mutex> lock(_park_mutex);
+  // Announcing the parking before checking for jobs means that a submission
+  // either sees this thread parked or is seen by it
+  _parked.fetch_add(1, std::memory_order_seq_cst);
+  _job_available.wait(lock, [&] {
+    return _stopping.load(std::memory_order_acquire) ||
+           _queued.load(std::memory_order_seq_cst) > 0;
+  });
+  _parked.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Executor::unpark() {
+  if (_parked.load(std::memory_order_seq_cst) == 0) return;
+
+  // The lock can't be taken while a thread is between its check and its
+  // wait, so the notification is never lost
+  { std::scoped_lock<std::mutex> lock(_park_mutex); }
+  _job_available.notify_one();
+}
+
+}  // namespace fur::mt
@@ -0,0 +1,105 @@
+/**
+ * @file executor.hpp
+ * @brief Work-stealing pool of threads for independent jobs
+ * @version 0.1
+ * @date 2022-10-19
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fur::mt {
+
+/// Pool of threads executing independent jobs. Every thread has its own
+/// deque of jobs, so that threads don't contend on a single queue: a thread
+/// takes the newest job of its own deque and when it runs out steals the
+/// oldest job of another thread chosen at random. Threads with nothing to do
+/// park, every submission wakes up at most one of them.
+class Executor {
+ public:
+  /// A job to execute, must not throw
+  using Job = std::function<void()>;
+
+ private:
+  /// Jobs of a single thread, the owner works on the back and thieves steal
+  /// from the front so they rarely meet on the same lock
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  /// One deque per thread
+  std::vector<std::unique_ptr<Worker>> _workers;
+  /// Jobs waiting in any deque
+  std::atomic_int64_t _queued;
+  /// Jobs submitted and not yet completed
+  std::atomic_int64_t _pending;
+  /// True once the executor is shutting down
+  std::atomic_bool _stopping;
+  /// Deque receiving the next job submitted from outside the pool
+  std::atomic_int64_t _next_worker;
+
+  /// Protects parking and the wait for idleness
+  std::mutex _park_mutex;
+  /// Signals parked threads that a job is available
+  std::condition_variable _job_available;
+  /// Signals that every submitted job has been completed
+  std::condition_variable _idle;
+  /// Threads parked right now
+  std::atomic_int64_t _parked;
+
+  /// Threads executing the jobs, must be the last member so that they are
+  /// started once the rest of the state is ready
+  std::vector<std::thread> _threads;
+
+ public:
+  /// @param threads number of threads, 0 means one per core
+  explicit Executor(int64_t threads = 0);
+  /// Stops the executor, see `shutdown`
+  ~Executor();
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  /// Queue a job. Jobs submitted from a thread of the pool go to its own
+  /// deque, the others are spread over all deques. After the executor has
+  /// been shut down the job is dropped.
+  void submit(Job job);
+
+  /// Wait until every submitted job has been completed
+  void wait_idle();
+
+  /// Stop all threads once their current job is done, jobs still in the
+  /// deques are dropped
+  void shutdown();
+
+  /// @return number of threads of the pool
+  [[nodiscard]] int64_t thread_count() const;
+
+ private:
+  /// Main function of the threads
+  void thread_main(int64_t index);
+
+  /// Take a job from the back of a deque of this pool
+  /// @return True if a job was found
+  bool pop(int64_t index, Job& job);
+  /// Take a job from the front of the deque of another thread, victims are
+  /// visited starting from a random one
+  /// @return True if a job was found
+  bool steal(int64_t index, Job& job);
+  /// Sleep until a job is available or the executor is shutting down
+  void park();
+  /// Wake up a parked thread, if any
+  void unpark();
+};
+
+}  // namespace fur::mt
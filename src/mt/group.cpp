@@ -2,12 +2,11 @@
 
 namespace fur::mt {
 
-Runner::Runner(std::mutex& mutex, bool& should_terminate)
-    : _mutex{mutex}, _should_terminate{should_terminate} {}
+Runner::Runner(const std::atomic_bool& should_terminate)
+    : _should_terminate{should_terminate} {}
 
 bool Runner::alive() {
-  std::scoped_lock<std::mutex> lock(_mutex);
-  return !_should_terminate;
+  return !_should_terminate.load(std::memory_order_acquire);
 }
 
 }  // namespace fur::mt
\ No newline at end of file
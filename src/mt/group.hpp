@@ -7,8 +7,8 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
-#include <mutex>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -17,13 +17,12 @@ namespace fur::mt {
 
 /// Used to control threads execution
 class Runner {
-  /// Protects terminate status
-  std::mutex& _mutex;
-  /// True if the threads need to be joined
-  bool& _should_terminate;
+  /// True if the threads need to be joined, checked on every iteration of
+  /// the workers so it's never behind a lock
+  const std::atomic_bool& _should_terminate;
 
  public:
-  Runner(std::mutex& mutex, bool& _should_terminate);
+  explicit Runner(const std::atomic_bool& should_terminate);
 
   /// True if threads should continue executing
   bool alive();
@@ -43,10 +42,8 @@ class ThreadGroup {
   std::vector<State> _states;
   /// Function running on workers
   ThreadFn _thread_fn;
-  /// Protects terminate status
-  std::mutex _mutex;
   /// True if the threads need to be joined
-  bool _should_terminate;
+  std::atomic_bool _should_terminate;
 
  public:
   /// Create disabled thread group
@@ -55,7 +52,7 @@ class ThreadGroup {
   virtual ~ThreadGroup();
 
   //===========================================================================
-  // This object is not copyable and not movable because of the mutex
+  // This object is not copyable and not movable because of the threads
 
   ThreadGroup(ThreadGroup&) = delete;
   ThreadGroup& operator=(ThreadGroup&) = delete;
@@ -31,14 +31,12 @@ void ThreadGroup<State>::launch(ThreadFn fn, int64_t max_worker_threads) {
 template <typename State>
 void ThreadGroup<State>::thread_main(int64_t index) {
   State& state = _states.at(index);
-  _thread_fn(Runner(_mutex, _should_terminate), state, index);
+  _thread_fn(Runner(_should_terminate), state, index);
 }
 
 template <typename State>
 void ThreadGroup<State>::terminate() {
-  _mutex.lock();
-  _should_terminate = true;
-  _mutex.unlock();
+  _should_terminate.store(true, std::memory_order_release);
 
   for (auto& thread : _threads) thread.join();
 }
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mt/parallel.hpp>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace fur::mt {
+
+void parallel_for(int64_t count, const std::function<void(int64_t)>& fn,
+                  int64_t max_threads) {
+  if (count < 0) throw std::invalid_argument("expected positive job count");
+  if (max_threads < 0) {
+    throw std::invalid_argument("expected positive number of threads");
+  }
+  if (count == 0) return;
+
+  int64_t threads_cnt = std::thread::hardware_concurrency();
+  if (threads_cnt <= 0) threads_cnt = 1;
+  if (max_threads != 0) threads_cnt = std::min(threads_cnt, max_threads);
+  threads_cnt = std::min(threads_cnt, count);
+
+  std::atomic_int64_t next{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto worker = [&] {
+    int64_t index;
+    while ((index = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+      try {
+        fn(index);
+      } catch (...) {
+        std::scoped_lock<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+        // Stop handing out new jobs
+        next.store(count, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  // The calling thread takes part in the work too
+  std::vector<std::thread> threads;
+  threads.reserve(threads_cnt - 1);
+  for (int64_t i = 1; i < threads_cnt; i++) threads.emplace_back(worker);
+  worker();
+
+  for (auto& thread : threads) thread.join();
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace fur::mt
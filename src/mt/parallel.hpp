@@ -0,0 +1,25 @@
+/**
+ * @file parallel.hpp
+ * @brief Short-lived data parallelism for one-off batches of independent jobs
+ * @version 0.1
+ * @date 2022-10-19
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace fur::mt {
+
+/// Calls `fn` once for every index in [0, count) spreading the calls over a
+/// group of temporary threads. Indices are handed out one at a time so that
+/// uneven jobs stay balanced. Returns once every call has completed, if any
+/// call throws the first exception is rethrown on the calling thread.
+/// @param count number of jobs to execute
+/// @param fn job to execute, receives the job index
+/// @param max_threads maximum number of threads to use, 0 means one per core
+void parallel_for(int64_t count, const std::function<void(int64_t)>& fn,
+                  int64_t max_threads = 0);
+
+}  // namespace fur::mt
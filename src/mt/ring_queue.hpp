@@ -0,0 +1,84 @@
+/**
+ * @file ring_queue.hpp
+ * @brief Lock-free bounded queue for many producers and many consumers
+ * @version 0.1
+ * @date 2022-10-19
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace fur::mt {
+
+/// Size of a cache line, counters written by different threads are kept
+/// this far apart so that they don't invalidate each other
+const size_t CACHE_LINE_BYTES = 64;
+
+/// Bounded FIFO queue that any number of threads can push to and pop from
+/// without locks. Items live in a ring of slots, every slot has a sequence
+/// number telling whether it's ready to be written or read for the current
+/// lap around the ring, so producers and consumers only race on their own
+/// position counter (D. Vyukov's bounded MPMC queue).
+/// Unlike `SharedQueue` items can only be extracted in FIFO order and nobody
+/// ever waits, a full queue rejects new items and an empty one returns
+/// nothing.
+/// The ring is not offered as a backend of `SharedQueue`: that queue extracts
+/// by policy, sleeps under its mutex and never rejects an item, so behind it
+/// the ring would lose everything that makes it faster. Code that can live
+/// with FIFO order and a fixed capacity, like `download::HashPool`, uses the
+/// ring directly and decides on its own how to wait.
+template <typename T>
+class RingQueue {
+  /// A single item of the ring
+  struct alignas(CACHE_LINE_BYTES) Slot {
+    /// Position the slot can be written at, or read at when one higher
+    std::atomic_size_t sequence;
+    /// Content of the slot, constructed only while the slot holds an item
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  /// Number of slots, always a power of two
+  size_t _capacity;
+  /// Used instead of a modulo to find the slot of a position
+  size_t _mask;
+  std::unique_ptr<Slot[]> _slots;
+
+  /// Position of the next item to push
+  alignas(CACHE_LINE_BYTES) std::atomic_size_t _push_pos;
+  /// Position of the next item to pop
+  alignas(CACHE_LINE_BYTES) std::atomic_size_t _pop_pos;
+
+ public:
+  /// @param capacity maximum number of items, rounded up to a power of two
+  explicit RingQueue(int64_t capacity);
+  /// Destroys the items still in the queue
+  ~RingQueue();
+
+  RingQueue(const RingQueue&) = delete;
+  RingQueue& operator=(const RingQueue&) = delete;
+
+  /// Insert an item at the back of the queue
+  /// @return True on success, false if the queue is full and the item has
+  /// not been moved from
+  [[nodiscard]] bool try_push(T&& item);
+
+  /// Extract the item at the front of the queue
+  /// @return the item or nothing if the queue is empty
+  [[nodiscard]] std::optional<T> try_pop();
+
+  /// @return maximum number of items
+  [[nodiscard]] int64_t capacity() const;
+
+  /// @return number of items in the queue, only a hint while other threads
+  /// are using it
+  [[nodiscard]] int64_t size() const;
+};
+
+}  // namespace fur::mt
+
+#include <mt/ring_queue.inl>
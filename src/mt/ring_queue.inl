@@ -0,0 +1,96 @@
+#include <mt/ring_queue.hpp>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace fur::mt {
+
+template <typename T>
+RingQueue<T>::RingQueue(int64_t capacity) : _push_pos{0}, _pop_pos{0} {
+  if (capacity <= 0) throw std::invalid_argument("capacity must be positive");
+
+  _capacity = 1;
+  while (_capacity < static_cast<size_t>(capacity)) _capacity *= 2;
+  _mask = _capacity - 1;
+
+  _slots = std::make_unique<Slot[]>(_capacity);
+  for (size_t i = 0; i < _capacity; i++)
+    _slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+RingQueue<T>::~RingQueue() {
+  while (try_pop().has_value()) {
+  }
+}
+
+template <typename T>
+bool RingQueue<T>::try_push(T&& item) {
+  size_t pos = _push_pos.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = _slots[pos & _mask];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::ptrdiff_t>(sequence) -
+                      static_cast<std::ptrdiff_t>(pos);
+
+    if (diff == 0) {
+      // The slot is free for this lap, claim it
+      if (_push_pos.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed)) {
+        new (slot.storage) T(std::move(item));
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the item of the previous lap
+      return false;
+    } else {
+      // Another producer claimed the slot first
+      pos = _push_pos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+std::optional<T> RingQueue<T>::try_pop() {
+  size_t pos = _pop_pos.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = _slots[pos & _mask];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::ptrdiff_t>(sequence) -
+                      static_cast<std::ptrdiff_t>(pos + 1);
+
+    if (diff == 0) {
+      // The slot holds an item for this lap, claim it
+      if (_pop_pos.compare_exchange_weak(pos, pos + 1,
+                                         std::memory_order_relaxed)) {
+        T* stored = std::launder(reinterpret_cast<T*>(slot.storage));
+        std::optional<T> item(std::move(*stored));
+        stored->~T();
+        // The slot is free again for the next lap
+        slot.sequence.store(pos + _capacity, std::memory_order_release);
+        return item;
+      }
+    } else if (diff < 0) {
+      // Nothing was pushed to the slot yet
+      return std::nullopt;
+    } else {
+      // Another consumer claimed the slot first
+      pos = _pop_pos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+int64_t RingQueue<T>::capacity() const {
+  return static_cast<int64_t>(_capacity);
+}
+
+template <typename T>
+int64_t RingQueue<T>::size() const {
+  const size_t push = _push_pos.load(std::memory_order_relaxed);
+  const size_t pop = _pop_pos.load(std::memory_order_relaxed);
+  return push > pop ? static_cast<int64_t>(push - pop) : 0;
+}
+
+}  // namespace fur::mt
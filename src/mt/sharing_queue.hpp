@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
@@ -22,10 +23,11 @@ namespace fur::mt {
 
 /// Wrapper of policy::Queue to make it thread-safe
 /// and add concurrency related functionalities
-template <typename T>
+/// @tparam Q inner queue, any queue with the same interface of policy::Queue
+template <typename T, typename Q = policy::Queue<T>>
 class SharedQueue {
   /// Contains all work that can be executed
-  policy::Queue<T> _work;
+  Q _work;
 
   /// Protects internal state and CVs
   mutable std::mutex _mutex;
@@ -33,16 +35,21 @@ class SharedQueue {
   mutable std::condition_variable _new_work_available;
   /// Signal the dispatch of all available work
   mutable std::condition_variable _all_work_dispatched;
+  /// Number of threads sleeping in `wait_work`
+  mutable int64_t _waiting;
   /// True if waiting threads should be woken up
   bool _skip_waiting;
+  /// True if the next thread waiting for work must return right away, see
+  /// `wake_one`
+  mutable bool _wake_pending;
 
  public:
   // Error are the same of the queue
-  using Error = typename policy::Queue<T>::Error;
+  using Error = typename Q::Error;
   using Result = util::Result<T, Error>;
 
   // Function used to mutate the internal collection
-  using MutateFn = typename policy::Queue<T>::MutateFn;
+  using MutateFn = typename Q::MutateFn;
 
  public:
   SharedQueue();
@@ -51,31 +58,60 @@ class SharedQueue {
   /// @param policy policy used to extract the element
   [[nodiscard]] Result try_extract(const policy::IPolicy<T>& policy);
 
-  /// Insert new work in the internal list
+  /// Tries to extract work from an inner queue that chooses the element by
+  /// itself, such as policy::FairQueue
+  [[nodiscard]] Result try_extract();
+
+  /// Insert new work in the internal list, a single sleeping thread is woken
+  /// up to take it
   /// @param work Work to be inserted
   void insert(T&& work);
 
-  /// Construct an insert a new work in the internal list
+  /// Construct an insert a new work in the internal list, a single sleeping
+  /// thread is woken up to take it
   /// @param ...args args used in the constructor of work
   template <typename... Args>
   void emplace(Args&&... args);
 
-  /// Mutates the internal list of items in a locked way
-  /// then signals all sleeping threads
+  /// Mutates the internal list of items in a locked way. Mutations can only
+  /// change or remove items, so no thread waiting for work is woken up.
   void mutate(MutateFn mutation);
 
+  /// Run a function on the inner queue in a locked way, no thread waiting
+  /// for work is woken up
+  template <typename Fn>
+  auto access(Fn&& fn);
+  template <typename Fn>
+  auto access(Fn&& fn) const;
+
   /// Wake up all waiting threads
   void force_wakeup();
 
+  /// Wake up a single waiting thread even if no work was inserted, for
+  /// example because work kept elsewhere became due. If no thread is
+  /// waiting, the next one to wait returns right away instead.
+  void wake_one();
+
   /// Wait for a new item in the queue
   void wait_work() const;
 
+  /// Wait for a new item in the queue, but no longer than a deadline
+  template <typename Clock, typename Duration>
+  void wait_work_until(
+      const std::chrono::time_point<Clock, Duration>& deadline) const;
+
   /// Wait for the queue to be empty
   void wait_empty() const;
 
   /// Wake up all waiting threads and begins
   /// skipping work
   void begin_skip_waiting();
+
+ private:
+  /// Extract from the inner queue in a locked way
+  /// @param extract called with the inner queue, returns the extracted item
+  template <typename Fn>
+  Result extract_locked(Fn&& extract);
 };
 
 }  // namespace fur::mt
@@ -2,17 +2,31 @@
 
 namespace fur::mt {
 
-template <typename Work>
-SharedQueue<Work>::SharedQueue() : _skip_waiting{false} {}
+template <typename T, typename Q>
+SharedQueue<T, Q>::SharedQueue()
+    : _waiting{0}, _skip_waiting{false}, _wake_pending{false} {}
 
-template <typename Work>
-auto SharedQueue<Work>::try_extract(const policy::IPolicy<Work>& policy)
+template <typename T, typename Q>
+auto SharedQueue<T, Q>::try_extract(const policy::IPolicy<T>& policy)
     -> Result {
+  return extract_locked([&](Q& work) { return work.extract(policy); });
+}
+
+template <typename T, typename Q>
+auto SharedQueue<T, Q>::try_extract() -> Result {
+  return extract_locked([](Q& work) { return work.extract(); });
+}
+
+template <typename T, typename Q>
+template <typename Fn>
+auto SharedQueue<T, Q>::extract_locked(Fn&& extract) -> Result {
   bool work_empty = false;
 
   _mutex.lock();
-  auto result = _work.extract(policy);
-  if (_work.size() == 0) work_empty = true;
+  auto result = extract(_work);
+  // Only the extraction taking the last item signals, failed extractions
+  // from an empty queue don't
+  if (result.valid() && _work.size() == 0) work_empty = true;
   _mutex.unlock();
 
   if (work_empty) _all_work_dispatched.notify_all();
@@ -20,41 +34,95 @@ auto SharedQueue<Work>::try_extract(const policy::IPolicy<Work>& policy)
   return result;
 }
 
-template <typename T>
-void SharedQueue<T>::insert(T&& work) {
+template <typename T, typename Q>
+void SharedQueue<T, Q>::insert(T&& work) {
+  bool waiting = false;
   {
     std::unique_lock<std::mutex> lock(_mutex);
     _work.insert(std::forward<T>(work));
+    waiting = _waiting > 0;
   }
-  _new_work_available.notify_all();
+  // One item can only be taken by one thread
+  if (waiting) _new_work_available.notify_one();
 }
 
-template <typename T>
+template <typename T, typename Q>
 template <typename... Args>
-void SharedQueue<T>::emplace(Args&&... args) {
+void SharedQueue<T, Q>::emplace(Args&&... args) {
+  bool waiting = false;
   {
     std::unique_lock<std::mutex> lock(_mutex);
     _work.emplace(std::forward<Args>(args)...);
+    waiting = _waiting > 0;
   }
-  _new_work_available.notify_all();
+  // One item can only be taken by one thread
+  if (waiting) _new_work_available.notify_one();
 }
 
-template <typename T>
-void SharedQueue<T>::force_wakeup() {
+template <typename T, typename Q>
+template <typename Fn>
+auto SharedQueue<T, Q>::access(Fn&& fn) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return fn(_work);
+}
+
+template <typename T, typename Q>
+template <typename Fn>
+auto SharedQueue<T, Q>::access(Fn&& fn) const {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return fn(_work);
+}
+
+template <typename T, typename Q>
+void SharedQueue<T, Q>::force_wakeup() {
   _new_work_available.notify_all();
 }
 
-template <typename T>
-void SharedQueue<T>::wait_work() const {
+template <typename T, typename Q>
+void SharedQueue<T, Q>::wake_one() {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _wake_pending = true;
+  }
+  _new_work_available.notify_one();
+}
+
+template <typename T, typename Q>
+void SharedQueue<T, Q>::wait_work() const {
   std::unique_lock<std::mutex> lock(_mutex);
-  if (_skip_waiting || _work.size() != 0) return;
+  if (_skip_waiting || _work.size() != 0 || _wake_pending) {
+    _wake_pending = false;
+    return;
+  }
 
-  _new_work_available.wait(
-      lock, [this] { return _work.size() != 0 || _skip_waiting; });
+  _waiting += 1;
+  _new_work_available.wait(lock, [this] {
+    return _work.size() != 0 || _skip_waiting || _wake_pending;
+  });
+  _waiting -= 1;
+  _wake_pending = false;
 }
 
-template <typename T>
-void SharedQueue<T>::wait_empty() const {
+template <typename T, typename Q>
+template <typename Clock, typename Duration>
+void SharedQueue<T, Q>::wait_work_until(
+    const std::chrono::time_point<Clock, Duration>& deadline) const {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_skip_waiting || _work.size() != 0 || _wake_pending) {
+    _wake_pending = false;
+    return;
+  }
+
+  _waiting += 1;
+  _new_work_available.wait_until(lock, deadline, [this] {
+    return _work.size() != 0 || _skip_waiting || _wake_pending;
+  });
+  _waiting -= 1;
+  _wake_pending = false;
+}
+
+template <typename T, typename Q>
+void SharedQueue<T, Q>::wait_empty() const {
   std::unique_lock<std::mutex> lock(_mutex);
   if (_skip_waiting || _work.size() == 0) return;
 
@@ -62,17 +130,19 @@ void SharedQueue<T>::wait_empty() const {
       lock, [this] { return _work.size() == 0 || _skip_waiting; });
 }
 
-template <typename T>
-void SharedQueue<T>::mutate(MutateFn mutation) {
+template <typename T, typename Q>
+void SharedQueue<T, Q>::mutate(MutateFn mutation) {
+  bool work_empty = false;
   {
     std::unique_lock<std::mutex> lock(_mutex);
     _work.mutate(mutation);
+    work_empty = _work.size() == 0;
   }
-  force_wakeup();
+  if (work_empty) _all_work_dispatched.notify_all();
 }
 
-template <typename T>
-void SharedQueue<T>::begin_skip_waiting() {
+template <typename T, typename Q>
+void SharedQueue<T, Q>::begin_skip_waiting() {
   {
     std::unique_lock<std::mutex> lock(_mutex);
     _skip_waiting = true;
@@ -3,9 +3,9 @@
 #include <memory>
 #include <regex>
 #include <stdexcept>
+#include <string_view>
 
-#include "bencode/bencode_parser.hpp"
-#include "bencode/bencode_value.hpp"
+#include "bencode/bencode_cursor.hpp"
 #include "cpr/cpr.h"
 #include "fmt/core.h"
 #include "hash.hpp"
@@ -40,7 +40,7 @@ Peer::Peer(const std::string& ip_s, uint16_t port) : ip{0}, port{port} {
 }
 
 // Forward declare
-PeerResult parse_tracker_response(const std::string& text);
+PeerResult parse_tracker_response(std::string_view text);
 
 PeerResult announce(const TorrentFile& torrent_f) {
   auto res = cpr::Get(cpr::Url{torrent_f.announce_url},
@@ -62,24 +62,30 @@ PeerResult announce(const TorrentFile& torrent_f) {
   return parse_tracker_response(res.text);
 }
 
-PeerResult parse_tracker_response(const std::string& text) {
+PeerResult parse_tracker_response(std::string_view text) {
   Announce result;
 
-  bencode::BencodeParser parser;
-  auto tree = parser.decode(text);
-  if (!tree.valid()) {
+  // Only the two fields we need are decoded, in place
+  bencode::BencodeCursor response(text);
+  auto interval = response.find_int("interval");
+  auto peers = response.find_string("peers");
+  if (!interval.valid() || !peers.valid()) {
     auto logger = spdlog::get("custom");
     logger->error("Bencode parser error: {}",
-                  fur::bencode::error_to_string(tree.error()));
+                  fur::bencode::error_to_string(
+                      !interval.valid() ? interval.error() : peers.error()));
     return PeerResult::ERROR(PeerError::ParserError);
   }
-  auto& dict = dynamic_cast<bencode::BencodeDict&>(*(*tree)).value();
-
-  auto& interval = dynamic_cast<bencode::BencodeInt&>(*dict.at("interval"));
-  result.interval = interval.value();
+  if (peers->size() % 6 != 0) {
+    auto logger = spdlog::get("custom");
+    logger->error("Compact peers list of {} bytes", peers->size());
+    return PeerResult::ERROR(PeerError::ParserError);
+  }
+  result.interval = *interval;
 
-  auto& peers = dynamic_cast<bencode::BencodeString&>(*dict.at("peers"));
-  for (auto it = peers.value().begin(); it < peers.value().end(); it += 6) {
+  // Six bytes for every peer
+  result.peers.reserve(peers->size() / 6);
+  for (auto it = peers->begin(); it < peers->end();) {
     // Each byte is an octet
     uint32_t ip = 0;
     ip |= *(it++) << 24;
@@ -1,36 +1,64 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
 #include <fstream>
-#include <limits>
 #include <platform/io.hpp>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 
 namespace fur::platform::io {
 
-IOResult<Empty> touch(const std::string& filename, int64_t size) {
-  // Check if the file already exists
-  auto existence = exists(filename);
-  if (!existence.valid()) return IOResult<Empty>::ERROR(IOError::GenericError);
-
-  // If file already exists then something is wrong
-  if (*existence) return IOResult<Empty>::ERROR(IOError::FileAlreadyExists);
+IOResult<Empty> touch(const std::string& filename, int64_t size,
+                      Preallocation mode) {
+  if (size < 0) throw std::invalid_argument("negative file size");
 
-  std::ofstream stream;
-  stream.open(filename, std::ios::binary | std::ios::out);
-  if (!stream.good() || !stream.is_open()) {
+  // O_EXCL makes the existence check and the creation a single atomic step
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                  0644);
+  if (fd < 0) {
+    if (errno == EEXIST)
+      return IOResult<Empty>::ERROR(IOError::FileAlreadyExists);
     return IOResult<Empty>::ERROR(IOError::GenericError);
   }
 
-  if (size == 0) {
-    throw std::invalid_argument("empty file");
+  // Both calls leave the content zeroed, no stray byte is written
+  int error = 0;
+  if (size > 0) {
+    switch (mode) {
+      case Preallocation::None:
+        break;
+      case Preallocation::Sparse:
+        if (::ftruncate(fd, size) != 0) error = errno;
+        break;
+      case Preallocation::Full:
+        // Returns the error code instead of setting errno
+        error = ::posix_fallocate(fd, 0, size);
+        break;
+    }
   }
-  stream.seekp(size - 1);
 
-  stream << 1;
-  if (stream.good()) {
-    return IOResult<Empty>::OK({});
-  } else {
-    return IOResult<Empty>::ERROR(IOError::GenericError);
+  if (::close(fd) != 0 && error == 0) error = errno;
+  if (error != 0) return IOResult<Empty>::ERROR(IOError::GenericError);
+  return IOResult<Empty>::OK({});
+}
+
+IOResult<FileStat> stat(const std::string& filename) {
+  struct ::stat info {};
+  if (::stat(filename.c_str(), &info) != 0) {
+    if (errno == ENOENT)
+      return IOResult<FileStat>::ERROR(IOError::PathDoesNotExists);
+    return IOResult<FileStat>::ERROR(IOError::GenericError);
   }
+
+  const int64_t NS_PER_SECOND = 1000000000;
+  FileStat result{info.st_size,
+                  info.st_mtim.tv_sec * NS_PER_SECOND + info.st_mtim.tv_nsec};
+  return IOResult<FileStat>::OK(std::move(result));
 }
 
 IOResult<bool> exists(const std::string& filename) {
@@ -50,28 +78,151 @@ IOResult<Empty> remove(const std::string& filename) {
 
 IOResult<Empty> write_bytes(const std::string& filename,
                             const std::vector<uint8_t>& bytes, int64_t offset) {
-  std::fstream stream;
-  stream.open(filename, std::ios::binary | std::ios::in | std::ios::out);
-  if (!stream.good() || !stream.is_open()) {
-    return IOResult<Empty>::ERROR(IOError::GenericError);
+  return write_bytes(filename, bytes.data(), static_cast<int64_t>(bytes.size()),
+                     offset);
+}
+
+IOResult<Empty> write_bytes(const std::string& filename, const uint8_t* bytes,
+                            int64_t len, int64_t offset) {
+  auto file = WritableFile::open(filename);
+  if (!file.valid()) return IOResult<Empty>::ERROR(IOError::GenericError);
+  return file->write(bytes, len, offset);
+}
+
+WritableFile::WritableFile() : _fd{-1} {}
+
+WritableFile::WritableFile(int fd) : _fd{fd} {}
+
+WritableFile::~WritableFile() {
+  if (_fd >= 0) ::close(_fd);
+}
+
+WritableFile::WritableFile(WritableFile&& other) noexcept
+    : _fd{std::exchange(other._fd, -1)} {}
+
+WritableFile& WritableFile::operator=(WritableFile&& other) noexcept {
+  if (this != &other) {
+    if (_fd >= 0) ::close(_fd);
+    _fd = std::exchange(other._fd, -1);
   }
+  return *this;
+}
 
-  // Because we'll need to cast to long later
-  if (bytes.size() > static_cast<size_t>(std::numeric_limits<long>::max())) {
-    throw std::invalid_argument("too many bytes to write");
+IOResult<WritableFile> WritableFile::open(const std::string& filepath) {
+  int fd = ::open(filepath.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT)
+      return IOResult<WritableFile>::ERROR(IOError::PathDoesNotExists);
+    return IOResult<WritableFile>::ERROR(IOError::CannotOpenFile);
   }
+  return IOResult<WritableFile>::OK(WritableFile(fd));
+}
 
-  // Go to desired location andwrite all bytes
-  stream.seekp(offset, std::ios_base::beg);
-  stream.write(reinterpret_cast<const char*>(bytes.data()),
-               // long is what this std function asks for
-               static_cast<long>(bytes.size()));
+IOResult<Empty> WritableFile::write(const uint8_t* bytes, int64_t len,
+                                    int64_t offset) const {
+  if (_fd < 0) return IOResult<Empty>::ERROR(IOError::CannotOpenFile);
 
-  if (stream.good()) {
-    return IOResult<Empty>::OK({});
-  } else {
+  // Writes can be partial, keep going until everything is out
+  int64_t written = 0;
+  while (written < len) {
+    ssize_t result =
+        ::pwrite(_fd, bytes + written, len - written, offset + written);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      return IOResult<Empty>::ERROR(IOError::GenericError);
+    }
+    written += result;
+  }
+  return IOResult<Empty>::OK({});
+}
+
+IOResult<Empty> sync(const std::string& filename) {
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT)
+      return IOResult<Empty>::ERROR(IOError::PathDoesNotExists);
+    return IOResult<Empty>::ERROR(IOError::CannotOpenFile);
+  }
+
+  bool failed = ::fdatasync(fd) != 0;
+  if (::close(fd) != 0) failed = true;
+  if (failed) return IOResult<Empty>::ERROR(IOError::GenericError);
+  return IOResult<Empty>::OK({});
+}
+
+IOResult<int64_t> read_bytes(const std::string& filename, uint8_t* bytes,
+                             int64_t len, int64_t offset) {
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT)
+      return IOResult<int64_t>::ERROR(IOError::PathDoesNotExists);
+    return IOResult<int64_t>::ERROR(IOError::CannotOpenFile);
+  }
+
+  // Only a hint, failures can be ignored
+  ::posix_fadvise(fd, offset, len, POSIX_FADV_SEQUENTIAL);
+
+  bool failed = false;
+  int64_t read = 0;
+  while (read < len) {
+    ssize_t result = ::pread(fd, bytes + read, len - read, offset + read);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      failed = true;
+      break;
+    }
+    // End of file
+    if (result == 0) break;
+    read += result;
+  }
+
+  ::close(fd);
+  if (failed) return IOResult<int64_t>::ERROR(IOError::GenericError);
+  return IOResult<int64_t>::OK(std::move(read));
+}
+
+IOResult<Empty> write_file_atomic(const std::string& filename,
+                                  const std::vector<uint8_t>& bytes) {
+  const std::string tmp_filename = filename + ".tmp";
+
+  int fd = ::open(tmp_filename.c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return IOResult<Empty>::ERROR(IOError::CannotOpenFile);
+
+  // Writes can be partial, keep going until everything is out
+  bool failed = false;
+  size_t written = 0;
+  while (written < bytes.size()) {
+    ssize_t result =
+        ::write(fd, bytes.data() + written, bytes.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      failed = true;
+      break;
+    }
+    written += static_cast<size_t>(result);
+  }
+
+  // The content must be on disk before the rename makes it visible
+  if (!failed && ::fdatasync(fd) != 0) failed = true;
+  if (::close(fd) != 0) failed = true;
+  if (failed || ::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    ::unlink(tmp_filename.c_str());
     return IOResult<Empty>::ERROR(IOError::GenericError);
   }
+
+  // The rename is only durable once the directory holding the file is on
+  // disk too
+  const auto slash = filename.find_last_of('/');
+  const std::string dirname =
+      slash == std::string::npos ? "." : filename.substr(0, slash + 1);
+  int dir_fd = ::open(dirname.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd < 0) return IOResult<Empty>::ERROR(IOError::CannotOpenFile);
+  failed = ::fsync(dir_fd) != 0;
+  if (::close(dir_fd) != 0) failed = true;
+  if (failed) return IOResult<Empty>::ERROR(IOError::GenericError);
+
+  return IOResult<Empty>::OK({});
 }
 
 IOResult<std::string> create_directories(const std::string& path,
@@ -100,6 +251,40 @@ IOResult<std::string> create_directories(const std::string& path,
   return IOResult<std::string>::OK(std::move(real_path));
 }
 
+IOResult<Empty> create_directory(const std::string& path) {
+  std::error_code error;
+  const bool created = std::filesystem::create_directory(path, error);
+  if (error) return IOResult<Empty>::ERROR(IOError::GenericError);
+  // Also when the folder was created by someone else in the meantime
+  if (!created) return IOResult<Empty>::ERROR(IOError::DirectoryAlreadyExists);
+  return IOResult<Empty>::OK({});
+}
+
+IOResult<std::vector<std::string>> list_files(const std::string& path,
+                                              const std::string& extension) {
+  std::error_code error;
+  std::filesystem::directory_iterator it(path, error);
+  if (error) {
+    if (error.default_error_condition().value() ==
+        static_cast<int>(std::errc::no_such_file_or_directory))
+      return IOResult<std::vector<std::string>>::ERROR(
+          IOError::PathDoesNotExists);
+    return IOResult<std::vector<std::string>>::ERROR(IOError::GenericError);
+  }
+
+  std::vector<std::string> files;
+  for (; it != std::filesystem::directory_iterator(); it.increment(error)) {
+    if (!it->is_regular_file(error)) continue;
+    if (it->path().extension() == extension)
+      files.push_back(it->path().string());
+  }
+  if (error)
+    return IOResult<std::vector<std::string>>::ERROR(IOError::GenericError);
+
+  std::sort(files.begin(), files.end());
+  return IOResult<std::vector<std::string>>::OK(std::move(files));
+}
+
 IOResult<std::string> load_file_text(const std::string& filepath) {
   std::ifstream file(filepath);
   if (file.good()) {
@@ -111,4 +296,72 @@ IOResult<std::string> load_file_text(const std::string& filepath) {
   return IOResult<std::string>::ERROR(IOError::CannotOpenFile);
 }
 
+MappedFile::MappedFile() : _data{nullptr}, _size{0} {}
+
+MappedFile::MappedFile(const char* data, int64_t size)
+    : _data{data}, _size{size} {}
+
+MappedFile::~MappedFile() {
+  if (_data != nullptr) ::munmap(const_cast<char*>(_data), _size);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : _data{std::exchange(other._data, nullptr)},
+      _size{std::exchange(other._size, 0)} {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    if (_data != nullptr) ::munmap(const_cast<char*>(_data), _size);
+    _data = std::exchange(other._data, nullptr);
+    _size = std::exchange(other._size, 0);
+  }
+  return *this;
+}
+
+IOResult<MappedFile> MappedFile::open(const std::string& filepath) {
+  int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return IOResult<MappedFile>::ERROR(IOError::CannotOpenFile);
+
+  struct ::stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return IOResult<MappedFile>::ERROR(IOError::GenericError);
+  }
+
+  // Zero bytes cannot be mapped
+  if (info.st_size == 0) {
+    ::close(fd);
+    return IOResult<MappedFile>::OK(MappedFile());
+  }
+
+  // The mapping stays valid after the descriptor is closed
+  void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return IOResult<MappedFile>::ERROR(IOError::GenericError);
+
+  // Parsers go through the whole file once, from beginning to end
+  ::madvise(data, info.st_size, MADV_SEQUENTIAL);
+  return IOResult<MappedFile>::OK(
+      MappedFile(static_cast<const char*>(data), info.st_size));
+}
+
+std::string_view MappedFile::view() const {
+  return {_data, static_cast<size_t>(_size)};
+}
+
+int64_t MappedFile::size() const { return _size; }
+
+IOResult<std::vector<uint8_t>> load_file_bytes(const std::string& filepath) {
+  std::ifstream file(filepath, std::ios::binary);
+  if (!file.good())
+    return IOResult<std::vector<uint8_t>>::ERROR(IOError::CannotOpenFile);
+
+  std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>()};
+  if (file.bad())
+    return IOResult<std::vector<uint8_t>>::ERROR(IOError::GenericError);
+  return IOResult<std::vector<uint8_t>>::OK(std::move(bytes));
+}
+
 }  // namespace fur::platform::io
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <util/result.hpp>
 #include <vector>
 
@@ -22,10 +23,35 @@ template <typename T>
 using IOResult = util::Result<T, IOError>;
 using util::Empty;
 
+/// How the disk space of a newly created file is reserved
+enum class Preallocation {
+  /// Create an empty file, blocks are allocated lazily as bytes are written
+  None,
+  /// Set the final size without reserving any block, the file is sparse
+  Sparse,
+  /// Reserve all blocks upfront, the filesystem can hand out contiguous
+  /// extents and the file won't fragment while pieces arrive out of order
+  Full,
+};
+
 /// Create a new file on the disk
 /// @param filename filename of the new file
 /// @param size size of the new file
-IOResult<Empty> touch(const std::string& filename, int64_t size);
+/// @param mode how to reserve the space of the file
+IOResult<Empty> touch(const std::string& filename, int64_t size,
+                      Preallocation mode = Preallocation::Sparse);
+
+/// Size and last modification time of a file
+struct FileStat {
+  /// Size in bytes
+  int64_t size;
+  /// Last modification time, in nanoseconds since the epoch
+  int64_t mtime;
+};
+
+/// Retrieve size and last modification time of a file
+/// @param filename filename of the target file
+IOResult<FileStat> stat(const std::string& filename);
 
 /// Check if a directory or file exists
 /// @param filename path to check
@@ -42,6 +68,70 @@ IOResult<Empty> remove(const std::string& filename);
 IOResult<Empty> write_bytes(const std::string& filename,
                             const std::vector<uint8_t>& bytes, int64_t offset);
 
+/// Write a range of bytes to file
+/// @param filename filename of the target file
+/// @param bytes first byte to write
+/// @param len number of bytes to write
+/// @param offset where to write the bytes in the file
+IOResult<Empty> write_bytes(const std::string& filename, const uint8_t* bytes,
+                            int64_t len, int64_t offset);
+
+/// Flush to disk all the data written to a file
+/// @param filename filename of the target file
+IOResult<Empty> sync(const std::string& filename);
+
+/// Existing file open for writing, many writes to the same file don't pay for
+/// opening it every time. Writes at different offsets can run concurrently.
+/// The file is closed when the object is destroyed.
+class WritableFile {
+  /// Descriptor of the file, negative once moved away
+  int _fd;
+
+  explicit WritableFile(int fd);
+
+ public:
+  /// A closed file
+  WritableFile();
+  ~WritableFile();
+
+  WritableFile(const WritableFile&) = delete;
+  WritableFile& operator=(const WritableFile&) = delete;
+  WritableFile(WritableFile&& other) noexcept;
+  WritableFile& operator=(WritableFile&& other) noexcept;
+
+  /// Open a file that already exists
+  /// @param filepath filepath of the target file
+  /// @return the open file or an error
+  static IOResult<WritableFile> open(const std::string& filepath);
+
+  /// Write a range of bytes
+  /// @param bytes first byte to write
+  /// @param len number of bytes to write
+  /// @param offset where to write the bytes in the file
+  IOResult<Empty> write(const uint8_t* bytes, int64_t len,
+                        int64_t offset) const;
+};
+
+/// Replace the whole content of a file so that, even if the process crashes
+/// midway, the file contains either the old or the new content. The bytes are
+/// written to a temporary file, flushed to disk and then renamed over the
+/// target, the directory is flushed last so that the rename survives a power
+/// loss.
+/// @param filename filename of the target file
+/// @param bytes new content of the file
+IOResult<Empty> write_file_atomic(const std::string& filename,
+                                  const std::vector<uint8_t>& bytes);
+
+/// Read bytes from file, the OS is told to expect sequential access so that
+/// large reads are served by readahead
+/// @param filename filename of the source file
+/// @param bytes where to store the bytes, must have room for `len` bytes
+/// @param len number of bytes to read
+/// @param offset where to read the bytes in the file
+/// @return number of bytes read, less than `len` if the file is too short
+IOResult<int64_t> read_bytes(const std::string& filename, uint8_t* bytes,
+                             int64_t len, int64_t offset);
+
 /// Create a nested folders structure
 /// @param path path including all directories to create
 /// @param skip_last skip last section of the path, used for files
@@ -49,9 +139,60 @@ IOResult<Empty> write_bytes(const std::string& filename,
 IOResult<std::string> create_directories(const std::string& path,
                                          bool skip_last = false);
 
+/// Create a single folder, its parent must exist. Of many threads or
+/// processes creating the same folder at the same time only one succeeds.
+/// @param path path of the folder
+/// @return an error, `DirectoryAlreadyExists` if something is already there
+IOResult<Empty> create_directory(const std::string& path);
+
+/// List the files directly inside a folder
+/// @param path path of the folder
+/// @param extension only files whose name ends with it are listed, including
+/// the dot
+/// @return paths of the files in alphabetical order or an error
+IOResult<std::vector<std::string>> list_files(const std::string& path,
+                                              const std::string& extension);
+
 /// Load file content of a file
 /// @param filepath filepath of the target file
 /// @return loaded text or an error
 IOResult<std::string> load_file_text(const std::string& filepath);
 
+/// Read-only content of a whole file mapped in memory, pages are loaded by
+/// the OS on first access and nothing is copied. The mapping is released when
+/// the object is destroyed.
+class MappedFile {
+  /// First byte of the mapping, null for empty files
+  const char* _data;
+  /// Length of the file
+  int64_t _size;
+
+  MappedFile(const char* data, int64_t size);
+
+ public:
+  /// An empty mapping
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /// Map the whole content of a file
+  /// @param filepath filepath of the target file
+  /// @return the mapping or an error
+  static IOResult<MappedFile> open(const std::string& filepath);
+
+  /// @return content of the file, valid as long as the mapping
+  [[nodiscard]] std::string_view view() const;
+  /// @return length of the file
+  [[nodiscard]] int64_t size() const;
+};
+
+/// Load the raw content of a file
+/// @param filepath filepath of the target file
+/// @return loaded bytes or an error
+IOResult<std::vector<uint8_t>> load_file_bytes(const std::string& filepath);
+
 }  // namespace fur::platform::io
@@ -0,0 +1,29 @@
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <platform/memory.hpp>
+
+namespace fur::platform::memory {
+
+int64_t round_to_pages(int64_t size, bool huge_pages) {
+  const int64_t page = huge_pages ? HUGE_PAGE_SIZE : ::sysconf(_SC_PAGESIZE);
+  return (size + page - 1) / page * page;
+}
+
+uint8_t* allocate_pages(int64_t size, bool huge_pages) {
+  size = round_to_pages(size, huge_pages);
+  void* pages = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (pages == MAP_FAILED) return nullptr;
+
+  // Only a hint, transparent huge pages may be disabled
+  if (huge_pages) ::madvise(pages, size, MADV_HUGEPAGE);
+  return static_cast<uint8_t*>(pages);
+}
+
+void free_pages(uint8_t* pages, int64_t size, bool huge_pages) {
+  if (pages == nullptr) return;
+  ::munmap(pages, round_to_pages(size, huge_pages));
+}
+
+}  // namespace fur::platform::memory
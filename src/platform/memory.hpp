@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace fur::platform::memory {
+
+/// Size of a transparent huge page on x86-64
+const int64_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/// Reserve a page aligned region of memory directly from the OS. Pages are
+/// zeroed by the OS the first time they are touched.
+/// @param size number of bytes to reserve, rounded up to the page size
+/// @param huge_pages ask the OS to back the region with huge pages, reducing
+/// page faults and TLB misses for large buffers
+/// @return start of the region or nullptr if the OS refused
+uint8_t* allocate_pages(int64_t size, bool huge_pages);
+
+/// Return a region reserved by `allocate_pages` to the OS
+/// @param pages start of the region
+/// @param size same size used to reserve the region
+/// @param huge_pages same flag used to reserve the region
+void free_pages(uint8_t* pages, int64_t size, bool huge_pages);
+
+/// @return `size` rounded up to the page size used by `allocate_pages`
+int64_t round_to_pages(int64_t size, bool huge_pages);
+
+}  // namespace fur::platform::memory
@@ -0,0 +1,165 @@
+/**
+ * @file fair_queue.hpp
+ * @brief Queue sharing extractions between flows of items by weight
+ * @version 0.1
+ * @date 2022-10-19
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <policy/heap_queue.hpp>
+#include <policy/queue.hpp>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace fur::policy {
+
+/// @brief Queue made of one sub-queue for every flow of items, for example
+/// the pieces of each torrent. Flows of the highest priority class with items
+/// go first, inside a class extractions are shared between the flows in
+/// proportion to their weights with start-time fair queueing: every flow has
+/// a virtual time advanced by the cost of each extracted item divided by the
+/// weight of the flow, and the flow with the lowest virtual time is served
+/// next. A flow that was empty restarts from the current virtual time, so
+/// being idle never builds up credit.
+/// The items of every flow are kept in a `HeapQueue`, the chosen flow gives
+/// its item of the lowest rank. Every flow has its own instance of the
+/// ranking, see `rank`.
+/// Flows can be parked: their items stay where they are, are never extracted
+/// and don't count in `size`, until the flow is unparked.
+/// Flows that can be served are kept sorted, choosing the next one doesn't
+/// depend on how many flows there are. Flows are only forgotten with `erase`.
+/// @tparam T type of the stored items
+/// @tparam Flow provides `key(const T&)`, the flow an item belongs to and
+/// ordered by `<`, and
+/// `cost(const T&)`, how much serving the item is worth, as static functions.
+/// `Flow::Rank` is the function object ranking the items of a flow, default
+/// constructed for every new flow.
+template <typename T, typename Flow>
+class FairQueue {
+ public:
+  /// Identifier of a flow
+  using Key = decltype(Flow::key(std::declval<const T&>()));
+
+  // Errors are the same of the queue
+  using Error = typename Queue<T>::Error;
+  using Result = typename Queue<T>::Result;
+  using MutateFn = typename Queue<T>::MutateFn;
+  /// Ranks the items of a flow
+  using Rank = typename Flow::Rank;
+
+  /// How much a flow has been served so far
+  struct FlowStats {
+    /// Items extracted
+    int64_t served;
+    /// Sum of the costs of the items extracted
+    int64_t cost;
+  };
+
+ private:
+  /// State of a single flow
+  struct State {
+    /// Items of the flow
+    HeapQueue<T, Rank> items;
+    /// Share of the extractions relative to the other flows of its class
+    int64_t weight = 1;
+    /// Class of the flow, higher classes are always served first
+    int64_t priority = 0;
+    /// Virtual time of the next item of the flow
+    double start = 0.0;
+    /// True if the items of the flow must not be extracted
+    bool parked = false;
+    FlowStats stats{0, 0};
+  };
+
+  /// Order in which the flows are served: class, then virtual time
+  using Turn = std::tuple<int64_t, double, Key>;
+
+  /// All flows that had an item since they were last erased
+  std::unordered_map<Key, State> _flows;
+  /// Turns of the flows that have items and are not parked, the first one is
+  /// served next
+  std::set<Turn> _turns;
+  /// Virtual time of the last extracted item
+  double _virtual_time;
+  /// How much all flows have been served so far
+  FlowStats _total;
+  /// Items in the flows that are not parked
+  int64_t _size;
+  /// Items in the parked flows
+  int64_t _parked;
+
+ public:
+  FairQueue();
+
+  /// Insert a new element
+  /// @param item element to be inserted
+  void insert(T&& item);
+
+  /// Construct and insert a new element
+  /// @param ...args arguments list used in constructor of T
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  /// Extracts the element of the lowest rank of the flow that must be served
+  /// next. Costs O(log f + log n) with f flows and n items in the chosen
+  /// flow.
+  [[nodiscard]] Result extract();
+
+  /// Forget a flow with all its items, its share, ranking and statistics
+  void erase(const Key& key);
+
+  /// Mutate the items of all flows
+  void mutate(MutateFn mutation);
+
+  /// Set how a flow is served, flows start with weight 1 and class 0
+  /// @param weight share of the extractions relative to the other flows of
+  /// the same class, must be positive
+  /// @param priority class of the flow, higher classes are served first
+  void set_share(const Key& key, int64_t weight, int64_t priority);
+
+  /// @return the function object ranking the items of a flow, changes are
+  /// only taken into account after `rerank`
+  Rank& rank(const Key& key);
+
+  /// Rank all the items of a flow again, needed once the state the ranking
+  /// of the flow depends on has changed. Costs O(n) in the items of the flow.
+  void rerank(const Key& key);
+
+  /// @return how much a flow has been served so far
+  [[nodiscard]] FlowStats stats(const Key& key) const;
+
+  /// @return how much all flows have been served so far
+  [[nodiscard]] FlowStats total() const;
+
+  /// Stop extracting the items of a flow, items inserted while the flow is
+  /// parked are kept as well
+  void park(const Key& key);
+
+  /// Extract the items of a parked flow again, the flow competes with the
+  /// others from the current virtual time
+  void unpark(const Key& key);
+
+  /// @return Number of items that can be extracted, parked flows don't count
+  [[nodiscard]] int64_t size() const;
+
+  /// @return Number of items in the parked flows
+  [[nodiscard]] int64_t parked() const;
+
+ private:
+  /// @return turn of a flow, higher classes come first
+  static Turn turn(const Key& key, const State& state);
+  /// Called before the state of a flow changes, the flow has no turn until
+  /// `enqueue` is called
+  void dequeue(const Key& key, const State& state);
+  /// Called once the state of a flow changed, the flow gets a turn if it can
+  /// be served
+  void enqueue(const Key& key, const State& state);
+};
+
+}  // namespace fur::policy
+
+#include <policy/fair_queue.inl>
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <policy/fair_queue.hpp>
+#include <stdexcept>
+
+namespace fur::policy {
+
+template <typename T, typename Flow>
+FairQueue<T, Flow>::FairQueue()
+    : _virtual_time{0.0}, _total{0, 0}, _size{0}, _parked{0} {}
+
+template <typename T, typename Flow>
+auto FairQueue<T, Flow>::turn(const Key& key, const State& state) -> Turn {
+  return {-state.priority, state.start, key};
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::dequeue(const Key& key, const State& state) {
+  if (!state.parked && state.items.size() > 0) _turns.erase(turn(key, state));
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::enqueue(const Key& key, const State& state) {
+  if (!state.parked && state.items.size() > 0) _turns.insert(turn(key, state));
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::insert(T&& item) {
+  const Key key = Flow::key(item);
+  State& state = _flows[key];
+  dequeue(key, state);
+
+  // A flow that was idle doesn't get to catch up
+  if (state.items.size() == 0)
+    state.start = std::max(state.start, _virtual_time);
+  state.items.insert(std::forward<T>(item));
+  if (state.parked)
+    _parked += 1;
+  else
+    _size += 1;
+
+  enqueue(key, state);
+}
+
+template <typename T, typename Flow>
+template <typename... Args>
+void FairQueue<T, Flow>::emplace(Args&&... args) {
+  insert(T(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Flow>
+auto FairQueue<T, Flow>::extract() -> Result {
+  if (_size == 0) return Result::ERROR(Error::Empty);
+
+  // The flow to serve next has the first turn
+  const Key key = std::get<2>(*_turns.begin());
+  _turns.erase(_turns.begin());
+  State* next = &_flows.at(key);
+
+  T item = std::move(*next->items.extract());
+  const int64_t cost = Flow::cost(item);
+  _virtual_time = std::max(_virtual_time, next->start);
+  next->start += static_cast<double>(cost) / next->weight;
+  next->stats.served += 1;
+  next->stats.cost += cost;
+  _total.served += 1;
+  _total.cost += cost;
+  _size -= 1;
+
+  enqueue(key, *next);
+  return Result::OK(std::move(item));
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::erase(const Key& key) {
+  auto it = _flows.find(key);
+  if (it == _flows.end()) return;
+
+  State& state = it->second;
+  dequeue(key, state);
+  (state.parked ? _parked : _size) -= state.items.size();
+  _flows.erase(it);
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::mutate(MutateFn mutation) {
+  _size = 0;
+  _parked = 0;
+  _turns.clear();
+  for (auto& [key, state] : _flows) {
+    state.items.mutate(mutation);
+    (state.parked ? _parked : _size) += state.items.size();
+    enqueue(key, state);
+  }
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::set_share(const Key& key, int64_t weight,
+                                   int64_t priority) {
+  if (weight <= 0) throw std::invalid_argument("weight must be positive");
+  State& state = _flows[key];
+  dequeue(key, state);
+  state.weight = weight;
+  state.priority = priority;
+  enqueue(key, state);
+}
+
+template <typename T, typename Flow>
+auto FairQueue<T, Flow>::rank(const Key& key) -> Rank& {
+  return _flows[key].items.rank();
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::rerank(const Key& key) {
+  _flows[key].items.rerank();
+}
+
+template <typename T, typename Flow>
+auto FairQueue<T, Flow>::stats(const Key& key) const -> FlowStats {
+  auto it = _flows.find(key);
+  if (it == _flows.end()) return {0, 0};
+  return it->second.stats;
+}
+
+template <typename T, typename Flow>
+auto FairQueue<T, Flow>::total() const -> FlowStats {
+  return _total;
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::park(const Key& key) {
+  State& state = _flows[key];
+  if (state.parked) return;
+  dequeue(key, state);
+  state.parked = true;
+  _size -= state.items.size();
+  _parked += state.items.size();
+}
+
+template <typename T, typename Flow>
+void FairQueue<T, Flow>::unpark(const Key& key) {
+  State& state = _flows[key];
+  if (!state.parked) return;
+  state.parked = false;
+  state.start = std::max(state.start, _virtual_time);
+  _parked -= state.items.size();
+  _size += state.items.size();
+  enqueue(key, state);
+}
+
+template <typename T, typename Flow>
+int64_t FairQueue<T, Flow>::size() const {
+  return _size;
+}
+
+template <typename T, typename Flow>
+int64_t FairQueue<T, Flow>::parked() const {
+  return _parked;
+}
+
+}  // namespace fur::policy
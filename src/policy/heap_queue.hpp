@@ -0,0 +1,129 @@
+/**
+ * @file heap_queue.hpp
+ * @brief Queue extracting items by rank in logarithmic time
+ * @version 0.1
+ * @date 2022-10-19
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <util/result.hpp>
+#include <vector>
+
+namespace fur::policy {
+
+/// @brief Queue that always extracts the item with the lowest rank, ties go
+/// to the item inserted first. Unlike `Queue` with a `RankPolicy` the items
+/// are kept in a heap, so extraction costs O(log n) instead of a scan of the
+/// whole queue, and the policy is a template parameter called without any
+/// virtual dispatch.
+/// Ranks are computed once, when an item is inserted or updated. If the rank
+/// of an item changes it must be updated through its handle, if the ranking
+/// itself changes all items must be ranked again with `rerank`.
+/// @tparam T type of the stored items
+/// @tparam Rank function object computing the rank of an item as an int64_t,
+/// lower ranks are extracted first
+template <typename T, typename Rank>
+class HeapQueue {
+ public:
+  /// Identifies an item while it's in the queue, handles of extracted items
+  /// are reused by the next insertions
+  using Handle = int64_t;
+
+  /// All possible error that can occur
+  enum class Error {
+    /// There are no more elements
+    Empty
+  };
+
+  /// Custom queue result type
+  using Result = util::Result<T, Error>;
+
+  // Function used to mutate the internal collection
+  // returns false if the element should be kept, true otherwise
+  using MutateFn = std::function<bool(T&)>;
+
+ private:
+  /// Position of an item in the heap, the rank is cached so that comparisons
+  /// never call `Rank`
+  struct Entry {
+    int64_t rank;
+    /// Insertion counter, breaks ties between equal ranks
+    uint64_t order;
+    Handle handle;
+  };
+
+  /// Ranks the items
+  Rank _rank;
+  /// Binary heap of the items, the lowest rank at the top
+  std::vector<Entry> _heap;
+  /// Items indexed by handle, empty for free handles
+  std::vector<std::optional<T>> _items;
+  /// Position in the heap of every handle
+  std::vector<int64_t> _positions;
+  /// Handles of extracted items, reused before new ones are created
+  std::vector<Handle> _free;
+  /// Next insertion counter
+  uint64_t _order;
+
+ public:
+  explicit HeapQueue(Rank rank = Rank());
+
+  /// Insert a new element
+  /// @param item element to be inserted
+  /// @return handle of the element
+  Handle insert(T&& item);
+
+  /// Construct and insert a new element
+  /// @param ...args arguments list used in constructor of T
+  /// @return handle of the element
+  template <typename... Args>
+  Handle emplace(Args&&... args);
+
+  /// Extract the element with the lowest rank
+  [[nodiscard]] Result extract();
+
+  /// @return the element that `extract` would return, the queue must not be
+  /// empty
+  [[nodiscard]] const T& top() const;
+
+  /// Change an element in place and move it to its new rank
+  /// @param handle handle of an element in the queue
+  /// @param change modifies the element
+  template <typename Fn>
+  void update(Handle handle, Fn&& change);
+
+  /// Rank all the elements again, needed once the state the ranking depends
+  /// on has changed. Costs O(n).
+  void rerank();
+
+  /// Mutate the internal list of items
+  void mutate(MutateFn mutation);
+
+  /// @return the function object ranking the elements, rank changes are
+  /// only taken into account after `rerank`
+  Rank& rank();
+
+  /// @return Number of items present
+  [[nodiscard]] int64_t size() const;
+
+ private:
+  /// @return True if `a` must be extracted before `b`
+  static bool before(const Entry& a, const Entry& b);
+  /// Move the entry at `pos` to its place in the heap, towards the top or the
+  /// bottom
+  void restore(int64_t pos);
+  void sift_up(int64_t pos);
+  void sift_down(int64_t pos);
+  /// Put an entry at a position of the heap and record it
+  void place(int64_t pos, const Entry& entry);
+  /// Remove the entry at `pos` from the heap and free its handle
+  T remove(int64_t pos);
+};
+
+}  // namespace fur::policy
+
+#include <policy/heap_queue.inl>
@@ -0,0 +1,155 @@
+#include <policy/heap_queue.hpp>
+#include <utility>
+
+namespace fur::policy {
+
+template <typename T, typename Rank>
+HeapQueue<T, Rank>::HeapQueue(Rank rank) : _rank{std::move(rank)}, _order{0} {}
+
+template <typename T, typename Rank>
+auto HeapQueue<T, Rank>::insert(T&& item) -> Handle {
+  return emplace(std::forward<T>(item));
+}
+
+template <typename T, typename Rank>
+template <typename... Args>
+auto HeapQueue<T, Rank>::emplace(Args&&... args) -> Handle {
+  Handle handle;
+  if (_free.empty()) {
+    handle = static_cast<Handle>(_items.size());
+    _items.emplace_back();
+    _positions.push_back(0);
+  } else {
+    handle = _free.back();
+    _free.pop_back();
+  }
+
+  T& item = _items[handle].emplace(std::forward<Args>(args)...);
+  const int64_t pos = static_cast<int64_t>(_heap.size());
+  _heap.push_back({});
+  place(pos, {_rank(item), _order++, handle});
+  sift_up(pos);
+  return handle;
+}
+
+template <typename T, typename Rank>
+auto HeapQueue<T, Rank>::extract() -> Result {
+  if (_heap.empty()) return Result::ERROR(Error::Empty);
+  return Result::OK(remove(0));
+}
+
+template <typename T, typename Rank>
+const T& HeapQueue<T, Rank>::top() const {
+  return *_items[_heap.front().handle];
+}
+
+template <typename T, typename Rank>
+template <typename Fn>
+void HeapQueue<T, Rank>::update(Handle handle, Fn&& change) {
+  T& item = *_items[handle];
+  change(item);
+
+  const int64_t pos = _positions[handle];
+  _heap[pos].rank = _rank(item);
+  restore(pos);
+}
+
+template <typename T, typename Rank>
+void HeapQueue<T, Rank>::rerank() {
+  for (auto& entry : _heap) entry.rank = _rank(*_items[entry.handle]);
+
+  // Bottom-up heap construction
+  const int64_t size = static_cast<int64_t>(_heap.size());
+  for (int64_t pos = size / 2 - 1; pos >= 0; pos--) sift_down(pos);
+}
+
+template <typename T, typename Rank>
+void HeapQueue<T, Rank>::mutate(MutateFn mutation) {
+  // Entries kept are compacted at the beginning, the heap is built again
+  int64_t kept = 0;
+  for (const auto& entry : _heap) {
+    if (mutation(*_items[entry.handle])) {
+      _items[entry.handle].reset();
+      _free.push_back(entry.handle);
+    } else {
+      place(kept++, entry);
+    }
+  }
+  _heap.resize(kept);
+  rerank();
+}
+
+template <typename T, typename Rank>
+Rank& HeapQueue<T, Rank>::rank() {
+  return _rank;
+}
+
+template <typename T, typename Rank>
+int64_t HeapQueue<T, Rank>::size() const {
+  return static_cast<int64_t>(_heap.size());
+}
+
+template <typename T, typename Rank>
+bool HeapQueue<T, Rank>::before(const Entry& a, const Entry& b) {
+  return a.rank < b.rank || (a.rank == b.rank && a.order < b.order);
+}
+
+template <typename T, typename Rank>
+void HeapQueue<T, Rank>::restore(int64_t pos) {
+  if (pos > 0 && before(_heap[pos], _heap[(pos - 1) / 2]))
+    sift_up(pos);
+  else
+    sift_down(pos);
+}
+
+template <typename T, typename Rank>
+void HeapQueue<T, Rank>::sift_up(int64_t pos) {
+  const Entry entry = _heap[pos];
+  while (pos > 0) {
+    const int64_t parent = (pos - 1) / 2;
+    if (!before(entry, _heap[parent])) break;
+    place(pos, _heap[parent]);
+    pos = parent;
+  }
+  place(pos, entry);
+}
+
+template <typename T, typename Rank>
+void HeapQueue<T, Rank>::sift_down(int64_t pos) {
+  const int64_t size = static_cast<int64_t>(_heap.size());
+  const Entry entry = _heap[pos];
+  while (true) {
+    int64_t child = 2 * pos + 1;
+    if (child >= size) break;
+    if (child + 1 < size && before(_heap[child + 1], _heap[child])) child += 1;
+    if (!before(_heap[child], entry)) break;
+    place(pos, _heap[child]);
+    pos = child;
+  }
+  place(pos, entry);
+}
+
+template <typename T, typename Rank>
+void HeapQueue<T, Rank>::place(int64_t pos, const Entry& entry) {
+  _heap[pos] = entry;
+  _positions[entry.handle] = pos;
+}
+
+template <typename T, typename Rank>
+T HeapQueue<T, Rank>::remove(int64_t pos) {
+  const Handle handle = _heap[pos].handle;
+  T item = std::move(*_items[handle]);
+  _items[handle].reset();
+  _free.push_back(handle);
+
+  // The last entry takes the place of the removed one
+  const Entry last = _heap.back();
+  _heap.pop_back();
+  if (pos < static_cast<int64_t>(_heap.size())) {
+    place(pos, last);
+    restore(pos);
+  }
+  return item;
+}
+
+}  // namespace fur::policy
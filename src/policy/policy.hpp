@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <list>
 
 namespace fur::policy {
@@ -45,6 +47,26 @@ class LIFOPolicy : public IPolicy<T> {
   Iterator extract(Iterator begin, Iterator end) const override;
 };
 
+/// @brief Extracts the element with the lowest rank, ties go to the element
+/// closest to the beginning of the list
+template <typename T>
+class RankPolicy : public IPolicy<T> {
+ public:
+  using typename IPolicy<T>::Iterator;
+  /// Computes the rank of an element, lower ranks are extracted first
+  using RankFn = std::function<int64_t(const T&)>;
+
+  /// @param rank ranks the elements
+  /// @param best no element can rank lower, the search stops at the first
+  /// element with this rank
+  explicit RankPolicy(RankFn rank, int64_t best = 0);
+  Iterator extract(Iterator begin, Iterator end) const override;
+
+ private:
+  RankFn _rank;
+  int64_t _best;
+};
+
 }  // namespace fur::policy
 
 #include <policy/policy.inl>
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <policy/policy.hpp>
+#include <utility>
 
 namespace fur::policy {
 
@@ -12,4 +13,23 @@ auto FIFOPolicy<T>::extract(Iterator, Iterator end) const -> Iterator {
   return --end;
 }
 
+template <typename T>
+RankPolicy<T>::RankPolicy(RankFn rank, int64_t best)
+    : _rank{std::move(rank)}, _best{best} {}
+
+template <typename T>
+auto RankPolicy<T>::extract(Iterator begin, Iterator end) const -> Iterator {
+  Iterator selected = end;
+  int64_t selected_rank = 0;
+  for (Iterator it = begin; it != end; ++it) {
+    const int64_t rank = _rank(*it);
+    if (selected == end || rank < selected_rank) {
+      selected = it;
+      selected_rank = rank;
+      if (rank <= _best) break;
+    }
+  }
+  return selected;
+}
+
 }  // namespace fur::policy
\ No newline at end of file
@@ -23,6 +23,9 @@ template <typename T>
 class Queue {
   /// Stored items
   std::list<T> _items;
+  /// Nodes of extracted items, reused by the next insertions so that putting
+  /// an item back into the queue doesn't allocate
+  std::list<T> _spare;
 
  public:
   /// All possible error that can occur
@@ -4,13 +4,22 @@
 
 namespace fur::policy {
 
+/// Maximum number of nodes kept for reuse by a queue after their items have
+/// been extracted
+const int64_t QUEUE_SPARE_NODES = 1024;
+
 template <typename T>
 void Queue<T>::insert(T&& item) {
   if (static_cast<int64_t>(_items.size()) ==
       std::numeric_limits<int64_t>::max()) {
     throw std::logic_error("queue cannot fit more items");
   }
-  _items.push_back(std::forward<T>(item));
+  if (_spare.empty()) {
+    _items.push_back(std::forward<T>(item));
+    return;
+  }
+  _spare.front() = std::forward<T>(item);
+  _items.splice(_items.end(), _spare, _spare.begin());
 }
 
 template <typename T>
@@ -20,7 +29,12 @@ void Queue<T>::emplace(Args&&... args) {
       std::numeric_limits<int64_t>::max()) {
     throw std::logic_error("queue cannot fit more items");
   }
-  _items.emplace(_items.end(), std::forward<Args>(args)...);
+  if (_spare.empty()) {
+    _items.emplace(_items.end(), std::forward<Args>(args)...);
+    return;
+  }
+  _spare.front() = T(std::forward<Args>(args)...);
+  _items.splice(_items.end(), _spare, _spare.begin());
 }
 
 template <typename T>
@@ -36,7 +50,10 @@ auto Queue<T>::extract(const IPolicy<T>& policy) -> Result {
   if (it == _items.end()) return Result::ERROR(Error::PolicyFailure);
 
   auto result = std::move(*it);
-  _items.erase(it);
+  if (static_cast<int64_t>(_spare.size()) < QUEUE_SPARE_NODES)
+    _spare.splice(_spare.begin(), _items, it);
+  else
+    _items.erase(it);
 
   return Result::OK(std::move(result));
 }
@@ -0,0 +1,207 @@
+#include "recheck.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hash.hpp"
+#include "mt/parallel.hpp"
+
+namespace fur::recheck {
+
+/// Number of bytes each reader reads at once
+const int64_t CHUNK_BYTES = 64 * 1024 * 1024;
+/// Number of threads of a recheck that read from storage, more of them do not
+/// make the disk any faster
+const int64_t READERS = 4;
+/// Maximum number of bytes of read buffers shared by all running rechecks
+const int64_t BUFFERS_BYTES = 256 * 1024 * 1024;
+
+/// Process wide budget of memory for the read buffers, so that concurrent
+/// rechecks wait for each other instead of piling up buffers
+class BufferBudget {
+ public:
+  /// Blocks until `bytes` are available and takes them
+  void acquire(int64_t bytes) {
+    std::unique_lock<std::mutex> lock(_mtx);
+    _cv.wait(lock, [&] { return _used + bytes <= BUFFERS_BYTES; });
+    _used += bytes;
+  }
+  /// Gives back `bytes` taken with "acquire"
+  void release(int64_t bytes) {
+    {
+      std::scoped_lock<std::mutex> lock(_mtx);
+      _used -= bytes;
+    }
+    _cv.notify_all();
+  }
+
+ private:
+  std::mutex _mtx;
+  std::condition_variable _cv;
+  int64_t _used = 0;
+};
+
+static BufferBudget& buffer_budget() {
+  static BufferBudget budget;
+  return budget;
+}
+
+double RecheckReport::throughput() const {
+  if (seconds <= 0.0) return 0.0;
+  return static_cast<double>(bytes_read) / 1e9 / seconds;
+}
+
+/// Contiguous range of bytes of a single file
+struct ReadRange {
+  /// Path of the file
+  const std::string* filepath;
+  /// Offset from the beginning of the file
+  int64_t file_offset;
+  /// Size in bytes
+  int64_t len;
+};
+
+RecheckReport recheck(const TorrentFile& descriptor,
+                      storage::StorageBackend& storage, int64_t max_threads,
+                      const Bitfield* selected) {
+  auto clock_beg = std::chrono::steady_clock::now();
+
+  const FileLayout layout(descriptor);
+  const int64_t pieces_count = descriptor.pieces_count;
+
+  // Chunks are made of consecutive pieces to check, pieces that are also
+  // consecutive in the torrent are still read together
+  std::vector<int64_t> indexes;
+  for (int64_t index = 0; index < pieces_count; index++) {
+    if (selected == nullptr || selected->get(index)) indexes.push_back(index);
+  }
+  const int64_t checked_count = static_cast<int64_t>(indexes.size());
+
+  const int64_t chunk_pieces =
+      std::max<int64_t>(1, CHUNK_BYTES / descriptor.piece_length);
+  const int64_t chunks_count =
+      (checked_count + chunk_pieces - 1) / chunk_pieces;
+
+  int64_t threads_count = std::thread::hardware_concurrency();
+  if (max_threads != 0) threads_count = std::min(threads_count, max_threads);
+  threads_count = std::max<int64_t>(1, threads_count);
+
+  // A few readers own the buffers, the remaining threads are split among them
+  // to hash the chunks they read
+  const int64_t readers_count =
+      std::max<int64_t>(1, std::min({READERS, threads_count, chunks_count}));
+  const int64_t hashers_count =
+      std::max<int64_t>(1, threads_count / readers_count);
+
+  // A buffer larger than the whole budget would never fit, such a recheck
+  // takes all of it instead
+  const int64_t buffer_bytes = chunk_pieces * descriptor.piece_length;
+  const int64_t budget_bytes = std::min(buffer_bytes, BUFFERS_BYTES);
+
+  // One byte per piece so that workers never write to the same memory
+  std::vector<uint8_t> valid(pieces_count, 0);
+  std::atomic_int64_t next_chunk{0};
+  std::atomic_int64_t bytes_read{0};
+
+  mt::parallel_for(
+      readers_count,
+      [&](int64_t) {
+        // Each reader reuses its own buffer for all the chunks it reads
+        buffer_budget().acquire(budget_bytes);
+        struct Release {
+          int64_t bytes;
+          ~Release() { buffer_budget().release(bytes); }
+        } release{budget_bytes};
+
+        std::unique_ptr<uint8_t[]> buffer(new uint8_t[buffer_bytes]);
+        std::vector<Piece> pieces;
+        std::vector<ReadRange> ranges;
+        std::vector<hash::PieceView> views;
+
+        int64_t chunk;
+        while ((chunk = next_chunk.fetch_add(1)) < chunks_count) {
+          // Positions of the pieces of the chunk among the pieces to check
+          const int64_t first = chunk * chunk_pieces;
+          const int64_t last = std::min(first + chunk_pieces, checked_count);
+
+          // Only the pieces of the chunk are generated
+          pieces.clear();
+          for (int64_t i = first; i < last; i++)
+            pieces.push_back(layout.piece(indexes[i]));
+
+          // Merge the subpieces of consecutive pieces that are contiguous on
+          // the same file into a single large read
+          ranges.clear();
+          for (const auto& piece : pieces) {
+            for (const auto& subpiece : piece.subpieces) {
+              if (!ranges.empty() && *ranges.back().filepath == subpiece.filepath &&
+                  ranges.back().file_offset + ranges.back().len ==
+                      subpiece.file_offset) {
+                ranges.back().len += subpiece.len;
+                continue;
+              }
+              ranges.push_back(
+                  {&subpiece.filepath, subpiece.file_offset, subpiece.len});
+            }
+          }
+
+          uint8_t* cursor = buffer.get();
+          for (const auto& range : ranges) {
+            auto read = storage.read_block(
+                descriptor.folder_name + '/' + *range.filepath, cursor,
+                range.len, range.file_offset);
+
+            int64_t read_len = read.valid() ? *read : 0;
+            std::memset(cursor + read_len, 0, range.len - read_len);
+            bytes_read.fetch_add(read_len, std::memory_order_relaxed);
+            cursor += range.len;
+          }
+
+          // Verify the pieces of the chunk in as many groups as hashers
+          views.clear();
+          cursor = buffer.get();
+          for (int64_t i = first; i < last; i++) {
+            const int64_t piece_len = layout.piece_length(indexes[i]);
+
+            views.push_back(
+                {cursor, piece_len, &descriptor.piece_hashes[indexes[i]]});
+            cursor += piece_len;
+          }
+
+          const int64_t views_count = static_cast<int64_t>(views.size());
+          const int64_t groups_count = std::min(hashers_count, views_count);
+          mt::parallel_for(
+              groups_count,
+              [&](int64_t group) {
+                const int64_t beg = views_count * group / groups_count;
+                const int64_t end = views_count * (group + 1) / groups_count;
+
+                auto verified = hash::verify_pieces(
+                    {views.begin() + beg, views.begin() + end});
+                for (int64_t i = beg; i < end; i++)
+                  valid[indexes[first + i]] = verified[i - beg];
+              },
+              groups_count);
+        }
+      },
+      readers_count);
+
+  Bitfield valid_pieces(pieces_count);
+  for (int64_t index = 0; index < pieces_count; index++) {
+    if (valid[index]) valid_pieces.set(index);
+  }
+
+  auto clock_end = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = clock_end - clock_beg;
+  return {std::move(valid_pieces), bytes_read.load(), elapsed.count()};
+}
+
+}  // namespace fur::recheck
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "download/bitfield.hpp"
+#include "storage/backend.hpp"
+#include "torrent.hpp"
+
+/// Verification of the content of a torrent that is already on disk
+namespace fur::recheck {
+
+using download::bitfield::Bitfield;
+
+/// Outcome of a recheck
+struct RecheckReport {
+  /// Pieces whose content on disk matches their hash
+  Bitfield valid_pieces;
+  /// Number of bytes read from storage
+  int64_t bytes_read;
+  /// Time spent reading and hashing, in seconds
+  double seconds;
+
+  /// @return read and hash throughput in GB/s
+  [[nodiscard]] double throughput() const;
+};
+
+/// Reads every piece of a torrent from storage and checks it against its
+/// hash. The torrent is split in large chunks of consecutive pieces that are
+/// read by a few readers and hashed in parallel on all cores. The read buffers
+/// of all the rechecks share a fixed memory budget, a recheck waits for the
+/// others when it is exhausted. Missing files or parts of files are treated as
+/// zeroes.
+/// @param descriptor torrent to check, with a valid folder name
+/// @param storage where the content of the torrent is stored
+/// @param max_threads maximum number of threads to use, 0 means one per core
+/// @param selected pieces to check, every piece if null. The others are not
+/// read and are reported invalid.
+RecheckReport recheck(const TorrentFile& descriptor,
+                      storage::StorageBackend& storage,
+                      int64_t max_threads = 0,
+                      const Bitfield* selected = nullptr);
+
+}  // namespace fur::recheck
@@ -0,0 +1,271 @@
+#include "resume.hpp"
+
+#include <algorithm>
+
+#include "util/binary.hpp"
+
+namespace fur::resume {
+
+/// First bytes of every resume file, "FURR" in ASCII
+const uint32_t RESUME_MAGIC = 0x52525546;
+/// Must be incremented every time the binary format changes
+const uint32_t RESUME_VERSION = 1;
+
+std::vector<uint8_t> encode(const ResumeData& data) {
+  std::vector<uint8_t> bytes;
+  util::BinaryWriter writer(bytes);
+
+  writer.put_u32(RESUME_MAGIC);
+  writer.put_u32(RESUME_VERSION);
+  writer.put_bytes(data.info_hash.data(),
+                   static_cast<int64_t>(data.info_hash.size()));
+  writer.put_string(data.folder_name);
+  writer.put_i64(data.pieces_count);
+
+  writer.put_i64(static_cast<int64_t>(data.files.size()));
+  for (const auto& file : data.files) {
+    writer.put_i64(file.size);
+    writer.put_i64(file.mtime);
+  }
+
+  writer.put_bytes(data.completed.data(),
+                   static_cast<int64_t>(data.completed.size()));
+  return bytes;
+}
+
+util::Result<ResumeData, ResumeError> decode(
+    const std::vector<uint8_t>& bytes) {
+  using Result = util::Result<ResumeData, ResumeError>;
+
+  util::BinaryReader reader(bytes.data(), static_cast<int64_t>(bytes.size()));
+  if (reader.get_u32() != RESUME_MAGIC)
+    return Result::ERROR(ResumeError::Malformed);
+  if (reader.get_u32() != RESUME_VERSION)
+    return Result::ERROR(ResumeError::UnsupportedVersion);
+
+  ResumeData data;
+  const uint8_t* info_hash = reader.get_bytes(data.info_hash.size());
+  if (info_hash != nullptr)
+    std::copy(info_hash, info_hash + data.info_hash.size(),
+              data.info_hash.begin());
+
+  data.folder_name = reader.get_string();
+  data.pieces_count = reader.get_i64();
+
+  // Every file takes 16 bytes, reject counts that cannot possibly fit
+  int64_t files_count = reader.get_i64();
+  if (files_count < 0 || files_count > reader.remaining() / 16)
+    return Result::ERROR(ResumeError::Malformed);
+
+  data.files.reserve(files_count);
+  for (int64_t i = 0; i < files_count; i++) {
+    int64_t size = reader.get_i64();
+    int64_t mtime = reader.get_i64();
+    data.files.push_back({size, mtime});
+  }
+
+  if (data.pieces_count < 0) return Result::ERROR(ResumeError::Malformed);
+  const int64_t completed_len = (data.pieces_count + 7) / 8;
+  const uint8_t* completed = reader.get_bytes(completed_len);
+  if (completed != nullptr)
+    data.completed.assign(completed, completed + completed_len);
+
+  if (!reader.valid() || reader.remaining() != 0)
+    return Result::ERROR(ResumeError::Malformed);
+  return Result::OK(std::move(data));
+}
+
+util::Result<ResumeData, ResumeError> load(const std::string& filepath) {
+  auto bytes = platform::io::load_file_bytes(filepath);
+  if (!bytes.valid()) {
+    return util::Result<ResumeData, ResumeError>::ERROR(
+        ResumeError::CannotOpenFile);
+  }
+  return decode(*bytes);
+}
+
+/// Offset of the first byte of every file from the beginning of the torrent
+static std::vector<int64_t> files_offsets(const TorrentFile& descriptor) {
+  std::vector<int64_t> offsets;
+  offsets.reserve(descriptor.files.size());
+
+  int64_t offset = 0;
+  for (const auto& file : descriptor.files) {
+    offsets.push_back(offset);
+    offset += file.length;
+  }
+  return offsets;
+}
+
+std::optional<Validation> validate(const ResumeData& data,
+                                   const TorrentFile& descriptor) {
+  if (data.info_hash != descriptor.info_hash ||
+      data.pieces_count != descriptor.pieces_count ||
+      data.files.size() != descriptor.files.size() ||
+      data.completed.size() !=
+          static_cast<size_t>((descriptor.pieces_count + 7) / 8))
+    return std::nullopt;
+
+  auto folder_existence = platform::io::exists(data.folder_name);
+  if (!folder_existence.valid() || !*folder_existence) return std::nullopt;
+
+  Validation validation{Bitfield(data.completed, data.pieces_count),
+                        Bitfield(data.pieces_count)};
+  const auto offsets = files_offsets(descriptor);
+
+  for (int64_t i = 0; i < static_cast<int64_t>(descriptor.files.size()); i++) {
+    const File& file = descriptor.files[i];
+    if (file.length == 0) continue;
+
+    auto stat =
+        platform::io::stat(data.folder_name + '/' + file.filename());
+    if (stat.valid() && stat->size == data.files[i].size &&
+        stat->mtime == data.files[i].mtime)
+      continue;
+
+    // The file changed after the resume data was written, every piece
+    // overlapping it could be corrupt
+    const int64_t first = offsets[i] / descriptor.piece_length;
+    const int64_t last =
+        (offsets[i] + file.length - 1) / descriptor.piece_length;
+    for (int64_t index = first; index <= last; index++) {
+      if (!validation.trusted.get(index)) continue;
+      validation.trusted.unset(index);
+      validation.suspect.set(index);
+    }
+  }
+
+  return validation;
+}
+
+// ======================================================================================
+
+ResumeFile::ResumeFile(std::string filepath, const TorrentFile& descriptor,
+                       Bitfield completed, int64_t batch_pieces,
+                       std::chrono::milliseconds batch_delay)
+    : _dirty{true},
+      _pending{0},
+      _written{Clock::now()},
+      _batch_pieces{batch_pieces},
+      _batch_delay{batch_delay},
+      _unsynced(descriptor.files.size(), false),
+      _filepath{std::move(filepath)},
+      _completed{std::move(completed)},
+      _files_offsets{files_offsets(descriptor)},
+      _piece_length{descriptor.piece_length} {
+  _data.info_hash = descriptor.info_hash;
+  _data.folder_name = descriptor.folder_name;
+  _data.pieces_count = descriptor.pieces_count;
+
+  _files_paths.reserve(descriptor.files.size());
+  _files_lengths.reserve(descriptor.files.size());
+  _data.files.reserve(descriptor.files.size());
+  for (const auto& file : descriptor.files) {
+    _files_paths.push_back(descriptor.folder_name + '/' + file.filename());
+    _files_lengths.push_back(file.length);
+
+    auto stat = platform::io::stat(_files_paths.back());
+    _data.files.push_back(stat.valid() ? *stat
+                                       : platform::io::FileStat{-1, -1});
+  }
+}
+
+ResumeFile::~ResumeFile() {
+  // Pieces whose files could not be synced are left behind by the last write
+  const bool unsynced =
+      std::find(_unsynced.begin(), _unsynced.end(), true) != _unsynced.end();
+  if (_pending > 0 || unsynced) save();
+}
+
+bool ResumeFile::mark_completed(int64_t index) {
+  {
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _completed.set(index);
+
+    // The piece changed every file it overlaps, they are synced before the
+    // piece is written
+    const int64_t piece_begin = index * _piece_length;
+    const int64_t piece_end = piece_begin + _piece_length;
+    auto it = std::upper_bound(_files_offsets.begin(), _files_offsets.end(),
+                               piece_begin);
+    int64_t file = std::distance(_files_offsets.begin(), it) - 1;
+    for (; file < static_cast<int64_t>(_files_offsets.size()) &&
+           _files_offsets[file] < piece_end;
+         file++) {
+      if (_files_lengths[file] > 0) _unsynced[file] = true;
+    }
+
+    _dirty = true;
+    _pending += 1;
+    if (_pending < _batch_pieces && Clock::now() - _written < _batch_delay)
+      return true;
+  }
+  return flush();
+}
+
+bool ResumeFile::save() {
+  {
+    std::scoped_lock<std::mutex> lock(_mutex);
+    _dirty = true;
+  }
+  return flush();
+}
+
+bool ResumeFile::flush() {
+  bool success = true;
+  while (true) {
+    // If someone else is writing they will also pick up our changes
+    std::unique_lock<std::mutex> write_lock(_write_mutex, std::try_to_lock);
+    if (!write_lock.owns_lock()) return success;
+
+    while (true) {
+      std::vector<uint8_t> completed;
+      std::vector<int64_t> unsynced;
+      {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        if (!_dirty) break;
+        _dirty = false;
+        _pending = 0;
+        completed = _completed.get_bytes();
+        for (int64_t file = 0; file < static_cast<int64_t>(_unsynced.size());
+             file++) {
+          if (_unsynced[file]) unsynced.push_back(file);
+          _unsynced[file] = false;
+        }
+      }
+
+      // A piece is never recorded before its content is persisted, the
+      // pieces stay in memory until the next write
+      bool synced = true;
+      for (int64_t file : unsynced) {
+        if (!platform::io::sync(_files_paths[file]).valid()) synced = false;
+      }
+      if (!synced) {
+        std::scoped_lock<std::mutex> lock(_mutex);
+        for (int64_t file : unsynced) _unsynced[file] = true;
+        success = false;
+        break;
+      }
+
+      // Only the writer touches the resume data, the sizes and modification
+      // times are the ones of the content just persisted
+      for (int64_t file : unsynced) {
+        auto stat = platform::io::stat(_files_paths[file]);
+        if (stat.valid()) _data.files[file] = *stat;
+      }
+      _data.completed = std::move(completed);
+      success =
+          platform::io::write_file_atomic(_filepath, encode(_data)).valid();
+
+      std::scoped_lock<std::mutex> lock(_mutex);
+      _written = Clock::now();
+    }
+    write_lock.unlock();
+
+    // Changes made while we were releasing the lock would be left behind
+    std::scoped_lock<std::mutex> lock(_mutex);
+    if (!_dirty) return success;
+  }
+}
+
+}  // namespace fur::resume
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "download/bitfield.hpp"
+#include "hash.hpp"
+#include "platform/io.hpp"
+#include "torrent.hpp"
+#include "util/result.hpp"
+
+/// Fast-resume support: keeps a persistent record of the pieces of a torrent
+/// that have already been saved to disk, so that a restarted download only
+/// asks the peers for the missing ones
+namespace fur::resume {
+
+using download::bitfield::Bitfield;
+
+/// Content of a resume file
+struct ResumeData {
+  /// Info-hash of the torrent the data belongs to
+  hash::hash_t info_hash{};
+  /// Folder containing the files of the torrent
+  std::string folder_name;
+  /// Total number of pieces of the torrent
+  int64_t pieces_count = 0;
+  /// Bitfield of the pieces saved to disk, as raw bytes
+  std::vector<uint8_t> completed;
+  /// Size and modification time of every file of the torrent at the time the
+  /// resume file was written
+  std::vector<platform::io::FileStat> files;
+};
+
+enum class ResumeError {
+  /// The resume file doesn't exist or cannot be read
+  CannotOpenFile,
+  /// The content is truncated or inconsistent
+  Malformed,
+  /// The resume file was written by an incompatible version of Furrent
+  UnsupportedVersion,
+};
+
+/// Serializes resume data to its binary format
+std::vector<uint8_t> encode(const ResumeData& data);
+
+/// Deserializes resume data from its binary format
+util::Result<ResumeData, ResumeError> decode(const std::vector<uint8_t>& bytes);
+
+/// Loads resume data from a file
+util::Result<ResumeData, ResumeError> load(const std::string& filepath);
+
+/// Pieces of a torrent recorded as saved by its resume data
+struct Validation {
+  /// Pieces that don't need to be downloaded again
+  Bitfield trusted;
+  /// Pieces overlapping a file that changed size or has been modified after
+  /// the resume data was written, most likely by pieces saved later. They
+  /// must be verified before they are trusted.
+  Bitfield suspect;
+};
+
+/// Checks resume data against a torrent and the files on disk. This is cheap:
+/// no piece is read or hashed, only the files metadata is compared.
+/// @param data loaded resume data
+/// @param descriptor torrent to resume, its folder name is ignored
+/// @return the pieces recorded as saved or nothing if the data doesn't
+/// describe this torrent at all
+std::optional<Validation> validate(const ResumeData& data,
+                                   const TorrentFile& descriptor);
+
+/// Keeps the resume file of a torrent in sync with the pieces saved to disk.
+/// Completed pieces are written in batches, the files they belong to are
+/// synced first so that a piece is never recorded before its content is
+/// persisted. Can be used concurrently by many workers.
+class ResumeFile {
+  using Clock = std::chrono::steady_clock;
+
+  /// Protects the resume data
+  std::mutex _mutex;
+  /// Allows a single thread to write the file at any time
+  std::mutex _write_mutex;
+  /// True if the data changed since the last write
+  bool _dirty;
+  /// Pieces completed since the last write
+  int64_t _pending;
+  /// When the file was last written
+  Clock::time_point _written;
+  /// Pieces completed that trigger a write
+  int64_t _batch_pieces;
+  /// Longest time a completed piece waits before it is written
+  Clock::duration _batch_delay;
+  /// True for every file written since the last sync
+  std::vector<bool> _unsynced;
+
+  /// Where the resume data is stored
+  std::string _filepath;
+  /// State of the torrent last written, only touched by the thread writing
+  /// the file
+  ResumeData _data;
+  /// Current state of the torrent pieces
+  Bitfield _completed;
+
+  /// Path of every file of the torrent
+  std::vector<std::string> _files_paths;
+  /// Offset of the first byte of every file from the beginning of the torrent
+  std::vector<int64_t> _files_offsets;
+  /// Length of every file
+  std::vector<int64_t> _files_lengths;
+  /// The length, in bytes, of each piece
+  int64_t _piece_length;
+
+ public:
+  /// Constructs the resume file of a torrent whose files are already on disk
+  /// @param filepath where the resume data is stored
+  /// @param descriptor torrent descriptor, with a valid folder name
+  /// @param completed pieces already saved to disk
+  /// @param batch_pieces completed pieces written together, pieces completed
+  /// since the last write are lost if the program stops
+  /// @param batch_delay pieces completed this long after the last write are
+  /// written right away
+  ResumeFile(std::string filepath, const TorrentFile& descriptor,
+             Bitfield completed, int64_t batch_pieces = 1,
+             std::chrono::milliseconds batch_delay = {});
+  /// Writes the pieces completed since the last write, if any
+  ~ResumeFile();
+
+  /// Records a piece as saved to disk, the change is persisted once the
+  /// batch is full or the last write is old enough. Must be called only after
+  /// the piece has been completely written.
+  /// @return False on IO errors
+  bool mark_completed(int64_t index);
+
+  /// Persists the current state, including the pieces of the batch
+  /// @return True if the resume file is up to date, false on IO errors
+  bool save();
+
+ private:
+  /// Syncs the files written and then writes the changes, until there are
+  /// none left or another thread is already writing them
+  bool flush();
+};
+
+}  // namespace fur::resume
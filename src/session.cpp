@@ -0,0 +1,224 @@
+#include "session.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "platform/io.hpp"
+#include "util/binary.hpp"
+
+namespace fur::session {
+
+/// First bytes of every session snapshot, "FURS" in ASCII
+const uint32_t SESSION_MAGIC = 0x53525546;
+/// Must be incremented every time the binary format changes
+const uint32_t SESSION_VERSION = 2;
+
+/// Smallest number of bytes taken by each element of a list, used to reject
+/// counts that cannot possibly fit in the rest of the snapshot
+const int64_t FILE_MIN_BYTES = 16;
+const int64_t PEER_MIN_BYTES = 8;
+
+static void encode_torrent(util::BinaryWriter& writer,
+                           const SessionTorrent& torrent) {
+  const TorrentFile& descriptor = torrent.descriptor;
+  writer.put_string(descriptor.announce_url);
+  writer.put_bytes(descriptor.info_hash.data(),
+                   static_cast<int64_t>(descriptor.info_hash.size()));
+  writer.put_string(descriptor.name);
+  writer.put_string(descriptor.folder_name);
+  writer.put_i64(descriptor.piece_length);
+  writer.put_i64(descriptor.length);
+  writer.put_i64(descriptor.pieces_count);
+
+  writer.put_i64(static_cast<int64_t>(descriptor.files.size()));
+  for (const auto& file : descriptor.files) {
+    writer.put_i64(file.length);
+    writer.put_i64(static_cast<int64_t>(file.filepath.size()));
+    for (const auto& section : file.filepath) writer.put_string(section);
+  }
+
+  // Hashes are stored flat, one after the other
+  for (const auto& hash : descriptor.piece_hashes)
+    writer.put_bytes(hash.data(), static_cast<int64_t>(hash.size()));
+
+  writer.put_i64(static_cast<int64_t>(torrent.file_priorities.size()));
+  for (auto priority : torrent.file_priorities)
+    writer.put_bytes(reinterpret_cast<const uint8_t*>(&priority), 1);
+
+  writer.put_u32((torrent.sequential ? 1u : 0u) |
+                 (torrent.streaming ? 2u : 0u));
+  writer.put_i64(torrent.weight);
+  writer.put_u32(static_cast<uint32_t>(torrent.priority));
+  writer.put_i64(torrent.update_interval);
+  writer.put_i64(static_cast<int64_t>(torrent.peers.size()));
+  for (const auto& peer : torrent.peers) {
+    writer.put_u32(peer.ip);
+    writer.put_u32(peer.port);
+  }
+
+  const auto resume_bytes = resume::encode(torrent.resume);
+  writer.put_i64(static_cast<int64_t>(resume_bytes.size()));
+  writer.put_bytes(resume_bytes.data(),
+                   static_cast<int64_t>(resume_bytes.size()));
+}
+
+/// @return True if the descriptor of a restored torrent holds together, with
+/// the same checks a .torrent file goes through when it is loaded
+static bool consistent(const SessionTorrent& torrent) {
+  const TorrentFile& descriptor = torrent.descriptor;
+  if (descriptor.piece_length <= 0 || descriptor.length < 0 ||
+      descriptor.files.empty())
+    return false;
+
+  int64_t length = 0;
+  for (const auto& file : descriptor.files) {
+    if (file.length < 0 ||
+        file.length > std::numeric_limits<int64_t>::max() - length)
+      return false;
+    length += file.length;
+  }
+  if (length != descriptor.length) return false;
+
+  // Integer ceil division, without overflowing
+  const int64_t pieces_count =
+      descriptor.length / descriptor.piece_length +
+      (descriptor.length % descriptor.piece_length != 0 ? 1 : 0);
+  if (descriptor.pieces_count != pieces_count) return false;
+
+  return torrent.file_priorities.empty() ||
+         torrent.file_priorities.size() == descriptor.files.size();
+}
+
+/// @return false if the counts read are out of bounds or the torrent is
+/// inconsistent, the reader is left failed when the content is truncated
+static bool decode_torrent(util::BinaryReader& reader,
+                           SessionTorrent& torrent) {
+  TorrentFile& descriptor = torrent.descriptor;
+  descriptor.announce_url = reader.get_string();
+  const uint8_t* info_hash = reader.get_bytes(descriptor.info_hash.size());
+  if (info_hash != nullptr)
+    std::copy(info_hash, info_hash + descriptor.info_hash.size(),
+              descriptor.info_hash.begin());
+  descriptor.name = reader.get_string();
+  descriptor.folder_name = reader.get_string();
+  descriptor.piece_length = reader.get_i64();
+  descriptor.length = reader.get_i64();
+  descriptor.pieces_count = reader.get_i64();
+
+  const int64_t files_count = reader.get_i64();
+  if (files_count < 0 || files_count > reader.remaining() / FILE_MIN_BYTES)
+    return false;
+  descriptor.files.resize(files_count);
+  for (auto& file : descriptor.files) {
+    file.length = reader.get_i64();
+    const int64_t sections = reader.get_i64();
+    if (sections < 0 || sections > reader.remaining() / 8) return false;
+    file.filepath.resize(sections);
+    for (auto& section : file.filepath) section = reader.get_string();
+  }
+
+  const int64_t hash_len = static_cast<int64_t>(sizeof(hash::hash_t));
+  if (descriptor.pieces_count < 0 ||
+      descriptor.pieces_count > reader.remaining() / hash_len)
+    return false;
+  const uint8_t* hashes = reader.get_bytes(descriptor.pieces_count * hash_len);
+  if (hashes == nullptr) return false;
+  descriptor.piece_hashes.resize(descriptor.pieces_count);
+  for (auto& hash : descriptor.piece_hashes) {
+    std::copy(hashes, hashes + hash_len, hash.begin());
+    hashes += hash_len;
+  }
+
+  const int64_t priorities = reader.get_i64();
+  if (priorities < 0 || priorities > reader.remaining()) return false;
+  const uint8_t* priority_bytes = reader.get_bytes(priorities);
+  if (priorities > 0 && priority_bytes == nullptr) return false;
+  for (int64_t i = 0; i < priorities; i++) {
+    if (priority_bytes[i] > static_cast<uint8_t>(FilePriority::High))
+      return false;
+    torrent.file_priorities.push_back(FilePriority(priority_bytes[i]));
+  }
+
+  const uint32_t flags = reader.get_u32();
+  torrent.sequential = (flags & 1u) != 0;
+  torrent.streaming = (flags & 2u) != 0;
+  torrent.weight = reader.get_i64();
+  const uint32_t priority = reader.get_u32();
+  if (torrent.weight <= 0 ||
+      priority > static_cast<uint32_t>(TorrentPriority::High))
+    return false;
+  torrent.priority = TorrentPriority(priority);
+  torrent.update_interval = reader.get_i64();
+  const int64_t peers = reader.get_i64();
+  if (peers < 0 || peers > reader.remaining() / PEER_MIN_BYTES) return false;
+  torrent.peers.reserve(peers);
+  for (int64_t i = 0; i < peers; i++) {
+    const uint32_t ip = reader.get_u32();
+    const uint32_t port = reader.get_u32();
+    if (port > std::numeric_limits<uint16_t>::max()) return false;
+    torrent.peers.emplace_back(ip, static_cast<uint16_t>(port));
+  }
+
+  const int64_t resume_len = reader.get_i64();
+  const uint8_t* resume_bytes = reader.get_bytes(resume_len);
+  if (resume_bytes == nullptr) return false;
+  auto resume_data =
+      resume::decode(std::vector<uint8_t>(resume_bytes,
+                                          resume_bytes + resume_len));
+  if (!resume_data.valid()) return false;
+  torrent.resume = std::move(*resume_data);
+  return consistent(torrent);
+}
+
+std::vector<uint8_t> encode(const SessionData& data) {
+  std::vector<uint8_t> bytes;
+  util::BinaryWriter writer(bytes);
+
+  writer.put_u32(SESSION_MAGIC);
+  writer.put_u32(SESSION_VERSION);
+  writer.put_i64(static_cast<int64_t>(data.torrents.size()));
+  for (const auto& torrent : data.torrents) encode_torrent(writer, torrent);
+  return bytes;
+}
+
+util::Result<SessionData, SessionError> decode(std::string_view bytes) {
+  using Result = util::Result<SessionData, SessionError>;
+
+  util::BinaryReader reader(reinterpret_cast<const uint8_t*>(bytes.data()),
+                            static_cast<int64_t>(bytes.size()));
+  if (reader.get_u32() != SESSION_MAGIC)
+    return Result::ERROR(SessionError::Malformed);
+  if (reader.get_u32() != SESSION_VERSION)
+    return Result::ERROR(SessionError::UnsupportedVersion);
+
+  const int64_t torrents_count = reader.get_i64();
+  if (torrents_count < 0 || torrents_count > reader.remaining())
+    return Result::ERROR(SessionError::Malformed);
+
+  SessionData data;
+  data.torrents.resize(torrents_count);
+  for (auto& torrent : data.torrents) {
+    if (!decode_torrent(reader, torrent))
+      return Result::ERROR(SessionError::Malformed);
+  }
+
+  if (!reader.valid() || reader.remaining() != 0)
+    return Result::ERROR(SessionError::Malformed);
+  return Result::OK(std::move(data));
+}
+
+util::Result<SessionData, SessionError> load(const std::string& filepath) {
+  auto mapped = platform::io::MappedFile::open(filepath);
+  if (!mapped.valid()) {
+    return util::Result<SessionData, SessionError>::ERROR(
+        SessionError::CannotOpenFile);
+  }
+  return decode(mapped->view());
+}
+
+bool save(const std::string& filepath, const SessionData& data) {
+  return platform::io::write_file_atomic(filepath, encode(data)).valid();
+}
+
+}  // namespace fur::session
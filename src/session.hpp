@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "peer.hpp"
+#include "resume.hpp"
+#include "torrent.hpp"
+#include "util/result.hpp"
+
+/// Session snapshots: a single binary file describing every torrent of a
+/// session, so that a restart brings all of them back without reading their
+/// .torrent files or waiting for the trackers
+namespace fur::session {
+
+/// A torrent as saved in a session snapshot
+struct SessionTorrent {
+  /// Descriptor of the torrent, with its folder name
+  TorrentFile descriptor;
+  /// Priority of every file, all files are wanted if empty
+  std::vector<FilePriority> file_priorities;
+  /// Download the pieces in order
+  bool sequential = false;
+  /// Write every block to storage as soon as it arrives
+  bool streaming = false;
+  /// Share of the workers relative to the other torrents of the same
+  /// priority
+  int64_t weight = 1;
+  /// Scheduling class of the torrent
+  TorrentPriority priority = TorrentPriority::Normal;
+  /// How often (in seconds) the tracker asked to be announced to
+  int64_t update_interval = 0;
+  /// Peers known when the snapshot was taken
+  std::vector<peer::Peer> peers;
+  /// Pieces saved to disk and state of the files when the snapshot was taken
+  resume::ResumeData resume;
+};
+
+/// Content of a session snapshot
+struct SessionData {
+  std::vector<SessionTorrent> torrents;
+};
+
+enum class SessionError {
+  /// The snapshot doesn't exist or cannot be read
+  CannotOpenFile,
+  /// The content is truncated or inconsistent
+  Malformed,
+  /// The snapshot was written by an incompatible version of Furrent
+  UnsupportedVersion,
+};
+
+/// Serializes a session to its binary format
+std::vector<uint8_t> encode(const SessionData& data);
+
+/// Deserializes a session from its binary format
+util::Result<SessionData, SessionError> decode(std::string_view bytes);
+
+/// Loads a session snapshot, the file is mapped and decoded in place
+util::Result<SessionData, SessionError> load(const std::string& filepath);
+
+/// Writes a session snapshot, replacing the previous one atomically
+/// @return True on success, false on IO errors
+bool save(const std::string& filepath, const SessionData& data);
+
+}  // namespace fur::session
@@ -0,0 +1,315 @@
+#include "sha1.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#include "sha1_kernels.hpp"
+
+namespace fur::hash {
+
+using namespace fur::hash::kernels;
+
+std::vector<Sha1Kernel> supported_kernels() {
+  std::vector<Sha1Kernel> kernels{Sha1Kernel::Portable};
+  if (cpu_has_avx2()) kernels.push_back(Sha1Kernel::Avx2);
+  if (cpu_has_sha_ni()) kernels.push_back(Sha1Kernel::ShaNi);
+  return kernels;
+}
+
+Sha1Kernel best_kernel() {
+  static const Sha1Kernel best = supported_kernels().back();
+  return best;
+}
+
+std::string kernel_name(Sha1Kernel kernel) {
+  switch (kernel) {
+    case Sha1Kernel::Portable:
+      return "portable";
+    case Sha1Kernel::Avx2:
+      return "avx2";
+    case Sha1Kernel::ShaNi:
+      return "sha-ni";
+    default:
+      return "unknown";
+  }
+}
+
+/// @return block function of a kernel
+static Compress kernel_compress(Sha1Kernel kernel) {
+  switch (kernel) {
+    case Sha1Kernel::Avx2:
+      return compress_avx2;
+    case Sha1Kernel::ShaNi:
+      return compress_sha_ni;
+    default:
+      return compress_portable;
+  }
+}
+
+std::vector<Sha1BatchKernel> supported_batch_kernels() {
+  std::vector<Sha1BatchKernel> kernels{Sha1BatchKernel::Sequential};
+#if defined(__x86_64__)
+  kernels.push_back(Sha1BatchKernel::Sse2x4);
+#endif
+  if (cpu_has_avx2()) kernels.push_back(Sha1BatchKernel::Avx2x8);
+  if (cpu_has_avx512()) kernels.push_back(Sha1BatchKernel::Avx512x16);
+  return kernels;
+}
+
+Sha1BatchKernel best_batch_kernel() {
+  static const Sha1BatchKernel best = [] {
+    if (cpu_has_avx512()) return Sha1BatchKernel::Avx512x16;
+    // CPUs with the SHA extensions but without AVX-512 hash a single message
+    // faster than eight lanes of AVX2
+    if (cpu_has_sha_ni()) return Sha1BatchKernel::Sequential;
+    return supported_batch_kernels().back();
+  }();
+  return best;
+}
+
+std::string batch_kernel_name(Sha1BatchKernel kernel) {
+  switch (kernel) {
+    case Sha1BatchKernel::Sequential:
+      return "sequential";
+    case Sha1BatchKernel::Sse2x4:
+      return "sse2x4";
+    case Sha1BatchKernel::Avx2x8:
+      return "avx2x8";
+    case Sha1BatchKernel::Avx512x16:
+      return "avx512x16";
+    default:
+      return "unknown";
+  }
+}
+
+Sha1::Sha1(Sha1Kernel kernel) : _compress{kernel_compress(kernel)} {
+  reset();
+}
+
+void Sha1::reset() {
+  _state = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+  _block_len = 0;
+  _total_len = 0;
+}
+
+void Sha1::resume(const uint32_t* state, int64_t len) {
+  if (len < 0 || len % 64 != 0)
+    throw std::invalid_argument("length is not a multiple of the block size");
+  std::copy(state, state + 5, _state.begin());
+  _block_len = 0;
+  _total_len = static_cast<uint64_t>(len);
+}
+
+void Sha1::update(const uint8_t* bytes, int64_t len) {
+  if (len < 0) throw std::invalid_argument("negative length");
+  if (len == 0) return;
+  _total_len += static_cast<uint64_t>(len);
+
+  // Complete the pending block first
+  if (_block_len > 0) {
+    const int64_t missing = std::min<int64_t>(64 - _block_len, len);
+    std::memcpy(_block.data() + _block_len, bytes, missing);
+    _block_len += missing;
+    bytes += missing;
+    len -= missing;
+
+    if (_block_len < 64) return;
+    _compress(_state.data(), _block.data(), 1);
+    _block_len = 0;
+  }
+
+  // Whole blocks are hashed straight from the input
+  const int64_t blocks = len / 64;
+  _compress(_state.data(), bytes, blocks);
+  bytes += blocks * 64;
+  len -= blocks * 64;
+
+  if (len > 0) std::memcpy(_block.data(), bytes, len);
+  _block_len = len;
+}
+
+hash_t Sha1::finish() {
+  const uint64_t total_bits = _total_len * 8;
+
+  // Padding is a single 1 bit followed by zeroes up to 8 bytes before the end
+  // of a block, then the length of the message in bits
+  _block[_block_len++] = 0x80;
+  if (_block_len > 56) {
+    std::memset(_block.data() + _block_len, 0, 64 - _block_len);
+    _compress(_state.data(), _block.data(), 1);
+    _block_len = 0;
+  }
+  std::memset(_block.data() + _block_len, 0, 56 - _block_len);
+  for (int i = 0; i < 8; i++)
+    _block[56 + i] = static_cast<uint8_t>(total_bits >> (56 - i * 8));
+  _compress(_state.data(), _block.data(), 1);
+
+  hash_t hash;
+  for (int i = 0; i < 20; i++)
+    hash[i] = static_cast<uint8_t>(_state[i / 4] >> (24 - (i % 4) * 8));
+  return hash;
+}
+
+hash_t Sha1::digest(const uint8_t* bytes, int64_t len, Sha1Kernel kernel) {
+  Sha1 sha1(kernel);
+  sha1.update(bytes, len);
+  return sha1.finish();
+}
+
+// ======================================================================================
+
+/// Hash up to LANES messages together, lanes without a message repeat the
+/// first one. The lanes share the blocks all messages have in common, then
+/// each message is completed on its own.
+template <int LANES>
+static void digest_lanes(CompressMulti compress, const Message* messages,
+                         const int64_t* indices, int64_t count,
+                         hash_t* hashes) {
+  const uint32_t INITIAL[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+                               0xc3d2e1f0};
+
+  uint32_t states[5 * LANES];
+  const uint8_t* blocks[LANES];
+  int64_t common = messages[indices[0]].len / 64;
+  for (int lane = 0; lane < LANES; lane++) {
+    const Message& message = messages[indices[lane < count ? lane : 0]];
+    blocks[lane] = message.bytes;
+    common = std::min(common, message.len / 64);
+    for (int i = 0; i < 5; i++) states[i * LANES + lane] = INITIAL[i];
+  }
+
+  compress(states, blocks, common);
+
+  Sha1 sha1;
+  for (int64_t lane = 0; lane < count; lane++) {
+    const Message& message = messages[indices[lane]];
+    uint32_t state[5];
+    for (int i = 0; i < 5; i++) state[i] = states[i * LANES + lane];
+
+    sha1.resume(state, common * 64);
+    sha1.update(message.bytes + common * 64, message.len - common * 64);
+    hashes[indices[lane]] = sha1.finish();
+  }
+}
+
+template <int LANES>
+static void digest_batch_lanes(CompressMulti compress, const Message* messages,
+                               int64_t count, hash_t* hashes) {
+  // Grouping messages of similar length leaves fewer blocks to hash one
+  // message at a time after the common ones
+  std::vector<int64_t> indices(count);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::stable_sort(indices.begin(), indices.end(), [&](int64_t a, int64_t b) {
+    return messages[a].len > messages[b].len;
+  });
+
+  for (int64_t first = 0; first < count; first += LANES) {
+    const int64_t group = std::min<int64_t>(LANES, count - first);
+    digest_lanes<LANES>(compress, messages, indices.data() + first, group,
+                        hashes);
+  }
+}
+
+void digest_batch(const Message* messages, int64_t count, hash_t* hashes,
+                  Sha1BatchKernel kernel) {
+  if (count < 0) throw std::invalid_argument("negative count");
+
+  switch (kernel) {
+    case Sha1BatchKernel::Sse2x4:
+      digest_batch_lanes<4>(compress_multi_sse2, messages, count, hashes);
+      break;
+    case Sha1BatchKernel::Avx2x8:
+      digest_batch_lanes<8>(compress_multi_avx2, messages, count, hashes);
+      break;
+    case Sha1BatchKernel::Avx512x16:
+      digest_batch_lanes<16>(compress_multi_avx512, messages, count, hashes);
+      break;
+    default:
+      for (int64_t i = 0; i < count; i++)
+        hashes[i] = Sha1::digest(messages[i].bytes, messages[i].len);
+      break;
+  }
+}
+
+// ======================================================================================
+
+StreamingHasher::StreamingHasher(const uint8_t* piece, int64_t len)
+    : _piece{piece}, _len{len}, _hashed{0} {}
+
+void StreamingHasher::received(int64_t offset, int64_t len) {
+  if (offset < 0 || len < 0 || offset + len > _len)
+    throw std::invalid_argument("block outside of the piece");
+
+  // Remember blocks after a gap, keeping the widest one for each offset
+  if (offset > _hashed) {
+    int64_t& end = _pending[offset];
+    end = std::max(end, offset + len);
+    return;
+  }
+
+  // Hash the new prefix and then every pending block it reaches
+  int64_t end = offset + len;
+  while (true) {
+    if (end > _hashed) {
+      _sha1.update(_piece + _hashed, end - _hashed);
+      _hashed = end;
+    }
+
+    auto next = _pending.begin();
+    if (next == _pending.end() || next->first > _hashed) break;
+    end = next->second;
+    _pending.erase(next);
+  }
+}
+
+bool StreamingHasher::complete() const { return _hashed == _len; }
+
+hash_t StreamingHasher::finish() { return _sha1.finish(); }
+
+BlockHasher::BlockHasher(int64_t len) : _len{len}, _hashed{0}, _buffered{0} {}
+
+void BlockHasher::received(int64_t offset, const uint8_t* bytes, int64_t len) {
+  if (offset < 0 || len < 0 || offset + len > _len)
+    throw std::invalid_argument("block outside of the piece");
+
+  // Keep a copy of blocks after a gap, the widest one for each offset
+  if (offset > _hashed) {
+    std::vector<uint8_t>& pending = _pending[offset];
+    if (static_cast<int64_t>(pending.size()) < len) {
+      _buffered += len - static_cast<int64_t>(pending.size());
+      pending.assign(bytes, bytes + len);
+    }
+    return;
+  }
+
+  // Only the bytes after the hashed prefix are new
+  if (offset + len > _hashed) {
+    _sha1.update(bytes + (_hashed - offset), offset + len - _hashed);
+    _hashed = offset + len;
+  }
+
+  // Then every pending block the prefix reaches
+  while (true) {
+    auto next = _pending.begin();
+    if (next == _pending.end() || next->first > _hashed) break;
+
+    const int64_t size = static_cast<int64_t>(next->second.size());
+    if (next->first + size > _hashed) {
+      _sha1.update(next->second.data() + (_hashed - next->first),
+                   next->first + size - _hashed);
+      _hashed = next->first + size;
+    }
+    _buffered -= size;
+    _pending.erase(next);
+  }
+}
+
+bool BlockHasher::complete() const { return _hashed == _len; }
+
+int64_t BlockHasher::buffered() const { return _buffered; }
+
+hash_t BlockHasher::finish() { return _sha1.finish(); }
+
+}  // namespace fur::hash
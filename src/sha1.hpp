@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hash.hpp"
+
+namespace fur::hash {
+
+/// Implementations of the SHA-1 block function
+enum class Sha1Kernel {
+  /// Plain C++, runs everywhere
+  Portable,
+  /// Message schedule computed with vector instructions
+  Avx2,
+  /// Dedicated SHA extensions of x86 CPUs
+  ShaNi,
+};
+
+/// @return all kernels the running CPU can execute, slowest first
+std::vector<Sha1Kernel> supported_kernels();
+
+/// @return fastest kernel the running CPU can execute, detected once
+Sha1Kernel best_kernel();
+
+/// @return human readable name of a kernel
+std::string kernel_name(Sha1Kernel kernel);
+
+/// Implementations that hash several messages at once
+enum class Sha1BatchKernel {
+  /// One message after the other with the best single message kernel
+  Sequential,
+  /// Four messages in the lanes of SSE2 registers
+  Sse2x4,
+  /// Eight messages in the lanes of AVX2 registers
+  Avx2x8,
+  /// Sixteen messages in the lanes of AVX-512 registers
+  Avx512x16,
+};
+
+/// @return all batch kernels the running CPU can execute
+std::vector<Sha1BatchKernel> supported_batch_kernels();
+
+/// @return fastest batch kernel the running CPU can execute, detected once
+Sha1BatchKernel best_batch_kernel();
+
+/// @return human readable name of a batch kernel
+std::string batch_kernel_name(Sha1BatchKernel kernel);
+
+/// Incremental SHA-1 context, bytes can be fed in pieces of any size
+class Sha1 {
+  /// Block function of the selected kernel
+  void (*_compress)(uint32_t* state, const uint8_t* blocks, int64_t count);
+  /// Intermediate hash value
+  std::array<uint32_t, 5> _state;
+  /// Bytes not yet processed because they don't fill a whole block
+  std::array<uint8_t, 64> _block;
+  /// Number of bytes in `_block`
+  int64_t _block_len;
+  /// Number of bytes fed so far
+  uint64_t _total_len;
+
+ public:
+  /// @param kernel block function to use, must be supported by the CPU
+  explicit Sha1(Sha1Kernel kernel = best_kernel());
+
+  /// Restart from an empty message
+  void reset();
+
+  /// Continue a message whose first bytes were hashed somewhere else
+  /// @param state intermediate hash value after those bytes
+  /// @param len number of bytes already hashed, must be a multiple of 64
+  void resume(const uint32_t* state, int64_t len);
+
+  /// Feed more bytes of the message
+  void update(const uint8_t* bytes, int64_t len);
+
+  /// Complete the message and return its hash, the context must be reset
+  /// before being used again
+  hash_t finish();
+
+  /// Hash a whole message at once
+  static hash_t digest(const uint8_t* bytes, int64_t len,
+                       Sha1Kernel kernel = best_kernel());
+};
+
+/// A message to hash as part of a batch
+struct Message {
+  const uint8_t* bytes;
+  int64_t len;
+};
+
+/// Hash many independent messages. Messages of similar length are hashed
+/// together in the lanes of vector registers, which is faster than hashing
+/// them one at a time when the CPU lacks the SHA extensions.
+/// @param hashes array of `count` hashes filled with the result
+void digest_batch(const Message* messages, int64_t count, hash_t* hashes,
+                  Sha1BatchKernel kernel = best_batch_kernel());
+
+/// Hashes a piece while its blocks arrive in any order. Blocks are stored in
+/// the piece memory by the caller, the hasher only remembers which ranges
+/// arrived out of order and hashes them as soon as the gap before them is
+/// filled, while they are likely still in cache.
+class StreamingHasher {
+  Sha1 _sha1;
+  /// Memory of the whole piece
+  const uint8_t* _piece;
+  /// Length of the piece
+  int64_t _len;
+  /// Length of the prefix of the piece already hashed
+  int64_t _hashed;
+  /// Ranges received after a gap, from begin to end
+  std::map<int64_t, int64_t> _pending;
+
+ public:
+  /// @param piece memory where the blocks of the piece are stored
+  /// @param len length of the piece
+  StreamingHasher(const uint8_t* piece, int64_t len);
+
+  /// Signal that a block has been written to the piece memory
+  /// @param offset offset of the block from the beginning of the piece
+  /// @param len length of the block
+  void received(int64_t offset, int64_t len);
+
+  /// @return True if every byte of the piece has been hashed
+  [[nodiscard]] bool complete() const;
+
+  /// @return hash of the piece, only valid once complete
+  hash_t finish();
+};
+
+/// Hashes a piece whose blocks are not kept in memory, for example because
+/// they are written to storage as soon as they arrive. Blocks received after a
+/// gap are copied and kept only until the gap is filled, so the memory used
+/// depends on how much out of order the blocks arrive and not on the length of
+/// the piece.
+class BlockHasher {
+  Sha1 _sha1;
+  /// Length of the piece
+  int64_t _len;
+  /// Length of the prefix of the piece already hashed
+  int64_t _hashed;
+  /// Copies of the blocks received after a gap, by offset
+  std::map<int64_t, std::vector<uint8_t>> _pending;
+  /// Bytes held in `_pending`
+  int64_t _buffered;
+
+ public:
+  /// @param len length of the piece
+  explicit BlockHasher(int64_t len);
+
+  /// Hash a block or keep a copy until the bytes before it arrive
+  /// @param offset offset of the block from the beginning of the piece
+  /// @param bytes content of the block
+  /// @param len length of the block
+  void received(int64_t offset, const uint8_t* bytes, int64_t len);
+
+  /// @return True if every byte of the piece has been hashed
+  [[nodiscard]] bool complete() const;
+
+  /// @return bytes of the blocks waiting for a gap to be filled
+  [[nodiscard]] int64_t buffered() const;
+
+  /// @return hash of the piece, only valid once complete
+  hash_t finish();
+};
+
+}  // namespace fur::hash
@@ -0,0 +1,281 @@
+#include "sha1_kernels.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace fur::hash::kernels {
+
+/// Round constants, one for every group of 20 rounds
+static const uint32_t K[4] = {0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6};
+
+static inline uint32_t rol(uint32_t value, int steps) {
+  return (value << steps) | (value >> (32 - steps));
+}
+
+static inline uint32_t load_be32(const uint8_t* bytes) {
+  return (static_cast<uint32_t>(bytes[0]) << 24) |
+         (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) |
+         static_cast<uint32_t>(bytes[3]);
+}
+
+/// Boolean functions of the four groups of rounds
+struct Choose {
+  static uint32_t f(uint32_t b, uint32_t c, uint32_t d) {
+    return d ^ (b & (c ^ d));
+  }
+};
+struct Parity {
+  static uint32_t f(uint32_t b, uint32_t c, uint32_t d) { return b ^ c ^ d; }
+};
+struct Majority {
+  static uint32_t f(uint32_t b, uint32_t c, uint32_t d) {
+    return (b & c) | (d & (b | c));
+  }
+};
+
+/// A single round. Instead of shifting all the variables every round, the
+/// callers rotate the names of the arguments.
+template <typename F>
+static inline void round(uint32_t a, uint32_t& b, uint32_t c, uint32_t d,
+                         uint32_t& e, uint32_t wk) {
+  e += rol(a, 5) + F::f(b, c, d) + wk;
+  b = rol(b, 30);
+}
+
+/// Twenty rounds using the same boolean function and round constant. When
+/// `schedule` is set the message words are expanded here, right before they
+/// are used, otherwise `wk` must already contain them added to the constant.
+template <typename F, bool schedule>
+static inline void round_group(uint32_t& a, uint32_t& b, uint32_t& c,
+                               uint32_t& d, uint32_t& e, uint32_t* wk,
+                               int first, uint32_t k) {
+  // Computing the schedule inside the rounds also keeps the compiler from
+  // vectorizing its recurrence, which stalls on store forwarding
+  auto word = [&](int i) {
+    if (!schedule) return wk[i];
+    if (i >= 16)
+      wk[i] = rol(wk[i - 3] ^ wk[i - 8] ^ wk[i - 14] ^ wk[i - 16], 1);
+    return wk[i] + k;
+  };
+
+  for (int i = first; i < first + 20; i += 5) {
+    round<F>(a, b, c, d, e, word(i));
+    round<F>(e, a, b, c, d, word(i + 1));
+    round<F>(d, e, a, b, c, word(i + 2));
+    round<F>(c, d, e, a, b, word(i + 3));
+    round<F>(b, c, d, e, a, word(i + 4));
+  }
+}
+
+/// The 80 rounds of a block
+template <bool schedule>
+static inline void rounds(uint32_t* state, uint32_t* wk) {
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+           e = state[4];
+
+  round_group<Choose, schedule>(a, b, c, d, e, wk, 0, K[0]);
+  round_group<Parity, schedule>(a, b, c, d, e, wk, 20, K[1]);
+  round_group<Majority, schedule>(a, b, c, d, e, wk, 40, K[2]);
+  round_group<Parity, schedule>(a, b, c, d, e, wk, 60, K[3]);
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+void compress_portable(uint32_t* state, const uint8_t* blocks, int64_t count) {
+  uint32_t w[80];
+  for (int64_t block = 0; block < count; block++, blocks += 64) {
+    for (int i = 0; i < 16; i++) w[i] = load_be32(blocks + i * 4);
+    rounds<true>(state, w);
+  }
+}
+
+#if defined(__x86_64__)
+
+/// @return True if the OS saves on context switches all the registers
+/// selected by `mask` in XCR0
+static bool os_saves_registers(unsigned int mask) {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  if ((ecx & bit_OSXSAVE) == 0) return false;
+
+  unsigned int xcr0_lo, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  return (xcr0_lo & mask) == mask;
+}
+
+bool cpu_has_avx2() {
+  // XMM and YMM registers
+  if (!os_saves_registers(0x6)) return false;
+
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  return (ebx & bit_AVX2) != 0 && (ebx & bit_BMI2) != 0;
+}
+
+bool cpu_has_avx512() {
+  // XMM, YMM, opmask and ZMM registers
+  if (!os_saves_registers(0xe6)) return false;
+
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  return (ebx & bit_AVX512F) != 0;
+}
+
+bool cpu_has_sha_ni() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  if ((ecx & bit_SSE4_1) == 0 || (ecx & bit_SSSE3) == 0) return false;
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  return (ebx & bit_SHA) != 0;
+}
+
+/// Rotate every lane left by `steps`
+__attribute__((target("avx2"))) static inline __m128i rol_epi32(__m128i value,
+                                                                int steps) {
+  return _mm_or_si128(_mm_slli_epi32(value, steps),
+                      _mm_srli_epi32(value, 32 - steps));
+}
+
+/// The message schedule is computed four words at a time keeping the last
+/// sixteen words in registers. The last of the four words depends on the
+/// first one, so it is computed without it and then fixed up.
+__attribute__((target("avx2,bmi2"))) void compress_avx2(uint32_t* state,
+                                                        const uint8_t* blocks,
+                                                        int64_t count) {
+  alignas(16) uint32_t wk[80];
+  const __m128i BSWAP = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7,
+                                     0, 1, 2, 3);
+
+  for (int64_t block = 0; block < count; block++, blocks += 64) {
+    // Words from i-16 to i-1
+    __m128i w[4];
+    for (int i = 0; i < 4; i++) {
+      w[i] = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * 16)),
+          BSWAP);
+      _mm_store_si128(
+          reinterpret_cast<__m128i*>(wk + i * 4),
+          _mm_add_epi32(w[i], _mm_set1_epi32(static_cast<int>(K[0]))));
+    }
+
+    for (int i = 16; i < 80; i += 4) {
+      const __m128i w_minus_3 = _mm_srli_si128(w[3], 4);
+      const __m128i w_minus_14 = _mm_alignr_epi8(w[1], w[0], 8);
+      __m128i words = _mm_xor_si128(_mm_xor_si128(w_minus_3, w[2]),
+                                    _mm_xor_si128(w_minus_14, w[0]));
+      words = rol_epi32(words, 1);
+      // The last word is missing rol(w[i], 1)
+      words = _mm_xor_si128(words, rol_epi32(_mm_slli_si128(words, 12), 1));
+
+      w[0] = w[1];
+      w[1] = w[2];
+      w[2] = w[3];
+      w[3] = words;
+      _mm_store_si128(
+          reinterpret_cast<__m128i*>(wk + i),
+          _mm_add_epi32(words, _mm_set1_epi32(static_cast<int>(K[i / 20]))));
+    }
+
+    rounds<false>(state, wk);
+  }
+}
+
+/// Four rounds of the SHA extensions. Every group consumes the four message
+/// words in `msg[G % 4]` and prepares the words of the following groups. The
+/// E value alternates between `e0` and `e1`.
+template <int G>
+__attribute__((target("sha,sse4.1"))) static inline void sha_ni_group(
+    __m128i& abcd, __m128i& e0, __m128i& e1, __m128i* msg) {
+  constexpr int F = G / 5;
+  const __m128i current = msg[G % 4];
+
+  if constexpr (G == 0) {
+    e0 = _mm_add_epi32(e0, current);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, F);
+  } else if constexpr (G % 2 == 1) {
+    e1 = _mm_sha1nexte_epu32(e1, current);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, F);
+  } else {
+    e0 = _mm_sha1nexte_epu32(e0, current);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, F);
+  }
+
+  if constexpr (G >= 3 && G <= 18)
+    msg[(G + 1) % 4] = _mm_sha1msg2_epu32(msg[(G + 1) % 4], current);
+  if constexpr (G >= 1 && G <= 16)
+    msg[(G + 3) % 4] = _mm_sha1msg1_epu32(msg[(G + 3) % 4], current);
+  if constexpr (G >= 2 && G <= 17)
+    msg[(G + 2) % 4] = _mm_xor_si128(msg[(G + 2) % 4], current);
+}
+
+template <int... G>
+__attribute__((target("sha,sse4.1"))) static inline void sha_ni_groups(
+    __m128i& abcd, __m128i& e0, __m128i& e1, __m128i* msg,
+    std::integer_sequence<int, G...>) {
+  (sha_ni_group<G>(abcd, e0, e1, msg), ...);
+}
+
+__attribute__((target("sha,sse4.1"))) void compress_sha_ni(
+    uint32_t* state, const uint8_t* blocks, int64_t count) {
+  const __m128i BSWAP =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+  // The extensions want A in the highest lane
+  __m128i abcd = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+  __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+  __m128i e1;
+
+  for (int64_t block = 0; block < count; block++, blocks += 64) {
+    const __m128i abcd_save = abcd;
+    const __m128i e0_save = e0;
+
+    __m128i msg[4];
+    for (int i = 0; i < 4; i++) {
+      msg[i] = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * 16)),
+          BSWAP);
+    }
+
+    sha_ni_groups(abcd, e0, e1, msg, std::make_integer_sequence<int, 20>{});
+
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+#else
+
+bool cpu_has_avx2() { return false; }
+bool cpu_has_avx512() { return false; }
+bool cpu_has_sha_ni() { return false; }
+
+void compress_avx2(uint32_t*, const uint8_t*, int64_t) {
+  throw std::logic_error("AVX2 kernel is only available on x86-64");
+}
+
+void compress_sha_ni(uint32_t*, const uint8_t*, int64_t) {
+  throw std::logic_error("SHA-NI kernel is only available on x86-64");
+}
+
+#endif
+
+}  // namespace fur::hash::kernels
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+/// Block functions behind hash::Sha1, all of them process `count` consecutive
+/// blocks of 64 bytes updating the five words of `state`
+namespace fur::hash::kernels {
+
+/// Signature shared by all block functions
+using Compress = void (*)(uint32_t* state, const uint8_t* blocks,
+                          int64_t count);
+
+void compress_portable(uint32_t* state, const uint8_t* blocks, int64_t count);
+
+/// Requires AVX2 and BMI2, see `cpu_has_avx2`
+void compress_avx2(uint32_t* state, const uint8_t* blocks, int64_t count);
+
+/// Requires the SHA extensions and SSE4.1, see `cpu_has_sha_ni`
+void compress_sha_ni(uint32_t* state, const uint8_t* blocks, int64_t count);
+
+/// Multi-buffer block functions hash LANES independent messages at once, one
+/// in each lane of a vector register. They process `count` blocks of every
+/// message, `blocks[lane]` points to the first block of each message and
+/// word `i` of the state of a lane is at `states[i * LANES + lane]`.
+using CompressMulti = void (*)(uint32_t* states, const uint8_t* const* blocks,
+                               int64_t count);
+
+/// Four lanes, requires SSE2 which every x86-64 CPU has
+void compress_multi_sse2(uint32_t* states, const uint8_t* const* blocks,
+                         int64_t count);
+
+/// Eight lanes, requires AVX2, see `cpu_has_avx2`
+void compress_multi_avx2(uint32_t* states, const uint8_t* const* blocks,
+                         int64_t count);
+
+/// Sixteen lanes, requires AVX-512F, see `cpu_has_avx512`
+void compress_multi_avx512(uint32_t* states, const uint8_t* const* blocks,
+                           int64_t count);
+
+/// @return True if the CPU and the OS support AVX2 and BMI2
+bool cpu_has_avx2();
+
+/// @return True if the CPU and the OS support AVX-512F
+bool cpu_has_avx512();
+
+/// @return True if the CPU supports the SHA extensions and SSE4.1
+bool cpu_has_sha_ni();
+
+}  // namespace fur::hash::kernels
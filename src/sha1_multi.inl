@@ -0,0 +1,88 @@
+// Multi-buffer SHA-1 shared by the sha1_multi_*.cpp files. Every file selects
+// its instruction set, defines the `Lanes` traits and then includes this, see
+// sha1_kernels.hpp for the interface.
+
+namespace {
+
+/// Round constants, one for every group of 20 rounds
+const uint32_t MULTI_K[4] = {0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6};
+
+/// Big endian 32 bits word
+inline uint32_t multi_load_be32(const uint8_t* bytes) {
+  return (static_cast<uint32_t>(bytes[0]) << 24) |
+         (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) |
+         static_cast<uint32_t>(bytes[3]);
+}
+
+/// Round I of every lane. Instead of shifting the variables every round, the
+/// names rotate: `x[(5 - I % 5) % 5]` is `a` in round I, the next slot is `b`
+/// and so on. With I known at compile time everything stays in registers.
+template <typename L, int I>
+inline void multi_round(typename L::Vector* x, typename L::Vector* w) {
+  using V = typename L::Vector;
+  V& a = x[(5 - I % 5) % 5];
+  V& b = x[(6 - I % 5) % 5];
+  V& c = x[(7 - I % 5) % 5];
+  V& d = x[(8 - I % 5) % 5];
+  V& e = x[(9 - I % 5) % 5];
+
+  if constexpr (I >= 16) {
+    w[I % 16] = L::template rol<1>(L::xor3(
+        w[(I - 3) % 16], w[(I - 8) % 16],
+        L::bitxor(w[(I - 14) % 16], w[I % 16])));
+  }
+
+  V f;
+  if constexpr (I < 20)
+    f = L::choose(b, c, d);
+  else if constexpr (I < 40 || I >= 60)
+    f = L::xor3(b, c, d);
+  else
+    f = L::majority(b, c, d);
+
+  e = L::add(L::add(e, L::template rol<5>(a)),
+             L::add(f, L::add(w[I % 16], L::set1(MULTI_K[I / 20]))));
+  b = L::template rol<30>(b);
+}
+
+template <typename L, int... I>
+inline void multi_rounds(typename L::Vector* x, typename L::Vector* w,
+                         std::integer_sequence<int, I...>) {
+  (multi_round<L, I>(x, w), ...);
+}
+
+/// Same as the scalar kernel with every variable spread over the lanes
+template <typename L>
+void compress_multi(uint32_t* states, const uint8_t* const* blocks,
+                    int64_t count) {
+  using V = typename L::Vector;
+  constexpr int LANES = L::LANES;
+
+  // Message words transposed so that each vector holds the same word of
+  // every message
+  alignas(64) uint32_t transposed[16 * LANES];
+
+  V state[5];
+  for (int i = 0; i < 5; i++) state[i] = L::load(states + i * LANES);
+
+  for (int64_t block = 0; block < count; block++) {
+    for (int lane = 0; lane < LANES; lane++) {
+      const uint8_t* bytes = blocks[lane] + block * 64;
+      for (int i = 0; i < 16; i++)
+        transposed[i * LANES + lane] = multi_load_be32(bytes + i * 4);
+    }
+
+    V w[16];
+    for (int i = 0; i < 16; i++) w[i] = L::load(transposed + i * LANES);
+
+    // After 80 rounds the names are back in their original slots
+    V x[5] = {state[0], state[1], state[2], state[3], state[4]};
+    multi_rounds<L>(x, w, std::make_integer_sequence<int, 80>());
+    for (int i = 0; i < 5; i++) state[i] = L::add(state[i], x[i]);
+  }
+
+  for (int i = 0; i < 5; i++) L::store(states + i * LANES, state[i]);
+}
+
+}  // namespace
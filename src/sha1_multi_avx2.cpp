@@ -0,0 +1,72 @@
+#include "sha1_kernels.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__)
+
+// Everything below, including the shared template, is compiled for AVX2. A
+// target attribute on the entry point alone is not enough because GCC refuses
+// to inline the generic helpers into it.
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+
+namespace fur::hash::kernels {
+namespace {
+
+/// Eight lanes of 32 bits in an AVX2 register
+struct Lanes {
+  using Vector = __m256i;
+  static constexpr int LANES = 8;
+
+  static Vector load(const uint32_t* words) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+  }
+  static void store(uint32_t* words, Vector value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(words), value);
+  }
+  static Vector set1(uint32_t value) {
+    return _mm256_set1_epi32(static_cast<int>(value));
+  }
+  static Vector add(Vector a, Vector b) { return _mm256_add_epi32(a, b); }
+  static Vector bitxor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+  static Vector xor3(Vector a, Vector b, Vector c) {
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+  }
+  static Vector choose(Vector b, Vector c, Vector d) {
+    return _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+  }
+  static Vector majority(Vector b, Vector c, Vector d) {
+    return _mm256_or_si256(_mm256_and_si256(b, c),
+                           _mm256_and_si256(d, _mm256_or_si256(b, c)));
+  }
+  template <int STEPS>
+  static Vector rol(Vector value) {
+    return _mm256_or_si256(_mm256_slli_epi32(value, STEPS),
+                           _mm256_srli_epi32(value, 32 - STEPS));
+  }
+};
+
+}  // namespace
+
+#include "sha1_multi.inl"
+
+void compress_multi_avx2(uint32_t* states, const uint8_t* const* blocks,
+                         int64_t count) {
+  compress_multi<Lanes>(states, blocks, count);
+}
+
+}  // namespace fur::hash::kernels
+
+#else
+
+namespace fur::hash::kernels {
+
+void compress_multi_avx2(uint32_t*, const uint8_t* const*, int64_t) {
+  throw std::logic_error("AVX2 kernel is only available on x86-64");
+}
+
+}  // namespace fur::hash::kernels
+
+#endif
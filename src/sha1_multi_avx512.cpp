@@ -0,0 +1,72 @@
+#include "sha1_kernels.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__)
+
+// Everything below, including the shared template, is compiled for AVX-512F,
+// see sha1_multi_avx2.cpp
+#pragma GCC target("avx512f")
+
+#include <immintrin.h>
+
+namespace fur::hash::kernels {
+namespace {
+
+/// Sixteen lanes of 32 bits in an AVX-512 register. The boolean functions
+/// map to a single ternary logic instruction each.
+struct Lanes {
+  using Vector = __m512i;
+  static constexpr int LANES = 16;
+
+  static Vector load(const uint32_t* words) {
+    return _mm512_loadu_si512(words);
+  }
+  static void store(uint32_t* words, Vector value) {
+    _mm512_storeu_si512(words, value);
+  }
+  static Vector set1(uint32_t value) {
+    return _mm512_set1_epi32(static_cast<int>(value));
+  }
+  static Vector add(Vector a, Vector b) { return _mm512_add_epi32(a, b); }
+  static Vector bitxor(Vector a, Vector b) { return _mm512_xor_si512(a, b); }
+  static Vector xor3(Vector a, Vector b, Vector c) {
+    return _mm512_ternarylogic_epi32(a, b, c, 0x96);
+  }
+  static Vector choose(Vector b, Vector c, Vector d) {
+    return _mm512_ternarylogic_epi32(b, c, d, 0xca);
+  }
+  static Vector majority(Vector b, Vector c, Vector d) {
+    return _mm512_ternarylogic_epi32(b, c, d, 0xe8);
+  }
+  // The unmasked _mm512_rol_epi32 trips a false maybe-uninitialized warning
+  // in the GCC 12 headers, a full mask compiles to the same instruction
+  template <int STEPS>
+  static Vector rol(Vector value) {
+    return _mm512_maskz_rol_epi32(0xffff, value, STEPS);
+  }
+};
+
+}  // namespace
+
+#include "sha1_multi.inl"
+
+void compress_multi_avx512(uint32_t* states, const uint8_t* const* blocks,
+                           int64_t count) {
+  compress_multi<Lanes>(states, blocks, count);
+}
+
+}  // namespace fur::hash::kernels
+
+#else
+
+namespace fur::hash::kernels {
+
+void compress_multi_avx512(uint32_t*, const uint8_t* const*, int64_t) {
+  throw std::logic_error("AVX-512 kernel is only available on x86-64");
+}
+
+}  // namespace fur::hash::kernels
+
+#endif
@@ -0,0 +1,67 @@
+#include "sha1_kernels.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+namespace fur::hash::kernels {
+namespace {
+
+/// Four lanes of 32 bits in an SSE2 register
+struct Lanes {
+  using Vector = __m128i;
+  static constexpr int LANES = 4;
+
+  static Vector load(const uint32_t* words) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+  }
+  static void store(uint32_t* words, Vector value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(words), value);
+  }
+  static Vector set1(uint32_t value) {
+    return _mm_set1_epi32(static_cast<int>(value));
+  }
+  static Vector add(Vector a, Vector b) { return _mm_add_epi32(a, b); }
+  static Vector bitxor(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+  static Vector xor3(Vector a, Vector b, Vector c) {
+    return _mm_xor_si128(_mm_xor_si128(a, b), c);
+  }
+  static Vector choose(Vector b, Vector c, Vector d) {
+    return _mm_xor_si128(d, _mm_and_si128(b, _mm_xor_si128(c, d)));
+  }
+  static Vector majority(Vector b, Vector c, Vector d) {
+    return _mm_or_si128(_mm_and_si128(b, c),
+                        _mm_and_si128(d, _mm_or_si128(b, c)));
+  }
+  template <int STEPS>
+  static Vector rol(Vector value) {
+    return _mm_or_si128(_mm_slli_epi32(value, STEPS),
+                        _mm_srli_epi32(value, 32 - STEPS));
+  }
+};
+
+}  // namespace
+
+#include "sha1_multi.inl"
+
+void compress_multi_sse2(uint32_t* states, const uint8_t* const* blocks,
+                         int64_t count) {
+  compress_multi<Lanes>(states, blocks, count);
+}
+
+}  // namespace fur::hash::kernels
+
+#else
+
+namespace fur::hash::kernels {
+
+void compress_multi_sse2(uint32_t*, const uint8_t* const*, int64_t) {
+  throw std::logic_error("SSE2 kernel is only available on x86-64");
+}
+
+}  // namespace fur::hash::kernels
+
+#endif
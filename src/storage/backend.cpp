@@ -0,0 +1,27 @@
+#include "storage/backend.hpp"
+
+#include <algorithm>
+
+namespace fur::storage {
+
+std::optional<std::vector<BlockSlice>> split_block(const Piece& piece,
+                                                   int64_t offset,
+                                                   int64_t len) {
+  std::vector<BlockSlice> slices;
+  int64_t piece_offset = 0;
+  for (const auto& subpiece : piece.subpieces) {
+    const int64_t begin = std::max(offset, piece_offset);
+    const int64_t end = std::min(offset + len, piece_offset + subpiece.len);
+    if (begin < end) {
+      slices.push_back({&subpiece.filepath, begin - offset,
+                        subpiece.file_offset + (begin - piece_offset),
+                        end - begin});
+    }
+    piece_offset += subpiece.len;
+  }
+
+  if (offset < 0 || len < 0 || offset + len > piece_offset) return std::nullopt;
+  return slices;
+}
+
+}  // namespace fur::storage
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "torrent.hpp"
+#include "util/result.hpp"
+
+/// Where the content of torrents is stored
+namespace fur::storage {
+
+enum class StorageError {
+  /// Files of a torrent could not be created
+  CannotPrepare,
+  /// Writing to a file failed
+  CannotWrite,
+  /// Reading from a file failed or the file doesn't exist
+  CannotRead,
+  /// Flushing written data failed
+  CannotFlush,
+};
+
+/// Result of a storage operation
+template <typename T>
+using StorageResult = util::Result<T, StorageError>;
+using util::Empty;
+
+/// Part of a block that belongs to a single file
+struct BlockSlice {
+  /// Full path of the file is the folder of the torrent followed by this
+  const std::string* filepath;
+  /// Offset of the slice from the beginning of the block
+  int64_t block_offset;
+  /// Offset of the slice from the beginning of the file
+  int64_t file_offset;
+  /// Number of bytes of the slice
+  int64_t len;
+};
+
+/// Splits a block of a piece among the files it belongs to
+/// @param offset offset of the block from the beginning of the piece
+/// @param len length of the block
+/// @return slices in order or nothing if the block is outside the piece
+std::optional<std::vector<BlockSlice>> split_block(const Piece& piece,
+                                                   int64_t offset,
+                                                   int64_t len);
+
+/// Interface between the download pipeline and the place where the content of
+/// a torrent ends up. Files are always identified by their full path, that is
+/// the folder name of the torrent followed by the filename. All methods can be
+/// called concurrently as long as they don't touch the same bytes.
+class StorageBackend {
+ public:
+  virtual ~StorageBackend() = default;
+
+  /// Create all the files of a torrent
+  /// @param descriptor torrent to prepare, its folder name is the preferred
+  /// location and may be changed by the backend to avoid overwriting content
+  /// @param reuse_existing use the files already present in the folder
+  /// instead of picking a new one, missing files are still created
+  /// @param priorities priority of every file, all files are wanted if empty.
+  /// Skipped files are only created when they share a wanted piece, see
+  /// `needed_files`.
+  virtual StorageResult<Empty> prepare(
+      TorrentFile& descriptor, bool reuse_existing,
+      const std::vector<FilePriority>& priorities = {}) = 0;
+
+  /// Store a whole piece, every subpiece goes to its own file
+  /// @param descriptor owner torrent
+  /// @param piece piece to store
+  /// @param content bytes of the piece
+  /// @param len number of bytes of the piece, as long as all its subpieces
+  virtual StorageResult<Empty> write_piece(
+      const TorrentFile& descriptor, const Piece& piece,
+      const uint8_t* content, int64_t len) = 0;
+
+  /// Store part of a piece as soon as it arrives, before the whole piece can
+  /// be verified
+  /// @param descriptor owner torrent
+  /// @param piece piece the block belongs to
+  /// @param offset offset of the block from the beginning of the piece
+  /// @param content bytes of the block
+  /// @param len number of bytes of the block
+  virtual StorageResult<Empty> write_block(const TorrentFile& descriptor,
+                                           const Piece& piece, int64_t offset,
+                                           const uint8_t* content,
+                                           int64_t len) = 0;
+
+  /// Read a contiguous block of bytes of a single file
+  /// @param filepath full path of the file
+  /// @param bytes where to store the bytes, must have room for `len` bytes
+  /// @param len number of bytes to read
+  /// @param offset where to read the bytes in the file
+  /// @return number of bytes read, less than `len` if the file is too short
+  virtual StorageResult<int64_t> read_block(const std::string& filepath,
+                                            uint8_t* bytes, int64_t len,
+                                            int64_t offset) = 0;
+
+  /// Make sure everything written to the files of a torrent is persisted
+  virtual StorageResult<Empty> flush(const TorrentFile& descriptor) = 0;
+
+  /// Let go of whatever the backend keeps around to write the files of a
+  /// torrent, called once the torrent is removed. The content is left alone.
+  virtual void release(const TorrentFile& descriptor) { (void)descriptor; }
+
+  /// @return True if the content survives a restart of the program
+  [[nodiscard]] virtual bool persistent() const = 0;
+};
+
+}  // namespace fur::storage
@@ -0,0 +1,213 @@
+#include "storage/file.hpp"
+
+#include <atomic>
+#include <unordered_set>
+
+#include "mt/parallel.hpp"
+
+namespace fur::storage {
+
+using namespace fur::platform;  // For IO operations
+
+/// Maximum number of files kept open at once, well below the usual limit of
+/// descriptors of a process
+const size_t MAX_OPEN_FILES = 256;
+
+FileBackend::FileBackend(io::Preallocation preallocation)
+    : _preallocation{preallocation} {}
+
+StorageResult<Empty> FileBackend::prepare(
+    TorrentFile& descriptor, bool reuse_existing,
+    const std::vector<FilePriority>& priorities) {
+  using Result = StorageResult<Empty>;
+  const std::vector<bool> needed = needed_files(descriptor, priorities);
+
+  std::string torrent_base_path = descriptor.folder_name;
+  if (torrent_base_path.find('/') != std::string::npos &&
+      !io::create_directories(torrent_base_path, true).valid())
+    return Result::ERROR(StorageError::CannotPrepare);
+
+  const int64_t MAX_COPY_ATTEMPTS = 10;
+  int64_t attempts = 0;
+
+  // The folder is claimed by creating it, torrents with the same name added
+  // at the same time never get the same one. If it already exists then keep
+  // adding "COPY", unless the existing content is reused.
+  bool created_folder = false;
+  while (true) {
+    auto claim = io::create_directory(torrent_base_path);
+    if (claim.valid()) {
+      created_folder = true;
+      break;
+    }
+    if (claim.error() != io::IOError::DirectoryAlreadyExists)
+      return Result::ERROR(StorageError::CannotPrepare);
+    if (reuse_existing) break;
+
+    // If we tried to many times to generate new folders copy
+    if (attempts == MAX_COPY_ATTEMPTS)
+      return Result::ERROR(StorageError::CannotPrepare);
+    torrent_base_path += " COPY";
+    attempts += 1;
+  }
+
+  // Create nested folders, many files usually share the same ones
+  descriptor.folder_name = torrent_base_path;
+  // Files opened before are stale if the content was replaced meanwhile
+  release(descriptor);
+  std::unordered_set<std::string> created_dirpaths;
+  std::vector<std::string> filepaths;
+  filepaths.reserve(descriptor.files.size());
+
+  bool must_cleanup = false;
+  for (const auto& file : descriptor.files) {
+    const std::string filepath = descriptor.folder_name + '/' + file.filename();
+    const std::string dirpath = filepath.substr(0, filepath.find_last_of('/'));
+    if (created_dirpaths.count(dirpath) == 0) {
+      auto file_dirpath = io::create_directories(dirpath);
+      if (!file_dirpath.valid()) {
+        must_cleanup = true;
+        break;
+      }
+      created_dirpaths.insert(dirpath);
+    }
+    filepaths.push_back(filepath);
+  }
+
+  // Create output files, each one is independent so they are reserved in
+  // parallel to hide the latency of the filesystem
+  if (!must_cleanup) {
+    std::atomic_bool failed{false};
+    mt::parallel_for(
+        static_cast<int64_t>(filepaths.size()), [&](int64_t index) {
+          if (failed.load(std::memory_order_relaxed) || !needed[index])
+            return;
+
+          // Only a few bytes of skipped files are ever written
+          const bool skipped = !priorities.empty() &&
+                               priorities[index] == FilePriority::Skip;
+          auto creation = io::touch(
+              filepaths[index], descriptor.files[index].length,
+              skipped ? io::Preallocation::Sparse : _preallocation);
+          if (!creation.valid() &&
+              !(reuse_existing &&
+                creation.error() == io::IOError::FileAlreadyExists))
+            failed.store(true, std::memory_order_relaxed);
+        });
+    must_cleanup = failed.load();
+  }
+
+  // Remove created content if we failed to create all files, never content
+  // we didn't create
+  if (must_cleanup) {
+    if (created_folder) io::remove(descriptor.folder_name);
+    return Result::ERROR(StorageError::CannotPrepare);
+  }
+
+  return Result::OK({});
+}
+
+StorageResult<Empty> FileBackend::write_piece(
+    const TorrentFile& descriptor, const Piece& piece,
+    const uint8_t* content, int64_t len) {
+  using Result = StorageResult<Empty>;
+
+  // Every subpiece gets its own slice of the content
+  int64_t piece_offset = 0;
+  for (const auto& subpiece : piece.subpieces) {
+    if (piece_offset + subpiece.len > len)
+      return Result::ERROR(StorageError::CannotWrite);
+
+    auto file = open_file(descriptor.folder_name + '/' + subpiece.filepath);
+    if (!file.valid()) return Result::ERROR(StorageError::CannotWrite);
+
+    auto write = (*file)->write(content + piece_offset, subpiece.len,
+                                subpiece.file_offset);
+    if (!write.valid()) return Result::ERROR(StorageError::CannotWrite);
+    piece_offset += subpiece.len;
+  }
+
+  return Result::OK({});
+}
+
+StorageResult<Empty> FileBackend::write_block(const TorrentFile& descriptor,
+                                              const Piece& piece,
+                                              int64_t offset,
+                                              const uint8_t* content,
+                                              int64_t len) {
+  using Result = StorageResult<Empty>;
+
+  auto slices = split_block(piece, offset, len);
+  if (!slices.has_value()) return Result::ERROR(StorageError::CannotWrite);
+
+  for (const auto& slice : *slices) {
+    auto file = open_file(descriptor.folder_name + '/' + *slice.filepath);
+    if (!file.valid()) return Result::ERROR(StorageError::CannotWrite);
+
+    auto write = (*file)->write(content + slice.block_offset, slice.len,
+                                slice.file_offset);
+    if (!write.valid()) return Result::ERROR(StorageError::CannotWrite);
+  }
+
+  return Result::OK({});
+}
+
+StorageResult<int64_t> FileBackend::read_block(const std::string& filepath,
+                                               uint8_t* bytes, int64_t len,
+                                               int64_t offset) {
+  auto read = io::read_bytes(filepath, bytes, len, offset);
+  if (!read.valid())
+    return StorageResult<int64_t>::ERROR(StorageError::CannotRead);
+  return StorageResult<int64_t>::OK(std::move(*read));
+}
+
+StorageResult<Empty> FileBackend::flush(const TorrentFile& descriptor) {
+  // Data written through the open files is synced by path all the same
+  release(descriptor);
+
+  for (const auto& file : descriptor.files) {
+    // Skipped files may have never been created
+    const std::string filepath = descriptor.folder_name + '/' + file.filename();
+    auto existence = io::exists(filepath);
+    if (existence.valid() && !*existence) continue;
+
+    auto sync = io::sync(filepath);
+    if (!sync.valid())
+      return StorageResult<Empty>::ERROR(StorageError::CannotFlush);
+  }
+  return StorageResult<Empty>::OK({});
+}
+
+void FileBackend::release(const TorrentFile& descriptor) {
+  std::scoped_lock<std::mutex> lock(_files_mtx);
+  for (const auto& file : descriptor.files)
+    _files.erase(descriptor.folder_name + '/' + file.filename());
+}
+
+bool FileBackend::persistent() const { return true; }
+
+StorageResult<std::shared_ptr<io::WritableFile>> FileBackend::open_file(
+    const std::string& filepath) {
+  using Result = StorageResult<std::shared_ptr<io::WritableFile>>;
+  {
+    std::scoped_lock<std::mutex> lock(_files_mtx);
+    auto it = _files.find(filepath);
+    if (it != _files.end()) return Result::OK(std::shared_ptr(it->second));
+  }
+
+  // Opened without the lock, if another thread opened the same file in the
+  // meantime its copy is kept
+  auto opened = io::WritableFile::open(filepath);
+  if (!opened.valid()) return Result::ERROR(StorageError::CannotWrite);
+  auto file = std::make_shared<io::WritableFile>(std::move(*opened));
+
+  std::scoped_lock<std::mutex> lock(_files_mtx);
+  // Past the limit any file makes room, those in use stay open until their
+  // writes are done
+  if (_files.size() >= MAX_OPEN_FILES && _files.count(filepath) == 0)
+    _files.erase(_files.begin());
+  auto it = _files.emplace(filepath, std::move(file)).first;
+  return Result::OK(std::shared_ptr(it->second));
+}
+
+}  // namespace fur::storage
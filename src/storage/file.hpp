@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "platform/io.hpp"
+#include "storage/backend.hpp"
+
+namespace fur::storage {
+
+/// Stores the content of torrents in files on disk, inside the folder of each
+/// torrent
+class FileBackend : public StorageBackend {
+  /// How the files of new torrents are reserved on disk
+  platform::io::Preallocation _preallocation;
+  /// Protects the open files
+  std::mutex _files_mtx;
+  /// Files written since their torrent was last flushed, kept open so that
+  /// every block doesn't pay for opening its file. Writers hold a reference
+  /// while they write, a file closes once it is dropped and nobody uses it.
+  std::unordered_map<std::string, std::shared_ptr<platform::io::WritableFile>>
+      _files;
+
+  /// @return the open file at a full path, opened now if it isn't already
+  StorageResult<std::shared_ptr<platform::io::WritableFile>> open_file(
+      const std::string& filepath);
+
+ public:
+  explicit FileBackend(
+      platform::io::Preallocation preallocation =
+          platform::io::Preallocation::Sparse);
+
+  /// Creates the folder of the torrent and all its files. If the folder
+  /// already exists and must not be reused " COPY" is appended to its name.
+  /// Skipped files that share a piece with wanted ones are always sparse.
+  StorageResult<Empty> prepare(
+      TorrentFile& descriptor, bool reuse_existing,
+      const std::vector<FilePriority>& priorities = {}) override;
+  StorageResult<Empty> write_piece(
+      const TorrentFile& descriptor, const Piece& piece,
+      const uint8_t* content, int64_t len) override;
+  StorageResult<Empty> write_block(const TorrentFile& descriptor,
+                                   const Piece& piece, int64_t offset,
+                                   const uint8_t* content,
+                                   int64_t len) override;
+  StorageResult<int64_t> read_block(const std::string& filepath,
+                                    uint8_t* bytes, int64_t len,
+                                    int64_t offset) override;
+  /// Closes the files of the torrent before persisting them
+  StorageResult<Empty> flush(const TorrentFile& descriptor) override;
+  /// Closes the files of the torrent
+  void release(const TorrentFile& descriptor) override;
+  [[nodiscard]] bool persistent() const override;
+};
+
+}  // namespace fur::storage
@@ -0,0 +1,137 @@
+#include "storage/memory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace fur::storage {
+
+StorageResult<Empty> MemoryBackend::prepare(
+    TorrentFile& descriptor, bool reuse_existing,
+    const std::vector<FilePriority>& priorities) {
+  const std::vector<bool> needed = needed_files(descriptor, priorities);
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+
+  // Same behaviour of files on disk, never overwrite another torrent
+  if (!reuse_existing) {
+    while (_folders.count(descriptor.folder_name) != 0)
+      descriptor.folder_name += " COPY";
+  }
+  _folders.insert(descriptor.folder_name);
+
+  for (size_t i = 0; i < descriptor.files.size(); i++) {
+    if (!needed[i]) continue;
+    // Existing files are only found when reusing the folder
+    const File& file = descriptor.files[i];
+    _files.try_emplace(descriptor.folder_name + '/' + file.filename(),
+                       file.length, 0);
+  }
+  return StorageResult<Empty>::OK({});
+}
+
+StorageResult<Empty> MemoryBackend::write_piece(
+    const TorrentFile& descriptor, const Piece& piece,
+    const uint8_t* content, int64_t len) {
+  using Result = StorageResult<Empty>;
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+
+  int64_t piece_offset = 0;
+  for (const auto& subpiece : piece.subpieces) {
+    auto it = _files.find(descriptor.folder_name + '/' + subpiece.filepath);
+    if (it == _files.end() ||
+        piece_offset + subpiece.len > len ||
+        subpiece.file_offset + subpiece.len >
+            static_cast<int64_t>(it->second.size()))
+      return Result::ERROR(StorageError::CannotWrite);
+
+    std::memcpy(it->second.data() + subpiece.file_offset,
+                content + piece_offset, subpiece.len);
+    piece_offset += subpiece.len;
+  }
+
+  return Result::OK({});
+}
+
+StorageResult<Empty> MemoryBackend::write_block(const TorrentFile& descriptor,
+                                                const Piece& piece,
+                                                int64_t offset,
+                                                const uint8_t* content,
+                                                int64_t len) {
+  using Result = StorageResult<Empty>;
+
+  auto slices = split_block(piece, offset, len);
+  if (!slices.has_value()) return Result::ERROR(StorageError::CannotWrite);
+
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  for (const auto& slice : *slices) {
+    auto it = _files.find(descriptor.folder_name + '/' + *slice.filepath);
+    if (it == _files.end() ||
+        slice.file_offset + slice.len >
+            static_cast<int64_t>(it->second.size()))
+      return Result::ERROR(StorageError::CannotWrite);
+
+    std::memcpy(it->second.data() + slice.file_offset,
+                content + slice.block_offset, slice.len);
+  }
+
+  return Result::OK({});
+}
+
+StorageResult<int64_t> MemoryBackend::read_block(const std::string& filepath,
+                                                 uint8_t* bytes, int64_t len,
+                                                 int64_t offset) {
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+
+  auto it = _files.find(filepath);
+  if (it == _files.end())
+    return StorageResult<int64_t>::ERROR(StorageError::CannotRead);
+
+  const int64_t size = static_cast<int64_t>(it->second.size());
+  int64_t read = std::clamp<int64_t>(size - offset, 0, len);
+  if (read > 0) std::memcpy(bytes, it->second.data() + offset, read);
+  return StorageResult<int64_t>::OK(std::move(read));
+}
+
+StorageResult<Empty> MemoryBackend::flush(const TorrentFile&) {
+  return StorageResult<Empty>::OK({});
+}
+
+bool MemoryBackend::persistent() const { return false; }
+
+// ======================================================================================
+
+StorageResult<Empty> DiscardBackend::prepare(
+    TorrentFile&, bool, const std::vector<FilePriority>&) {
+  return StorageResult<Empty>::OK({});
+}
+
+StorageResult<Empty> DiscardBackend::write_piece(
+    const TorrentFile&, const Piece&, const uint8_t*, int64_t len) {
+  _bytes_written.fetch_add(len, std::memory_order_relaxed);
+  return StorageResult<Empty>::OK({});
+}
+
+StorageResult<Empty> DiscardBackend::write_block(const TorrentFile&,
+                                                 const Piece&, int64_t,
+                                                 const uint8_t*, int64_t len) {
+  _bytes_written.fetch_add(len, std::memory_order_relaxed);
+  return StorageResult<Empty>::OK({});
+}
+
+StorageResult<int64_t> DiscardBackend::read_block(const std::string&,
+                                                  uint8_t*, int64_t,
+                                                  int64_t) {
+  return StorageResult<int64_t>::OK(0);
+}
+
+StorageResult<Empty> DiscardBackend::flush(const TorrentFile&) {
+  return StorageResult<Empty>::OK({});
+}
+
+bool DiscardBackend::persistent() const { return false; }
+
+int64_t DiscardBackend::bytes_written() const {
+  return _bytes_written.load(std::memory_order_relaxed);
+}
+
+}  // namespace fur::storage
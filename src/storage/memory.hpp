@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "storage/backend.hpp"
+
+namespace fur::storage {
+
+/// Keeps the content of torrents in memory, used to measure the rest of the
+/// pipeline without any disk noise. Every torrent takes as much memory as its
+/// length.
+class MemoryBackend : public StorageBackend {
+  /// Protects the maps, the content of the files is not protected because
+  /// pieces never overlap
+  mutable std::shared_mutex _mtx;
+  /// Content of every file, indexed by full path
+  std::unordered_map<std::string, std::vector<uint8_t>> _files;
+  /// Folders of the prepared torrents
+  std::unordered_set<std::string> _folders;
+
+ public:
+  StorageResult<Empty> prepare(
+      TorrentFile& descriptor, bool reuse_existing,
+      const std::vector<FilePriority>& priorities = {}) override;
+  StorageResult<Empty> write_piece(
+      const TorrentFile& descriptor, const Piece& piece,
+      const uint8_t* content, int64_t len) override;
+  StorageResult<Empty> write_block(const TorrentFile& descriptor,
+                                   const Piece& piece, int64_t offset,
+                                   const uint8_t* content,
+                                   int64_t len) override;
+  StorageResult<int64_t> read_block(const std::string& filepath,
+                                    uint8_t* bytes, int64_t len,
+                                    int64_t offset) override;
+  StorageResult<Empty> flush(const TorrentFile& descriptor) override;
+  [[nodiscard]] bool persistent() const override;
+};
+
+/// Throws away everything it is given, reading always returns no bytes. Used
+/// to measure network and hashing throughput alone.
+class DiscardBackend : public StorageBackend {
+  /// Bytes received since construction
+  std::atomic_int64_t _bytes_written{0};
+
+ public:
+  StorageResult<Empty> prepare(
+      TorrentFile& descriptor, bool reuse_existing,
+      const std::vector<FilePriority>& priorities = {}) override;
+  StorageResult<Empty> write_piece(
+      const TorrentFile& descriptor, const Piece& piece,
+      const uint8_t* content, int64_t len) override;
+  StorageResult<Empty> write_block(const TorrentFile& descriptor,
+                                   const Piece& piece, int64_t offset,
+                                   const uint8_t* content,
+                                   int64_t len) override;
+  StorageResult<int64_t> read_block(const std::string& filepath,
+                                    uint8_t* bytes, int64_t len,
+                                    int64_t offset) override;
+  StorageResult<Empty> flush(const TorrentFile& descriptor) override;
+  [[nodiscard]] bool persistent() const override;
+
+  /// @return number of bytes discarded so far
+  [[nodiscard]] int64_t bytes_written() const;
+};
+
+}  // namespace fur::storage
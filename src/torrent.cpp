@@ -1,9 +1,13 @@
 #include "torrent.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
 
+#include "bencode/bencode_cursor.hpp"
 #include "bencode/bencode_parser.hpp"
 #include "bencode/bencode_value.hpp"
 #include "hash.hpp"
@@ -29,46 +33,41 @@ std::string File::filename() const {
   return sstream.str();
 }
 
-TorrentFile::TorrentFile(const BencodeValue& tree) {
-  // This function receives a const reference and rightfully so: we don't need
-  // to mutate the bencode tree but `BencodeValue::value()` (which we need to
-  // use) returns a non-const reference. I hereby solemnly promise not to mutate
-  // the argument!
-  auto& tree_pinky_promise = const_cast<BencodeValue&>(tree);
-
-  // We know the torrent starts with a dict
-  auto& dict = dynamic_cast<BencodeDict&>(tree_pinky_promise).value();
+/// @return value of a .torrent field, throws if it is missing or malformed
+template <typename T>
+static T expect(CursorResult<T> value, std::string_view key) {
+  if (!value.valid()) {
+    throw std::invalid_argument("malformed torrent, cannot read " +
+                                std::string(key) + ": " +
+                                error_to_string(value.error()));
+  }
+  return std::move(*value);
+}
 
-  this->announce_url =
-      dynamic_cast<BencodeString&>(*dict.at("announce")).value();
+TorrentFile::TorrentFile(const BencodeValue& tree)
+    : TorrentFile(BencodeCursor(BencodeParser::encode(tree))) {}
 
-  auto& bencode_info_dict = dynamic_cast<BencodeDict&>(*dict.at("info"));
+TorrentFile::TorrentFile(const BencodeCursor& root) {
+  // Only the fields we need are decoded, everything else is skipped
+  this->announce_url = expect(root.find_string("announce"), "announce");
 
-  std::string encoded_info_dict = BencodeParser::encode(bencode_info_dict);
+  auto info_dict = expect(root.find("info"), "info");
+  auto encoded_info_dict = expect(info_dict.raw(), "info");
   this->info_hash = hash::compute_info_hash(encoded_info_dict);
 
-  auto& info_dict = bencode_info_dict.value();
+  this->name = expect(info_dict.find_string("name"), "name");
 
-  this->name = dynamic_cast<BencodeString&>(*info_dict.at("name")).value();
-
-  auto it = info_dict.find("files");
-  if (it != info_dict.end()) {
+  if (info_dict.contains("files")) {
     // This is a multifile torrent
-
-    auto& files_list =
-        dynamic_cast<BencodeList&>(*info_dict.at("files")).value();
-    for (auto& file_node : files_list) {
-      auto& file_dict = dynamic_cast<BencodeDict&>(*file_node).value();
-
+    auto files = expect(info_dict.find("files"), "files");
+    for (const auto& file_dict : expect(files.items(), "files")) {
       File file;
-      file.length = dynamic_cast<BencodeInt&>(*file_dict.at("length")).value();
+      file.length = expect(file_dict.find_int("length"), "length");
       this->length += file.length;
 
-      auto& filepath =
-          dynamic_cast<BencodeList&>(*file_dict.at("path")).value();
-      for (auto& path_node : filepath) {
-        auto& segment = dynamic_cast<BencodeString&>(*path_node).value();
-        file.filepath.push_back(segment);
+      auto path = expect(file_dict.find("path"), "path");
+      for (const auto& segment : expect(path.items(), "path")) {
+        file.filepath.emplace_back(expect(segment.as_string(), "path"));
       }
 
       this->files.push_back(file);
@@ -76,7 +75,7 @@ TorrentFile::TorrentFile(const BencodeValue& tree) {
 
   } else {
     // This is a single file torrent
-    this->length = dynamic_cast<BencodeInt&>(*info_dict.at("length")).value();
+    this->length = expect(info_dict.find_int("length"), "length");
 
     File file;
     file.length = this->length;
@@ -84,10 +83,13 @@ TorrentFile::TorrentFile(const BencodeValue& tree) {
     this->files.push_back(file);
   }
 
-  this->piece_length = static_cast<int>(
-      dynamic_cast<BencodeInt&>(*info_dict.at("piece length")).value());
+  this->piece_length =
+      expect(info_dict.find_int("piece length"), "piece length");
+  if (this->piece_length <= 0) {
+    throw std::invalid_argument("malformed torrent, piece length");
+  }
 
-  auto pieces = dynamic_cast<BencodeString&>(*info_dict.at("pieces")).value();
+  auto pieces = expect(info_dict.find_string("pieces"), "pieces");
 
   auto r_hashes = hash::split_piece_hashes(pieces);
 
@@ -101,7 +103,7 @@ TorrentFile::TorrentFile(const BencodeValue& tree) {
   if (r_hashes->size() > static_cast<size_t>(std::numeric_limits<int64_t>::max())) {
     throw std::out_of_range("number of pieces is too high");
   }
-  this->piece_hashes = *r_hashes;
+  this->piece_hashes = std::move(*r_hashes);
 
   // Integer ceil division
   this->pieces_count =
@@ -117,29 +119,48 @@ TorrentFile::TorrentFile(const BencodeValue& tree) {
 
 Torrent::Torrent()
     : _tid{0},
+      _descriptor{std::make_shared<const TorrentFile>()},
       _update_interval{0},
+      _completed{0},
+      _contiguous_pieces{0},
       state{TorrentState::Error},
-      pieces_processed{0} {}
+      pieces_processed{0},
+      streaming{false},
+      pieces_wanted{0},
+      sequential{false},
+      read_cursor{0},
+      weight{1},
+      priority{TorrentPriority::Normal} {}
 
 Torrent::Torrent(TorrentID tid, const TorrentFile& descriptor)
     : _tid{tid},
-      _descriptor{descriptor},
+      _descriptor{std::make_shared<const TorrentFile>(descriptor)},
+      _layout{descriptor},
       _update_interval{0},
+      _completed{descriptor.pieces_count},
+      _contiguous_pieces{0},
       state{TorrentState::Loading},
-      pieces_processed{0} {
-  announce();
-}
+      pieces_processed{0},
+      streaming{false},
+      pieces_wanted{descriptor.pieces_count},
+      sequential{false},
+      read_cursor{0},
+      weight{1},
+      priority{TorrentPriority::Normal} {}
 
 void Torrent::announce() {
-  auto response = peer::announce(_descriptor);
+  auto response = peer::announce(*_descriptor);
   if (!response.valid()) {
     auto logger = spdlog::get("custom");
     logger->critical("Error announcing to tracker!");
     return;
   }
+  set_peers(std::move(*response));
+}
 
-  _update_interval = response->interval;
-  _peers = response->peers;
+void Torrent::set_peers(peer::Announce response) {
+  _update_interval = response.interval;
+  _peers = std::move(response.peers);
 
   if (_peers.size() > static_cast<size_t>(std::numeric_limits<int64_t>::max())) {
     throw std::out_of_range("too many peers");
@@ -170,76 +191,155 @@ std::discrete_distribution<int64_t> Torrent::distribution() const {
 
 TorrentID Torrent::tid() const { return _tid; }
 
-const TorrentFile& Torrent::descriptor() const { return _descriptor; }
+const TorrentFile& Torrent::descriptor() const { return *_descriptor; }
+
+std::shared_ptr<const TorrentFile> Torrent::shared_descriptor() const {
+  return _descriptor;
+}
 
 std::vector<peer::Peer> Torrent::peers() const { return _peers; }
 
-/// Generate all pieces of this torrent
-std::vector<Piece> Torrent::pieces() const {
-  const int64_t PIECES_COUNT = _descriptor.pieces_count;
+int64_t Torrent::update_interval() const { return _update_interval; }
+
+const FileLayout& Torrent::layout() const { return _layout; }
+
+std::vector<Piece> TorrentFile::pieces() const {
+  const FileLayout layout(*this);
 
   std::vector<Piece> pieces;
-  pieces.reserve(PIECES_COUNT);
+  pieces.reserve(pieces_count);
+  for (int64_t index = 0; index < pieces_count; index++)
+    pieces.push_back(layout.piece(index));
+  return pieces;
+}
 
-  int64_t cur_file = 0;
-  int64_t cur_file_tot_size = _descriptor.files[cur_file].length;
-  int64_t cur_file_rem_size = cur_file_tot_size;
+// =================================================================================================
+// FILE LAYOUT
 
-  // Iterate all pieces
-  for (int64_t index = 0; index < PIECES_COUNT; index++) {
-    std::vector<Subpiece> subpieces;
+FileLayout::FileLayout() : _offsets{0}, _piece_length{0}, _pieces_count{0} {}
 
-    int64_t piece_length = _descriptor.piece_length;
-    if (index == PIECES_COUNT - 1) {
-      int64_t before_this_piece =
-          (_descriptor.pieces_count - 1) * _descriptor.piece_length;
-      piece_length = _descriptor.length - before_this_piece;
-    }
+FileLayout::FileLayout(const TorrentFile& descriptor)
+    : _piece_length{descriptor.piece_length},
+      _pieces_count{descriptor.pieces_count} {
+  _offsets.reserve(descriptor.files.size() + 1);
+  _paths.reserve(descriptor.files.size());
 
-    // Must create multiple subpieces
-    if (cur_file_rem_size < piece_length) {
-      // Keep incrementing file index until there is no
-      // more space available in the piece
-      int64_t piece_rem_len = piece_length;
-      while (piece_rem_len > 0) {
-        // Can fill entire file in the piece
-        if (cur_file_rem_size <= piece_rem_len) {
-          int64_t offset = cur_file_tot_size - cur_file_rem_size;
-          std::string piece_filename = _descriptor.files[cur_file].filename();
-
-          subpieces.push_back({piece_filename, offset, cur_file_rem_size});
-          piece_rem_len -= cur_file_rem_size;
-
-          // Next file
-          cur_file += 1;
-          cur_file_tot_size = _descriptor.files[cur_file].length;
-          cur_file_rem_size = cur_file_tot_size;
-
-        }
-        // Cannot fill entire file in the piece
-        else {
-          int64_t offset = cur_file_tot_size - cur_file_rem_size;
-          std::string piece_filename = _descriptor.files[cur_file].filename();
-          subpieces.push_back({piece_filename, offset, piece_rem_len});
-
-          cur_file_rem_size -= piece_rem_len;
-          piece_rem_len = 0;
-        }
-      }
-    }
-    // Single "piece/file" mapping
-    else {
-      int64_t offset = cur_file_tot_size - cur_file_rem_size;
-      std::string piece_filename = _descriptor.files[cur_file].filename();
+  int64_t offset = 0;
+  for (const auto& file : descriptor.files) {
+    _offsets.push_back(offset);
+    _paths.push_back(file.filename());
+    offset += file.length;
+  }
+  _offsets.push_back(offset);
+}
 
-      subpieces.push_back(Subpiece{piece_filename, offset, piece_length});
-      cur_file_rem_size -= piece_length;
-    }
+int64_t FileLayout::piece_length(int64_t index) const {
+  const int64_t begin = index * _piece_length;
+  return std::min(_piece_length, _offsets.back() - begin);
+}
+
+int64_t FileLayout::file_at(int64_t offset) const {
+  // Last file beginning at or before the offset, empty files begin at the
+  // same offset of the next one and are skipped
+  auto it = std::upper_bound(_offsets.begin(), _offsets.end(), offset);
+  return static_cast<int64_t>(it - _offsets.begin()) - 1;
+}
+
+Piece FileLayout::piece(int64_t index) const {
+  if (index < 0 || index >= _pieces_count)
+    throw std::out_of_range("piece index out of range");
+
+  Piece piece{index, {}};
+  int64_t offset = index * _piece_length;
+  int64_t remaining = piece_length(index);
+  const auto files_count = static_cast<int64_t>(_paths.size());
+  for (int64_t file = file_at(offset); remaining > 0 && file < files_count;
+       file++) {
+    const int64_t len = std::min(remaining, _offsets[file + 1] - offset);
+    if (len == 0) continue;
+
+    piece.subpieces.push_back({_paths[file], offset - _offsets[file], len});
+    offset += len;
+    remaining -= len;
+  }
+  return piece;
+}
 
-    pieces.push_back(Piece{index, subpieces});
+/// Calls `fn(file, first, last)` for every file that isn't empty with the
+/// range of pieces that overlap it, `last` included
+template <typename Fn>
+static void for_each_file_pieces(const TorrentFile& descriptor, Fn fn) {
+  int64_t offset = 0;
+  for (int64_t file = 0; file < static_cast<int64_t>(descriptor.files.size());
+       file++) {
+    const int64_t length = descriptor.files[file].length;
+    if (length > 0) {
+      fn(file, offset / descriptor.piece_length,
+         (offset + length - 1) / descriptor.piece_length);
+    }
+    offset += length;
   }
+}
 
+std::vector<FilePriority> piece_priorities(
+    const TorrentFile& descriptor, const std::vector<FilePriority>& files) {
+  if (files.empty())
+    return std::vector<FilePriority>(descriptor.pieces_count,
+                                     FilePriority::Normal);
+  if (files.size() != descriptor.files.size())
+    throw std::invalid_argument("expected a priority for every file");
+
+  std::vector<FilePriority> pieces(descriptor.pieces_count, FilePriority::Skip);
+  for_each_file_pieces(descriptor, [&](int64_t file, int64_t first,
+                                       int64_t last) {
+    for (int64_t index = first; index <= last; index++)
+      pieces[index] = std::max(pieces[index], files[file]);
+  });
   return pieces;
 }
 
+std::vector<bool> needed_files(const TorrentFile& descriptor,
+                               const std::vector<FilePriority>& files) {
+  if (files.empty()) return std::vector<bool>(descriptor.files.size(), true);
+  const auto pieces = piece_priorities(descriptor, files);
+
+  // Empty files are never touched by a piece
+  std::vector<bool> needed(descriptor.files.size());
+  for (size_t file = 0; file < files.size(); file++)
+    needed[file] = files[file] != FilePriority::Skip;
+
+  for_each_file_pieces(descriptor, [&](int64_t file, int64_t first,
+                                       int64_t last) {
+    // Pieces in the middle only belong to this file
+    needed[file] = pieces[first] != FilePriority::Skip ||
+                   pieces[last] != FilePriority::Skip;
+  });
+  return needed;
+}
+
+void Torrent::mark_completed(int64_t index) {
+  std::scoped_lock<std::mutex> lock(_completed_mutex);
+  _completed.set(index);
+
+  // Only the piece right after the prefix can extend it
+  int64_t contiguous = _contiguous_pieces.load(std::memory_order_relaxed);
+  while (contiguous < _completed.len && _completed.get(contiguous))
+    contiguous += 1;
+  _contiguous_pieces.store(contiguous, std::memory_order_release);
+}
+
+download::bitfield::Bitfield Torrent::completed() const {
+  std::scoped_lock<std::mutex> lock(_completed_mutex);
+  return _completed;
+}
+
+int64_t Torrent::contiguous_pieces() const {
+  return _contiguous_pieces.load(std::memory_order_acquire);
+}
+
+int64_t Torrent::contiguous_bytes() const {
+  return std::min(contiguous_pieces() * _descriptor->piece_length,
+                  _descriptor->length);
+}
+
 }  // namespace fur
@@ -3,15 +3,28 @@
 #include <atomic>
 #include <cstdint>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <peer.hpp>
 #include <random>
 #include <string>
 #include <types.hpp>
 #include <vector>
 
+#include "bencode/bencode_cursor.hpp"
 #include "bencode/bencode_value.hpp"
+#include "download/bitfield.hpp"
 #include "hash.hpp"
 
+// Forward declare ResumeFile, ResumeData and StorageBackend
+namespace fur::resume {
+class ResumeFile;
+struct ResumeData;
+}
+namespace fur::storage {
+class StorageBackend;
+}
+
 namespace fur {
 
 /// Describes a file inside a torrent
@@ -28,6 +41,43 @@ struct File {
   [[nodiscard]] std::string filename() const;
 };
 
+/// How much the user wants a file of a torrent, higher priorities are
+/// downloaded first
+enum class FilePriority : uint8_t {
+  /// Not downloaded at all
+  Skip,
+  Low,
+  Normal,
+  High,
+};
+
+/// Scheduling class of a torrent, the workers always serve the torrents of
+/// the highest class with pieces left first
+enum class TorrentPriority : uint8_t {
+  Low,
+  Normal,
+  High,
+};
+
+/// Describes a subsection of a Piece, it is mapped to a single file
+struct Subpiece {
+  /// Path to the file this subpiece belongs to
+  std::string filepath;
+  /// Offset from the beginning of the file
+  int64_t file_offset;
+  /// Size in bytes
+  int64_t len;
+};
+
+/// Describes a piece of a torrent with all the information
+/// necessary to complete his download an saving on file
+struct Piece {
+  /// Global download index
+  int64_t index;
+  /// Mapping piece-files
+  std::vector<Subpiece> subpieces;
+};
+
 /// Represents a parsed .torrent file
 struct TorrentFile {
   /// The URL used to announce ourselves to the tracker and fetch a list of
@@ -58,27 +108,61 @@ struct TorrentFile {
   /// Construct an instance of TorrentFile given a bencode::BencodeValue which
   /// is assumed to be the parsed .torrent file
   explicit TorrentFile(const bencode::BencodeValue& tree);
-};
 
-/// Describes a subsection of a Piece, it is mapped to a single file
-struct Subpiece {
-  /// Path to the file this subpiece belongs to
-  std::string filepath;
-  /// Offset from the beginning of the file
-  int64_t file_offset;
-  /// Size in bytes
-  int64_t len;
+  /// Construct an instance of TorrentFile reading only the fields it needs
+  /// from an encoded .torrent file, throws if a field is missing or malformed
+  explicit TorrentFile(const bencode::BencodeCursor& root);
+
+  /// Generate all pieces of this torrent, prefer `FileLayout::piece` to get
+  /// them one at a time
+  [[nodiscard]] std::vector<Piece> pieces() const;
 };
 
-/// Describes a piece of a torrent with all the information
-/// necessary to complete his download an saving on file
-struct Piece {
-  /// Global download index
-  int64_t index;
-  /// Mapping piece-files
-  std::vector<Subpiece> subpieces;
+/// Index of where every file of a torrent begins. The files a piece is stored
+/// in are found with a binary search when the piece is needed, so that no
+/// torrent keeps all its pieces in memory.
+class FileLayout {
+  /// Offset of the first byte of every file from the beginning of the
+  /// torrent, followed by the length of the torrent
+  std::vector<int64_t> _offsets;
+  /// Path of every file relative to the download folder
+  std::vector<std::string> _paths;
+  /// The length, in bytes, of each piece but the last
+  int64_t _piece_length;
+  /// Total number of pieces
+  int64_t _pieces_count;
+
+ public:
+  /// Construct the layout of a torrent without files
+  explicit FileLayout();
+  /// Construct the layout of the files of a torrent
+  explicit FileLayout(const TorrentFile& descriptor);
+
+  /// @return the length, in bytes, of a piece
+  [[nodiscard]] int64_t piece_length(int64_t index) const;
+
+  /// @return index of the file containing the byte at `offset` from the
+  /// beginning of the torrent, empty files never contain anything
+  [[nodiscard]] int64_t file_at(int64_t offset) const;
+
+  /// Generate a piece with the files it is stored in
+  [[nodiscard]] Piece piece(int64_t index) const;
 };
 
+/// Computes the priority of every piece from the priorities of the files
+/// @param files priority of every file, all files are wanted if empty
+/// @return priority of every piece, the highest of the files it overlaps
+std::vector<FilePriority> piece_priorities(
+    const TorrentFile& descriptor, const std::vector<FilePriority>& files);
+
+/// Finds the files that must exist on storage. Skipped files are needed only
+/// when they share a wanted piece with another file, in that case just the
+/// bytes of the shared piece are written to them.
+/// @param files priority of every file, all files are wanted if empty
+/// @return for every file, true if some wanted piece is stored in it
+std::vector<bool> needed_files(const TorrentFile& descriptor,
+                               const std::vector<FilePriority>& files);
+
 enum class TorrentState {
   Loading,
   Downloading,
@@ -92,8 +176,11 @@ enum class TorrentState {
 class Torrent {
   // Unique identifier for each torrent
   TorrentID _tid;
-  /// Parsed .torrent file descriptor
-  TorrentFile _descriptor;
+  /// Parsed .torrent file descriptor, shared with the tasks of the torrent
+  /// and never modified
+  std::shared_ptr<const TorrentFile> _descriptor;
+  /// Where the pieces of the torrent are stored in its files
+  FileLayout _layout;
 
   /// Peers where to ask for the pieces and interval time
   std::vector<peer::Peer> _peers;
@@ -102,6 +189,13 @@ class Torrent {
   /// Next peers update interval time
   int64_t _update_interval;
 
+  /// Protects `_completed`
+  mutable std::mutex _completed_mutex;
+  /// Pieces saved to storage
+  download::bitfield::Bitfield _completed;
+  /// Number of pieces saved from the first one without gaps
+  std::atomic_int64_t _contiguous_pieces;
+
  public:
   /// Current state of the torrent,
   /// this value can be changed concurrently
@@ -111,11 +205,39 @@ class Torrent {
   /// this value can be changed concurrently
   std::atomic_int64_t pieces_processed;
 
+  /// Persistent record of the pieces saved to disk, may be missing
+  std::shared_ptr<resume::ResumeFile> resume;
+
+  /// Where the content of the torrent is stored
+  std::shared_ptr<storage::StorageBackend> storage;
+  /// Write every block to storage as soon as it arrives instead of keeping
+  /// whole pieces in memory
+  std::atomic_bool streaming;
+
+  /// Number of pieces to download, less than the pieces of the torrent when
+  /// some files are skipped
+  std::atomic_int64_t pieces_wanted;
+
+  /// Priority of every file, all files are wanted if empty. Set once when the
+  /// torrent is added.
+  std::vector<FilePriority> file_priorities;
+
+  /// Download the pieces in order, starting from `read_cursor`
+  std::atomic_bool sequential;
+  /// Offset in bytes where the consumer of a sequential torrent is reading
+  std::atomic_int64_t read_cursor;
+
+  /// Share of the workers relative to the other torrents of the same
+  /// priority
+  std::atomic_int64_t weight;
+  /// Torrents of a higher priority always get the workers first
+  std::atomic<TorrentPriority> priority;
+
  public:
   /// Construct empty temporary torrent
   explicit Torrent();
 
-  /// Construct a new Torrent
+  /// Construct a new Torrent, the tracker is not contacted
   /// @param tid unique id of the torrent
   /// @param descriptor parsed .torrent file descriptor
   Torrent(TorrentID tid, const TorrentFile& descriptor);
@@ -123,6 +245,9 @@ class Torrent {
   /// Announces the client to the tracker and sets the list of peers
   void announce();
 
+  /// Sets the list of peers from the response of the tracker
+  void set_peers(peer::Announce response);
+
   /// Atomically increment score of a peer
   /// @param peer_index index of the peer to increment
   void atomic_add_peer_score(int64_t peer_index);
@@ -132,15 +257,33 @@ class Torrent {
 
   /// Returns the .torrent descriptor
   [[nodiscard]] const TorrentFile& descriptor() const;
+  /// Returns the .torrent descriptor, tasks keep it alive without a copy
+  [[nodiscard]] std::shared_ptr<const TorrentFile> shared_descriptor() const;
 
   /// Returns the loaded peers
   [[nodiscard]] std::vector<peer::Peer> peers() const;
 
+  /// Returns how often (in seconds) the tracker wants to be announced to
+  [[nodiscard]] int64_t update_interval() const;
+
   /// Returns a peer distribution
   [[nodiscard]] std::discrete_distribution<int64_t> distribution() const;
 
-  /// Generate all pieces of this torrent
-  [[nodiscard]] std::vector<Piece> pieces() const;
+  /// Returns where the pieces are stored in the files of the torrent
+  [[nodiscard]] const FileLayout& layout() const;
+
+  /// Record that a piece has been saved to storage
+  void mark_completed(int64_t index);
+
+  /// @return a copy of the pieces saved to storage
+  [[nodiscard]] download::bitfield::Bitfield completed() const;
+
+  /// @return number of pieces saved from the first one without gaps
+  [[nodiscard]] int64_t contiguous_pieces() const;
+
+  /// @return number of bytes saved from the beginning of the torrent without
+  /// gaps, a consumer can read all of them
+  [[nodiscard]] int64_t contiguous_bytes() const;
 };
 
 }  // namespace fur
@@ -0,0 +1,71 @@
+#include <util/binary.hpp>
+
+namespace fur::util {
+
+BinaryWriter::BinaryWriter(std::vector<uint8_t>& buffer) : _buffer{buffer} {}
+
+void BinaryWriter::put_u32(uint32_t value) {
+  for (int i = 0; i < 4; i++) _buffer.push_back((value >> (8 * i)) & 0xFF);
+}
+
+void BinaryWriter::put_i64(int64_t value) {
+  auto bits = static_cast<uint64_t>(value);
+  for (int i = 0; i < 8; i++) _buffer.push_back((bits >> (8 * i)) & 0xFF);
+}
+
+void BinaryWriter::put_bytes(const uint8_t* bytes, int64_t len) {
+  _buffer.insert(_buffer.end(), bytes, bytes + len);
+}
+
+void BinaryWriter::put_string(std::string_view value) {
+  put_i64(static_cast<int64_t>(value.size()));
+  put_bytes(reinterpret_cast<const uint8_t*>(value.data()),
+            static_cast<int64_t>(value.size()));
+}
+
+// ======================================================================================
+
+BinaryReader::BinaryReader(const uint8_t* bytes, int64_t len)
+    : _bytes{bytes}, _len{len}, _index{0}, _failed{false} {}
+
+uint32_t BinaryReader::get_u32() {
+  const uint8_t* bytes = get_bytes(4);
+  if (bytes == nullptr) return 0;
+
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+  return value;
+}
+
+int64_t BinaryReader::get_i64() {
+  const uint8_t* bytes = get_bytes(8);
+  if (bytes == nullptr) return 0;
+
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  return static_cast<int64_t>(value);
+}
+
+const uint8_t* BinaryReader::get_bytes(int64_t len) {
+  if (_failed || len < 0 || len > remaining()) {
+    _failed = true;
+    return nullptr;
+  }
+
+  const uint8_t* bytes = _bytes + _index;
+  _index += len;
+  return bytes;
+}
+
+std::string BinaryReader::get_string() {
+  int64_t len = get_i64();
+  const uint8_t* bytes = get_bytes(len);
+  if (bytes == nullptr) return {};
+  return {reinterpret_cast<const char*>(bytes), static_cast<size_t>(len)};
+}
+
+int64_t BinaryReader::remaining() const { return _len - _index; }
+
+bool BinaryReader::valid() const { return !_failed; }
+
+}  // namespace fur::util
@@ -0,0 +1,57 @@
+/**
+ * @file binary.hpp
+ * @brief Minimal helpers to encode and decode little-endian binary files
+ * @version 0.1
+ * @date 2022-10-19
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fur::util {
+
+/// Appends little-endian encoded values at the end of a bytes buffer
+class BinaryWriter {
+  /// Encoded content
+  std::vector<uint8_t>& _buffer;
+
+ public:
+  explicit BinaryWriter(std::vector<uint8_t>& buffer);
+
+  void put_u32(uint32_t value);
+  void put_i64(int64_t value);
+  void put_bytes(const uint8_t* bytes, int64_t len);
+  /// Writes the length of the string followed by its content
+  void put_string(std::string_view value);
+};
+
+/// Reads little-endian encoded values from a bytes buffer. Reading past the end
+/// doesn't throw: it returns zeroed values and marks the reader as failed, so
+/// that a whole record can be decoded before checking for errors once.
+class BinaryReader {
+  const uint8_t* _bytes;
+  int64_t _len;
+  int64_t _index;
+  bool _failed;
+
+ public:
+  BinaryReader(const uint8_t* bytes, int64_t len);
+
+  uint32_t get_u32();
+  int64_t get_i64();
+  /// Returns a pointer to the next `len` bytes and skips them, nullptr if the
+  /// buffer is too short
+  const uint8_t* get_bytes(int64_t len);
+  std::string get_string();
+
+  /// @return number of bytes not yet read
+  [[nodiscard]] int64_t remaining() const;
+  /// @return true if every read so far was in bounds
+  [[nodiscard]] bool valid() const;
+};
+
+}  // namespace fur::util
@@ -0,0 +1,73 @@
+#include "bencode/bencode_cursor.hpp"
+
+#include <string>
+#include <string_view>
+
+#include "catch2/catch.hpp"
+
+using namespace fur::bencode;
+
+TEST_CASE("[BencodeCursor] Read scalars") {
+  REQUIRE(*BencodeCursor("i-42e").as_int() == -42);
+  REQUIRE(*BencodeCursor("4:spam").as_string() == "spam");
+  REQUIRE(*BencodeCursor("0:").as_string() == "");
+  REQUIRE(*BencodeCursor("le").type() == BencodeType::List);
+
+  // Bytes after the value are ignored
+  REQUIRE(*BencodeCursor("i7eXYZ").as_int() == 7);
+
+  REQUIRE(BencodeCursor("4:spam").as_int().error() ==
+          BencodeParserError::WrongType);
+  REQUIRE(BencodeCursor("i-0e").as_int().error() ==
+          BencodeParserError::IntValue);
+  REQUIRE(BencodeCursor("10:spam").as_string().error() ==
+          BencodeParserError::InvalidString);
+  REQUIRE(!BencodeCursor("").type().valid());
+}
+
+TEST_CASE("[BencodeCursor] Find keys of nested dictionaries") {
+  const std::string data =
+      "d8:announce3:url4:infod5:filesld6:lengthi3e4:pathl1:a1:beee"
+      "4:name4:test6:pieces3:xyze7:unknownli1ei2eee";
+  BencodeCursor root(data);
+
+  REQUIRE(*root.find_string("announce") == "url");
+  REQUIRE(root.contains("unknown"));
+  REQUIRE(!root.contains("missing"));
+  REQUIRE(root.find("missing").error() == BencodeParserError::MissingKey);
+  REQUIRE(root.find_int("announce").error() == BencodeParserError::WrongType);
+
+  auto info = root.find("info");
+  REQUIRE(info.valid());
+  REQUIRE(*info->find_string("pieces") == "xyz");
+
+  // The raw bytes of a value point inside the data
+  auto raw = info->raw();
+  REQUIRE(raw.valid());
+  REQUIRE(*raw ==
+          "d5:filesld6:lengthi3e4:pathl1:a1:beee4:name4:test6:pieces3:xyze");
+  REQUIRE(raw->data() == data.data() + 22);
+
+  auto files = info->find("files")->items();
+  REQUIRE(files.valid());
+  REQUIRE(files->size() == 1);
+  REQUIRE(*(*files)[0].find_int("length") == 3);
+  auto path = (*files)[0].find("path")->items();
+  REQUIRE(path->size() == 2);
+  REQUIRE(*(*path)[1].as_string() == "b");
+}
+
+TEST_CASE("[BencodeCursor] Malformed data") {
+  // Missing "e" at the end
+  REQUIRE(BencodeCursor("d3:fooi1e").find("bar").error() ==
+          BencodeParserError::DictFormat);
+  REQUIRE(BencodeCursor("li1e").items().error() ==
+          BencodeParserError::ListFormat);
+  REQUIRE(!BencodeCursor("d3:fooli1ee").raw().valid());
+  // Keys must be strings
+  REQUIRE(BencodeCursor("di1ei2ee").find("foo").error() ==
+          BencodeParserError::DictKey);
+  // A value skipped to reach the key is too short
+  REQUIRE(BencodeCursor("d3:foo20:xe3:bari1ee").find("bar").error() ==
+          BencodeParserError::InvalidString);
+}
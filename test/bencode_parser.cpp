@@ -1,5 +1,9 @@
 #include "bencode/bencode_parser.hpp"
 
+#include <limits>
+#include <string>
+#include <string_view>
+
 #include "catch2/catch.hpp"
 using namespace fur::bencode;
 
@@ -36,6 +40,24 @@ TEST_CASE("[BencodeParser::decode()] Wrong decode of a integer") {
   REQUIRE(r_3.error() == BencodeParserError::IntValue);
 }
 
+TEST_CASE("[BencodeParser::decode()] Integers must fit in 64 bits") {
+  BencodeParser parser{};
+  auto r_1 = parser.decode("i-9223372036854775808e");
+  REQUIRE(r_1.valid());
+  REQUIRE(dynamic_cast<BencodeInt&>(*(*r_1)).value() ==
+          std::numeric_limits<int64_t>::min());
+  auto r_2 = parser.decode("i9223372036854775808e");
+  REQUIRE(!r_2.valid());
+  REQUIRE(r_2.error() == BencodeParserError::IntValue);
+  // Only digits are allowed after the sign
+  auto r_3 = parser.decode("i+4e");
+  REQUIRE(!r_3.valid());
+  REQUIRE(r_3.error() == BencodeParserError::IntValue);
+  auto r_4 = parser.decode("i4 e");
+  REQUIRE(!r_4.valid());
+  REQUIRE(r_4.error() == BencodeParserError::IntValue);
+}
+
 TEST_CASE("[BencodeParser::decode()] Correct decode of a string") {
   BencodeParser parser{};
   auto r_1 = parser.decode("4:spam");
@@ -62,6 +84,20 @@ TEST_CASE("[BencodeParser::decode()] Wrong decode of a string") {
   REQUIRE(r_3.error() == BencodeParserError::InvalidString);
 }
 
+TEST_CASE("[BencodeParser::decode()] Strings can contain any byte") {
+  BencodeParser parser{};
+  // The data is not null terminated and the string contains a null byte
+  const std::string data("5:a\0:e1extra", 8);
+  auto r_1 = parser.decode(std::string_view(data.data(), 7));
+  REQUIRE(r_1.valid());
+  REQUIRE(dynamic_cast<BencodeString&>(*(*r_1)).value() ==
+          std::string("a\0:e1", 5));
+  // The length points past the end of the data
+  auto r_2 = parser.decode(std::string_view(data.data(), 6));
+  REQUIRE(!r_2.valid());
+  REQUIRE(r_2.error() == BencodeParserError::InvalidString);
+}
+
 TEST_CASE("[BencodeParser::decode()] Correct decode of a list") {
   BencodeParser parser{};
   auto list = parser.decode("l4:spami42ee");
@@ -138,6 +174,38 @@ TEST_CASE("[BencodeParser::encode()] Correct encode of BencodeValue") {
   REQUIRE(parser.encode(b_5) == "d3:bar4:spam3:fooi42ee");
 }
 
+TEST_CASE("[BencodeParser::encode()] Encode into an existing buffer") {
+  std::vector<std::unique_ptr<BencodeValue>> v;
+  v.push_back(
+      std::make_unique<BencodeInt>(std::numeric_limits<int64_t>::min()));
+  v.push_back(std::make_unique<BencodeString>(""));
+  auto list = BencodeList{std::move(v)};
+
+  // The encoded value is appended after what is already in the buffer
+  std::string out = "prefix";
+  BencodeParser::encode(list, out);
+  REQUIRE(out == "prefixli-9223372036854775808e0:e");
+  BencodeParser::encode(BencodeInt{0}, out);
+  REQUIRE(out == "prefixli-9223372036854775808e0:ei0e");
+}
+
+TEST_CASE("[BencodeParser::span()] Raw bytes of the outermost dictionary") {
+  BencodeParser parser{};
+  // Keys with the same name in nested dictionaries are not recorded
+  std::string_view data = "d4:infod3:fooi1ee4:listld4:spami2eeee";
+  auto b = parser.decode(data);
+  REQUIRE(b.valid());
+  REQUIRE(parser.span("info") == "d3:fooi1ee");
+  REQUIRE(parser.span("info")->data() == data.data() + 7);
+  REQUIRE(parser.span("list") == "ld4:spami2eee");
+  REQUIRE(!parser.span("foo").has_value());
+  REQUIRE(!parser.span("spam").has_value());
+
+  // Spans are reset on every decode, even when the outer value is a list
+  REQUIRE(parser.decode("ld4:infoi1eee").valid());
+  REQUIRE(!parser.span("info").has_value());
+}
+
 TEST_CASE(
     "[BencodeParser::decode()] No invalid length of a string with 'i' chars") {
   BencodeParser parser{};
@@ -156,7 +224,8 @@ TEST_CASE("[BencodeParser:error_to_string()] Test unread error") {
   std::vector<std::string> s = {
       "InvalidString", "IntFormat",    "IntValue",
       "StringFormat",  "ListFormat",   "DictFormat",
-      "DictKey",       "DictKeyOrder", "<invalid parser error>"};
+      "DictKey",       "DictKeyOrder", "MissingKey",
+      "WrongType",     "<invalid parser error>"};
   for (int64_t i = 0; i < static_cast<int64_t>(s.size()); i++) {
     REQUIRE(error_to_string(static_cast<BencodeParserError>(i)) == s[i]);
   }
@@ -0,0 +1,84 @@
+#include "bencode/bencode_reader.hpp"
+
+#include <string>
+#include <string_view>
+
+#include "catch2/catch.hpp"
+
+using namespace fur::bencode;
+
+/// Writes every event in a compact textual form
+class RecordingHandler : public BencodeHandler {
+ public:
+  std::string events;
+
+  void on_int(int64_t value) override {
+    events += "int(" + std::to_string(value) + ") ";
+  }
+  void on_string(std::string_view value) override {
+    events += "str(" + std::string(value) + ") ";
+  }
+  void on_list_begin() override { events += "list "; }
+  void on_dict_begin() override { events += "dict "; }
+  void on_key(std::string_view key) override {
+    events += "key(" + std::string(key) + ") ";
+  }
+  void on_end() override { events += "end "; }
+};
+
+TEST_CASE("[BencodeReader] Events of a whole value") {
+  RecordingHandler handler;
+  BencodeReader reader(handler);
+  REQUIRE(reader.feed("d3:barl4:spami-3ee3:fooi42ee").valid());
+  REQUIRE(reader.finish().valid());
+  REQUIRE(handler.events ==
+          "dict key(bar) list str(spam) int(-3) end key(foo) int(42) end ");
+}
+
+TEST_CASE("[BencodeReader] Values split between chunks") {
+  const std::string data = "d8:intervali1800e5:peers12:abcdefghijkle";
+
+  // Every possible split in two chunks gives the same events
+  for (size_t split = 0; split <= data.size(); split++) {
+    RecordingHandler handler;
+    BencodeReader reader(handler);
+    REQUIRE(reader.feed(std::string_view(data).substr(0, split)).valid());
+    REQUIRE(reader.feed(std::string_view(data).substr(split)).valid());
+    REQUIRE(reader.finish().valid());
+    REQUIRE(handler.events ==
+            "dict key(interval) int(1800) key(peers) str(abcdefghijkl) end ");
+  }
+
+  // One byte at a time
+  RecordingHandler handler;
+  BencodeReader reader(handler);
+  for (char byte : data)
+    REQUIRE(reader.feed(std::string_view(&byte, 1)).valid());
+  REQUIRE(reader.finish().valid());
+}
+
+TEST_CASE("[BencodeReader] Invalid data") {
+  RecordingHandler handler;
+
+  // Keys must be strings
+  BencodeReader key(handler);
+  REQUIRE(key.feed("di1ei2ee").error() == BencodeParserError::DictKey);
+  // Once failed every chunk is rejected
+  REQUIRE(!key.feed("e").valid());
+
+  // A key without its value
+  BencodeReader value(handler);
+  REQUIRE(value.feed("d3:fooe").error() == BencodeParserError::DictFormat);
+
+  // Nothing after the outermost value
+  BencodeReader trailing(handler);
+  REQUIRE(trailing.feed("i1ei2e").error() == BencodeParserError::InvalidString);
+
+  // Data ended in the middle of a value
+  BencodeReader truncated(handler);
+  REQUIRE(truncated.feed("l4:spa").valid());
+  REQUIRE(truncated.finish().error() == BencodeParserError::InvalidString);
+
+  BencodeReader integer(handler);
+  REQUIRE(integer.feed("i12x4e").error() == BencodeParserError::IntValue);
+}
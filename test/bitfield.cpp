@@ -96,3 +96,12 @@ TEST_CASE("[Bitfield] Get bytes") {
   std::vector<uint8_t> bytes{128, 3};
   REQUIRE(bytes == Bitfield(bytes, 16).get_bytes());
 }
+
+TEST_CASE("[Bitfield] Count") {
+  REQUIRE(Bitfield(10).count() == 0);
+
+  Bitfield bf{std::vector<uint8_t>{3, 130}, 15};
+  REQUIRE(bf.count() == 4);
+  bf.unset(0 + 7);
+  REQUIRE(bf.count() == 3);
+}
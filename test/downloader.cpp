@@ -74,7 +74,7 @@ TEST_CASE("[Downloader] Download one piece, same size as a block") {
       TestingFriend::Downloader_try_download(down, Piece{0, subpieces});
 
   REQUIRE(maybe_downloaded.valid());
-  auto downloaded = *maybe_downloaded;
+  auto& downloaded = *maybe_downloaded;
 
   // 16384 is 16KB
   REQUIRE(downloaded.content.size() == 16384);
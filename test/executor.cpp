@@ -0,0 +1,71 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mt/executor.hpp>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+using namespace fur::mt;
+
+TEST_CASE("[Executor] Every job is executed once") {
+  const int64_t JOBS = 10000;
+  Executor executor(4);
+
+  std::vector<std::atomic_int64_t> calls(JOBS);
+  for (int64_t i = 0; i < JOBS; i++)
+    executor.submit([&calls, i] { calls[i] += 1; });
+  executor.wait_idle();
+
+  for (int64_t i = 0; i < JOBS; i++) REQUIRE(calls[i] == 1);
+}
+
+TEST_CASE("[Executor] Jobs can submit other jobs") {
+  Executor executor(4);
+  std::atomic_int64_t leaves{0};
+
+  // Every job splits in two until the depth is reached, jobs submitted from
+  // the pool go to the deque of their thread and are stolen by the others
+  std::function<void(int64_t)> split = [&](int64_t depth) {
+    if (depth == 0) {
+      leaves += 1;
+      return;
+    }
+    executor.submit([&split, depth] { split(depth - 1); });
+    executor.submit([&split, depth] { split(depth - 1); });
+  };
+  executor.submit([&] { split(12); });
+  executor.wait_idle();
+
+  REQUIRE(leaves == 4096);
+}
+
+TEST_CASE("[Executor] Jobs left in the deques are dropped on shutdown") {
+  Executor executor(1);
+
+  std::atomic_int64_t calls{0};
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+
+  // The only thread is kept busy by the first job
+  executor.submit([&] {
+    started = true;
+    while (!release) std::this_thread::yield();
+    calls += 1;
+  });
+  while (!started) std::this_thread::yield();
+  for (int64_t i = 0; i < 4; i++) executor.submit([&] { calls += 1; });
+
+  // Shutting down waits for the running job
+  std::thread stopper([&] { executor.shutdown(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  release = true;
+  stopper.join();
+  REQUIRE(calls == 1);
+
+  // Submissions after the shutdown are ignored
+  executor.submit([&] { calls += 1; });
+  executor.wait_idle();
+  REQUIRE(calls == 1);
+}
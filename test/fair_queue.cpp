@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <policy/fair_queue.hpp>
+#include <vector>
+
+using namespace fur::policy;
+
+/// An item of a flow, worth `cost`
+struct FlowItem {
+  int64_t flow;
+  int64_t cost;
+};
+
+struct ItemFlow {
+  static int64_t key(const FlowItem& item) { return item.flow; }
+  static int64_t cost(const FlowItem& item) { return item.cost; }
+
+  /// Items of a flow go in order of insertion unless a flow has a pivot,
+  /// then the items closer to it go first
+  struct Rank {
+    int64_t pivot = 0;
+    int64_t operator()(const FlowItem& item) const {
+      return pivot == 0 ? 0 : std::abs(item.cost - pivot);
+    }
+  };
+};
+
+using Fair = FairQueue<FlowItem, ItemFlow>;
+
+/// @return number of items extracted from every flow out of `count`
+static std::vector<int64_t> serve(Fair& queue, int64_t count, int64_t flows) {
+  std::vector<int64_t> served(flows, 0);
+  for (int64_t i = 0; i < count; i++) {
+    auto item = queue.extract();
+    REQUIRE(item.valid());
+    served[item->flow] += 1;
+  }
+  return served;
+}
+
+TEST_CASE("[FairQueue] Flows are served in proportion to their weights") {
+  Fair queue;
+  auto nothing = queue.extract();
+  REQUIRE(!nothing.valid());
+  REQUIRE(nothing.error() == Fair::Error::Empty);
+
+  // The second flow is added last and must not starve the first one
+  queue.set_share(1, 3, 0);
+  for (int64_t i = 0; i < 1000; i++) queue.emplace(FlowItem{0, 10});
+  for (int64_t i = 0; i < 1000; i++) queue.emplace(FlowItem{1, 10});
+  REQUIRE(queue.size() == 2000);
+
+  auto served = serve(queue, 400, 2);
+  REQUIRE(served[0] >= 99);
+  REQUIRE(served[0] <= 101);
+
+  // Costs count, not the number of items
+  Fair costly;
+  for (int64_t i = 0; i < 1000; i++) costly.emplace(FlowItem{0, 10});
+  for (int64_t i = 0; i < 1000; i++) costly.emplace(FlowItem{1, 40});
+  served = serve(costly, 500, 2);
+  REQUIRE(served[0] >= 399);
+  REQUIRE(served[0] <= 401);
+
+  REQUIRE(costly.stats(0).served == served[0]);
+  REQUIRE(costly.stats(0).cost == served[0] * 10);
+  REQUIRE(costly.total().served == 500);
+}
+
+TEST_CASE("[FairQueue] Higher classes go first and idle flows don't catch up") {
+  Fair queue;
+  queue.set_share(2, 1, 1);
+  for (int64_t i = 0; i < 10; i++) queue.emplace(FlowItem{0, 1});
+  for (int64_t i = 0; i < 5; i++) queue.emplace(FlowItem{2, 1});
+
+  // The whole higher class first
+  auto served = serve(queue, 5, 3);
+  REQUIRE(served[2] == 5);
+
+  // The first flow alone for a while, then a new flow joins
+  served = serve(queue, 5, 3);
+  REQUIRE(served[0] == 5);
+  for (int64_t i = 0; i < 10; i++) queue.emplace(FlowItem{1, 1});
+  for (int64_t i = 0; i < 10; i++) queue.emplace(FlowItem{0, 1});
+  served = serve(queue, 10, 3);
+  REQUIRE(served[0] >= 4);
+  REQUIRE(served[1] <= 6);
+
+  // Items removed from all flows, only the first flow is left
+  queue.mutate([](FlowItem& item) { return item.flow == 1; });
+  REQUIRE(queue.size() == 15 - served[0]);
+}
+
+TEST_CASE("[FairQueue] Parked flows keep their items aside") {
+  Fair queue;
+  for (int64_t i = 0; i < 10; i++) queue.emplace(FlowItem{0, 1});
+  for (int64_t i = 0; i < 10; i++) queue.emplace(FlowItem{1, 1});
+
+  queue.park(1);
+  REQUIRE(queue.size() == 10);
+  REQUIRE(queue.parked() == 10);
+
+  // Items of a parked flow are never extracted, new ones are parked too
+  queue.emplace(FlowItem{1, 1});
+  auto served = serve(queue, 10, 2);
+  REQUIRE(served[0] == 10);
+  REQUIRE(queue.size() == 0);
+  auto nothing = queue.extract();
+  REQUIRE(!nothing.valid());
+  REQUIRE(nothing.error() == Fair::Error::Empty);
+
+  // Everything is back at once
+  queue.unpark(1);
+  REQUIRE(queue.size() == 11);
+  REQUIRE(queue.parked() == 0);
+  served = serve(queue, 11, 2);
+  REQUIRE(served[1] == 11);
+}
+
+TEST_CASE("[FairQueue] Every flow ranks its own items") {
+  Fair queue;
+  for (int64_t cost = 1; cost <= 5; cost++) queue.emplace(FlowItem{0, cost});
+  for (int64_t cost = 1; cost <= 5; cost++) queue.emplace(FlowItem{1, cost});
+
+  // Only the first flow has a pivot, the ranking changes after a rerank
+  queue.rank(0).pivot = 4;
+  queue.rerank(0);
+  queue.set_share(1, 1, 1);
+  REQUIRE(queue.extract()->cost == 1);
+  queue.set_share(1, 1, 0);
+  queue.set_share(0, 1, 1);
+  REQUIRE(queue.extract()->cost == 4);
+
+  // Items inserted later are ranked when they arrive
+  queue.emplace(FlowItem{0, 4});
+  REQUIRE(queue.extract()->cost == 4);
+  queue.rank(0).pivot = 1;
+  queue.rerank(0);
+  REQUIRE(queue.extract()->cost == 1);
+  REQUIRE(queue.extract()->cost == 2);
+}
+
+TEST_CASE("[FairQueue] Erased flows are forgotten") {
+  Fair queue;
+  for (int64_t flow = 0; flow < 3; flow++) {
+    for (int64_t i = 0; i < 10; i++) queue.emplace(FlowItem{flow, 1});
+  }
+  queue.park(2);
+  REQUIRE(serve(queue, 4, 3)[2] == 0);
+  REQUIRE(queue.stats(1).served == 2);
+
+  // Items go away with their flow, parked or not
+  queue.erase(1);
+  queue.erase(2);
+  REQUIRE(queue.size() == 8);
+  REQUIRE(queue.parked() == 0);
+  REQUIRE(queue.stats(1).served == 0);
+  REQUIRE(serve(queue, 8, 3)[0] == 8);
+  REQUIRE(!queue.extract().valid());
+
+  // A flow comes back as a new one
+  queue.emplace(FlowItem{2, 1});
+  REQUIRE(queue.size() == 1);
+  REQUIRE(queue.extract()->flow == 2);
+
+  // Every flow is served once with many of them
+  for (int64_t flow = 0; flow < 1000; flow++) queue.emplace(FlowItem{flow, 1});
+  auto served = serve(queue, 1000, 1000);
+  REQUIRE(std::all_of(served.begin(), served.end(),
+                      [](int64_t count) { return count == 1; }));
+}
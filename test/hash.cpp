@@ -67,3 +67,20 @@ TEST_CASE("[Hash] SHA1 dependency is correct") {
 
   REQUIRE(hash_to_hex(hash) == "3a773b8553a663941552a0df3b5968b4695cb212");
 }
+
+TEST_CASE("[Hash] Verify many pieces at once") {
+  std::vector<uint8_t> content(1000);
+  for (int64_t i = 0; i < 1000; i++) content[i] = i * 3;
+
+  std::vector<hash_t> hashes(10);
+  std::vector<PieceView> pieces;
+  for (int64_t i = 0; i < 10; i++) {
+    sha1::calc(content.data() + i * 100, 100, hashes[i].data());
+    pieces.push_back({content.data() + i * 100, 100, &hashes[i]});
+  }
+  hashes[4][0] ^= 1;
+
+  auto valid = verify_pieces(pieces);
+  REQUIRE(valid.size() == 10);
+  for (int64_t i = 0; i < 10; i++) REQUIRE(valid[i] == (i != 4));
+}
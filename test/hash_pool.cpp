@@ -0,0 +1,93 @@
+#include "download/hash_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "smallsha1/sha1.hpp"
+
+using namespace fur;
+using namespace fur::download;
+
+/// A piece of `len` bytes whose content depends on its index
+static Downloaded make_piece(int64_t index, int64_t len) {
+  PieceBuffer content(len);
+  for (int64_t i = 0; i < len; i++) content.data()[i] = index + i * 5;
+  return {index, std::move(content)};
+}
+
+TEST_CASE("[HashPool] Every piece is verified once") {
+  const int64_t PIECES = 100;
+  const int64_t CAPACITY = 4;
+  HashPool pool(CAPACITY, 2);
+
+  std::mutex mutex;
+  std::vector<int64_t> calls(PIECES, 0);
+  std::vector<bool> outcomes(PIECES, false);
+
+  for (int64_t index = 0; index < PIECES; index++) {
+    auto piece = make_piece(index, 1000 + index);
+    hash::hash_t expected;
+    sha1::calc(piece.content.data(), static_cast<int>(piece.content.size()),
+               expected.data());
+    // Every tenth piece is corrupt
+    if (index % 10 == 0) expected[0] ^= 1;
+
+    pool.submit(std::move(piece), expected,
+                [&](Downloaded verified, bool valid) {
+                  std::scoped_lock<std::mutex> lock(mutex);
+                  calls[verified.index] += 1;
+                  outcomes[verified.index] = valid;
+                });
+  }
+  pool.wait_idle();
+
+  for (int64_t index = 0; index < PIECES; index++) {
+    REQUIRE(calls[index] == 1);
+    REQUIRE(outcomes[index] == (index % 10 != 0));
+  }
+
+  auto stats = pool.stats();
+  REQUIRE(stats.queue_depth == 0);
+  REQUIRE(stats.max_queue_depth <= CAPACITY);
+  REQUIRE(stats.verified == PIECES);
+  REQUIRE(stats.corrupt == 10);
+  REQUIRE(stats.max_latency >= stats.mean_latency);
+}
+
+TEST_CASE("[HashPool] Pieces left in the queue are dropped on shutdown") {
+  HashPool pool(8, 1);
+
+  std::atomic_int64_t calls{0};
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+
+  // The only thread is kept busy by the first piece
+  pool.submit(make_piece(0, 10), {}, [&](Downloaded, bool) {
+    started = true;
+    while (!release) std::this_thread::yield();
+    calls += 1;
+  });
+  while (!started) std::this_thread::yield();
+
+  for (int64_t index = 1; index < 5; index++) {
+    pool.submit(make_piece(index, 10), {},
+                [&](Downloaded, bool) { calls += 1; });
+  }
+  REQUIRE(pool.stats().queue_depth == 4);
+
+  // Shutting down waits for the running piece
+  std::thread stopper([&] { pool.shutdown(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  release = true;
+  stopper.join();
+  REQUIRE(calls == 1);
+
+  // Submissions after the shutdown are ignored
+  pool.submit(make_piece(5, 10), {}, [&](Downloaded, bool) { calls += 1; });
+  REQUIRE(calls == 1);
+  REQUIRE(pool.stats().queue_depth == 0);
+}
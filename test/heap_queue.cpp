@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <memory>
+#include <policy/heap_queue.hpp>
+#include <random>
+#include <vector>
+
+using namespace fur::policy;
+
+/// Items are move-only, as the tasks of the workers
+struct Item {
+  std::unique_ptr<int64_t> value;
+  explicit Item(int64_t x) : value{std::make_unique<int64_t>(x)} {}
+};
+
+/// Ranks items by value, or by distance from a target once one is set
+struct ItemRank {
+  int64_t target = 0;
+  int64_t operator()(const Item& item) const {
+    const int64_t distance = *item.value - target;
+    return distance < 0 ? -distance : distance;
+  }
+};
+
+/// @return values of all the items in extraction order
+static std::vector<int64_t> drain(HeapQueue<Item, ItemRank>& queue) {
+  std::vector<int64_t> order;
+  while (queue.size() > 0) order.push_back(*queue.extract()->value);
+  return order;
+}
+
+TEST_CASE("[HeapQueue] Lowest rank first, ties in insertion order") {
+  HeapQueue<Item, ItemRank> queue;
+  auto nothing = queue.extract();
+  REQUIRE(!nothing.valid());
+  REQUIRE(nothing.error() == HeapQueue<Item, ItemRank>::Error::Empty);
+
+  queue.rank().target = 5;
+  for (int64_t value : {7, 3, 9, 5, 4, 6}) queue.emplace(value);
+  REQUIRE(drain(queue) == std::vector<int64_t>{5, 4, 6, 7, 3, 9});
+
+  // Same order as a linear scan on random ranks
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int64_t> values(0, 100);
+  std::vector<int64_t> inserted;
+  for (int64_t i = 0; i < 1000; i++) {
+    inserted.push_back(values(gen));
+    queue.insert(Item(inserted.back()));
+  }
+  std::stable_sort(inserted.begin(), inserted.end(), [](int64_t a, int64_t b) {
+    return ItemRank{5}(Item(a)) < ItemRank{5}(Item(b));
+  });
+  REQUIRE(drain(queue) == inserted);
+}
+
+TEST_CASE("[HeapQueue] Items are updated in place") {
+  HeapQueue<Item, ItemRank> queue;
+  std::vector<HeapQueue<Item, ItemRank>::Handle> handles;
+  for (int64_t value : {10, 20, 30, 40})
+    handles.push_back(queue.emplace(value));
+
+  // Moves to the top and to the bottom
+  queue.update(handles[2], [](Item& item) { *item.value = 1; });
+  queue.update(handles[0], [](Item& item) { *item.value = 50; });
+  REQUIRE(*queue.top().value == 1);
+  REQUIRE(drain(queue) == std::vector<int64_t>{1, 20, 40, 50});
+}
+
+TEST_CASE("[HeapQueue] Ranking changes and mutations") {
+  HeapQueue<Item, ItemRank> queue;
+  for (int64_t value = 0; value < 10; value++) queue.emplace(value);
+
+  // Ranks change only after all items are ranked again
+  queue.rank().target = 9;
+  queue.rerank();
+  REQUIRE(*queue.extract()->value == 9);
+
+  // Odd values are removed, the others keep their ranks
+  queue.mutate([](Item& item) { return *item.value % 2 != 0; });
+  REQUIRE(queue.size() == 5);
+  REQUIRE(drain(queue) == std::vector<int64_t>{8, 6, 4, 2, 0});
+
+  // Handles of extracted items are reused
+  auto handle = queue.emplace(3);
+  queue.update(handle, [](Item& item) { *item.value = 4; });
+  REQUIRE(*queue.extract()->value == 4);
+}
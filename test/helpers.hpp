@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "hash.hpp"
+#include "smallsha1/sha1.hpp"
+#include "torrent.hpp"
+
+/// Returns the path of a temporary folder for the current test, anything a
+/// previous run left there is removed but the folder is not created
+inline std::string temp_path(const std::string& name) {
+  auto path = std::filesystem::temp_directory_path() / ("furrent_" + name);
+  std::filesystem::remove_all(path);
+  return path.string();
+}
+
+/// Returns a fresh, empty, temporary folder for the current test
+inline std::string make_temp_folder(const std::string& name) {
+  auto path = temp_path(name);
+  std::filesystem::create_directories(path);
+  return path;
+}
+
+/// Creates a torrent made of two files, "a" of 10 bytes and "sub/b" of
+/// `second_len` bytes, with pieces of 4 bytes. Nothing is created on disk, the
+/// piece hashes match a content where the byte at offset `i` is `i`.
+inline fur::TorrentFile make_two_files_torrent(const std::string& folder_name,
+                                               int64_t second_len = 7) {
+  fur::TorrentFile descriptor;
+  descriptor.piece_length = 4;
+  descriptor.length = 10 + second_len;
+  descriptor.pieces_count = (descriptor.length + 3) / 4;
+  descriptor.folder_name = folder_name;
+  descriptor.files = {fur::File{{"a"}, 10},
+                      fur::File{{"sub", "b"}, second_len}};
+
+  for (int64_t index = 0; index < descriptor.pieces_count; index++) {
+    std::vector<uint8_t> content;
+    for (int64_t i = index * 4; i < std::min(descriptor.length, index * 4 + 4);
+         i++)
+      content.push_back(static_cast<uint8_t>(i));
+
+    fur::hash::hash_t hash;
+    sha1::calc(content.data(), static_cast<int>(content.size()), hash.data());
+    descriptor.piece_hashes.push_back(hash);
+  }
+  return descriptor;
+}
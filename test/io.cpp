@@ -0,0 +1,121 @@
+#include "platform/io.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "helpers.hpp"
+
+using namespace fur::platform::io;
+
+/// Loads the raw content of a file
+static std::vector<char> load_bytes(const std::string& filepath) {
+  std::ifstream stream(filepath, std::ios::binary);
+  return {std::istreambuf_iterator<char>(stream),
+          std::istreambuf_iterator<char>()};
+}
+
+TEST_CASE("[IO] Touch with all preallocation modes") {
+  auto folder = make_temp_folder("io_touch");
+  const int64_t SIZE = 100000;
+
+  REQUIRE(touch(folder + "/none", SIZE, Preallocation::None).valid());
+  REQUIRE(std::filesystem::file_size(folder + "/none") == 0);
+
+  for (auto mode : {Preallocation::Sparse, Preallocation::Full}) {
+    const std::string filepath =
+        folder + "/file" + std::to_string(static_cast<int>(mode));
+    REQUIRE(touch(filepath, SIZE, mode).valid());
+    REQUIRE(std::filesystem::file_size(filepath) == SIZE);
+
+    // No stray byte must be left at the end of the file
+    auto bytes = load_bytes(filepath);
+    REQUIRE(std::all_of(bytes.begin(), bytes.end(),
+                        [](char byte) { return byte == 0; }));
+  }
+
+  // Empty files are valid torrent files
+  REQUIRE(touch(folder + "/empty", 0, Preallocation::Full).valid());
+  REQUIRE(std::filesystem::file_size(folder + "/empty") == 0);
+
+  std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("[IO] Touch an existing file") {
+  auto folder = make_temp_folder("io_touch_existing");
+  REQUIRE(touch(folder + "/file", 10).valid());
+
+  auto again = touch(folder + "/file", 10);
+  REQUIRE(!again.valid());
+  REQUIRE(again.error() == IOError::FileAlreadyExists);
+
+  std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("[IO] Write bytes to a lazily allocated file") {
+  auto folder = make_temp_folder("io_lazy");
+  const std::string filepath = folder + "/file";
+  REQUIRE(touch(filepath, 8, Preallocation::None).valid());
+
+  std::vector<uint8_t> bytes{1, 2, 3, 4};
+  REQUIRE(write_bytes(filepath, bytes, 4).valid());
+  REQUIRE(load_bytes(filepath) == std::vector<char>{0, 0, 0, 0, 1, 2, 3, 4});
+
+  std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("[IO] Map a whole file") {
+  auto folder = make_temp_folder("io_mapped");
+  const std::string filepath = folder + "/file";
+  std::ofstream(filepath, std::ios::binary) << std::string("d3:fooi1ee\0x", 12);
+
+  auto mapped = MappedFile::open(filepath);
+  REQUIRE(mapped.valid());
+  REQUIRE(mapped->size() == 12);
+  REQUIRE(mapped->view() == std::string_view("d3:fooi1ee\0x", 12));
+
+  // Moving keeps the mapping alive
+  MappedFile moved = std::move(*mapped);
+  REQUIRE(moved.view().substr(0, 3) == "d3:");
+  REQUIRE(mapped->view().empty());
+
+  const std::string empty = folder + "/empty";
+  std::ofstream(empty, std::ios::binary).close();
+  auto empty_mapped = MappedFile::open(empty);
+  REQUIRE(empty_mapped.valid());
+  REQUIRE(empty_mapped->size() == 0);
+
+  auto missing = MappedFile::open(folder + "/missing");
+  REQUIRE(!missing.valid());
+  REQUIRE(missing.error() == IOError::CannotOpenFile);
+
+  std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("[IO] List the files of a folder") {
+  auto folder = make_temp_folder("io_list");
+  for (const std::string name : {"b.torrent", "a.torrent", "c.txt"})
+    std::ofstream(folder + "/" + name) << name;
+  std::filesystem::create_directories(folder + "/d.torrent");
+
+  // Folders are never listed, even with the right extension
+  auto torrents = list_files(folder, ".torrent");
+  REQUIRE(torrents.valid());
+  REQUIRE(*torrents == std::vector<std::string>{folder + "/a.torrent",
+                                                folder + "/b.torrent"});
+
+  auto none = list_files(folder, ".bencode");
+  REQUIRE(none.valid());
+  REQUIRE(none->empty());
+
+  auto missing = list_files(folder + "/missing", ".torrent");
+  REQUIRE(!missing.valid());
+  REQUIRE(missing.error() == IOError::PathDoesNotExists);
+
+  std::filesystem::remove_all(folder);
+}
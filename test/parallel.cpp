@@ -0,0 +1,26 @@
+#include <atomic>
+#include <mt/parallel.hpp>
+#include <stdexcept>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+using namespace fur::mt;
+
+TEST_CASE("[Parallel] Every job is executed once") {
+  const int64_t JOBS = 1000;
+  std::vector<std::atomic_int64_t> executions(JOBS);
+
+  parallel_for(JOBS, [&](int64_t index) { executions[index] += 1; });
+
+  for (auto& execution : executions) REQUIRE(execution == 1);
+}
+
+TEST_CASE("[Parallel] Exceptions are propagated") {
+  REQUIRE_THROWS_AS(parallel_for(100,
+                                 [](int64_t index) {
+                                   if (index == 42)
+                                     throw std::runtime_error("failure");
+                                 }),
+                    std::runtime_error);
+}
@@ -1,5 +1,8 @@
 #include "peer.hpp"
 
+#include <string>
+#include <string_view>
+
 #include "catch2/catch.hpp"
 
 using namespace fur::peer;
@@ -26,7 +29,7 @@ TEST_CASE("[Peer] Build from invalid IP string") {
 // Not publicly declared in "src/peer.hpp" because not really part of the public
 // API
 namespace fur::peer {
-Announce parse_tracker_response(const std::string& text);
+PeerResult parse_tracker_response(std::string_view text);
 }
 
 TEST_CASE("[Peer] Parse tracker response") {
@@ -34,11 +37,30 @@ TEST_CASE("[Peer] Parse tracker response") {
       "d8:intervali900e5:peers6:"
       "\xc0\x00\x02\x7b\x1a\xe1"
       "e";
-  Announce result =
-      parse_tracker_response(std::string{raw, sizeof(raw) - 1});
-  REQUIRE(result.interval == 900);
-  REQUIRE(result.peers.size() == 1);
+  auto result = parse_tracker_response(std::string{raw, sizeof(raw) - 1});
+  REQUIRE(result.valid());
+  REQUIRE(result->interval == 900);
+  REQUIRE(result->peers.size() == 1);
 
-  Peer peer = result.peers[0];
+  Peer peer = result->peers[0];
   REQUIRE(peer.address() == "192.0.2.123:6881");
 }
+
+TEST_CASE("[Peer] Parse tracker response with many peers") {
+  // Unknown keys are skipped without being decoded
+  char raw[] =
+      "d8:completei5e8:intervali1800e5:peers12:"
+      "\x7f\x00\x00\x01\x10\x92"
+      "\x0a\x00\x00\x02\x1a\xe1"
+      "5:tracker10:some stuffe";
+  auto result = parse_tracker_response(std::string{raw, sizeof(raw) - 1});
+  REQUIRE(result.valid());
+  REQUIRE(result->interval == 1800);
+  REQUIRE(result->peers.size() == 2);
+  REQUIRE(result->peers[0].address() == "127.0.0.1:4242");
+  REQUIRE(result->peers[1].address() == "10.0.0.2:6881");
+
+  // Peers must be six bytes each
+  REQUIRE(!parse_tracker_response("d8:intervali1e5:peers5:12345e").valid());
+  REQUIRE(!parse_tracker_response("d5:peers0:e").valid());
+}
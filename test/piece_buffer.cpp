@@ -0,0 +1,57 @@
+#include "download/piece_buffer.hpp"
+
+#include <utility>
+
+#include "catch2/catch.hpp"
+
+using namespace fur::download;
+
+TEST_CASE("[PieceBuffer] Buffers are recycled") {
+  PieceBufferPool pool(1024 * 1024, false);
+
+  uint8_t* first_data;
+  {
+    PieceBuffer buffer = pool.acquire(16384);
+    REQUIRE(buffer.size() == 16384);
+    first_data = buffer.data();
+    first_data[0] = 42;
+  }
+  REQUIRE(pool.allocations() == 1);
+  REQUIRE(pool.retained_bytes() >= 16384);
+
+  // A smaller piece reuses the same memory, without clearing it
+  PieceBuffer buffer = pool.acquire(1000);
+  REQUIRE(buffer.size() == 1000);
+  REQUIRE(buffer.data() == first_data);
+  REQUIRE(buffer.data()[0] == 42);
+  REQUIRE(pool.allocations() == 1);
+  REQUIRE(pool.retained_bytes() == 0);
+
+  // Moving a buffer never copies its content
+  PieceBuffer moved = std::move(buffer);
+  REQUIRE(moved.data() == first_data);
+  REQUIRE(buffer.data() == nullptr);
+
+  // No free buffer left, a new one is allocated
+  PieceBuffer other = pool.acquire(16384);
+  REQUIRE(other.data() != first_data);
+  REQUIRE(pool.allocations() == 2);
+}
+
+TEST_CASE("[PieceBuffer] Unused memory is bounded") {
+  PieceBufferPool pool(100000, true);
+  {
+    PieceBuffer first = pool.acquire(65536);
+    PieceBuffer second = pool.acquire(65536);
+  }
+
+  // Only one of the two buffers fits the limit
+  REQUIRE(pool.retained_bytes() == 65536);
+
+  // Buffers can outlive their pool
+  PieceBuffer buffer = [] {
+    PieceBufferPool temporary(100000, false);
+    return temporary.acquire(10);
+  }();
+  REQUIRE(buffer.size() == 10);
+}
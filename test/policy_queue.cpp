@@ -1,5 +1,6 @@
 #include <catch2/catch.hpp>
 #include <policy/queue.hpp>
+#include <vector>
 
 using namespace fur::policy;
 
@@ -41,4 +42,49 @@ TEST_CASE("Queue") {
 
   REQUIRE(!nothing.valid());
   REQUIRE(nothing.error() == Queue<Movable>::Error::Empty);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Queue with rank policy") {
+  Queue<Movable> queue;
+  for (int64_t value : {7, 3, 9, 3, 5}) queue.emplace(value);
+
+  // Lowest values first, ties in insertion order
+  RankPolicy<Movable> policy([](const Movable& m) { return m.value; });
+  std::vector<int64_t> order;
+  while (queue.size() > 0) order.push_back(queue.extract(policy)->value);
+  REQUIRE(order == std::vector<int64_t>{3, 3, 5, 7, 9});
+
+  // The search stops at the first element with the best rank
+  int64_t ranked = 0;
+  for (int64_t value : {4, 1, 1, 8}) queue.emplace(value);
+  RankPolicy<Movable> counting(
+      [&](const Movable& m) {
+        ranked += 1;
+        return m.value;
+      },
+      1);
+  REQUIRE(queue.extract(counting)->value == 1);
+  REQUIRE(ranked == 2);
+}
+
+TEST_CASE("Queue reuses the nodes of extracted items") {
+  Queue<Movable> queue;
+  queue.emplace(1);
+  const Movable* node = &queue.items().front();
+
+  FIFOPolicy<Movable> policy;
+  auto extracted = queue.extract(policy);
+  REQUIRE(extracted.valid());
+  REQUIRE(queue.size() == 0);
+
+  // Putting the item back takes the same memory it had before
+  queue.insert(std::move(*extracted));
+  REQUIRE(queue.size() == 1);
+  REQUIRE(&queue.items().front() == node);
+  REQUIRE(queue.items().front().value == 1);
+
+  REQUIRE(queue.extract(policy).valid());
+  queue.emplace(2);
+  REQUIRE(&queue.items().front() == node);
+  REQUIRE(queue.extract(policy)->value == 2);
+}
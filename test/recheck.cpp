@@ -0,0 +1,79 @@
+#include "recheck.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "helpers.hpp"
+#include "mt/parallel.hpp"
+#include "smallsha1/sha1.hpp"
+#include "storage/file.hpp"
+
+using namespace fur;
+using namespace fur::recheck;
+
+/// Writes a file made of consecutive bytes starting from `first`
+static void write_file(const std::string& filepath, int64_t len,
+                       uint8_t first) {
+  std::ofstream stream(filepath, std::ios::binary);
+  for (int64_t i = 0; i < len; i++)
+    stream.put(static_cast<char>(static_cast<uint8_t>(first + i)));
+}
+
+TEST_CASE("[Recheck] Only valid pieces are kept") {
+  const std::filesystem::path folder = make_temp_folder("recheck");
+  std::filesystem::create_directories(folder / "sub");
+
+  // The third piece crosses the boundary between the files
+  TorrentFile descriptor = make_two_files_torrent(folder.string());
+
+  write_file(descriptor.folder_name + "/a", 10, 0);
+  // The second file is missing its last byte, so the last piece is invalid
+  write_file(descriptor.folder_name + "/sub/b", 6, 10);
+
+  storage::FileBackend storage;
+  auto report = recheck::recheck(descriptor, storage);
+  REQUIRE(report.bytes_read == 16);
+  REQUIRE(report.valid_pieces.count() == 4);
+  REQUIRE(!report.valid_pieces.get(4));
+
+  // Corrupt the second piece
+  {
+    std::fstream stream(descriptor.folder_name + "/a",
+                        std::ios::binary | std::ios::in | std::ios::out);
+    stream.seekp(5);
+    stream.put(42);
+  }
+
+  auto corrupted = recheck::recheck(descriptor, storage);
+  REQUIRE(corrupted.valid_pieces.get(0));
+  REQUIRE(!corrupted.valid_pieces.get(1));
+  REQUIRE(corrupted.valid_pieces.get(2));
+  REQUIRE(corrupted.valid_pieces.get(3));
+
+  // Only the selected pieces are read, the others are never valid
+  Bitfield selected(descriptor.pieces_count);
+  selected.set(1);
+  selected.set(3);
+  auto partial = recheck::recheck(descriptor, storage, 0, &selected);
+  REQUIRE(partial.bytes_read == 8);
+  REQUIRE(partial.valid_pieces.count() == 1);
+  REQUIRE(partial.valid_pieces.get(3));
+
+  // Concurrent rechecks share the read buffers and all of them complete
+  std::vector<int64_t> counts(16, 0);
+  mt::parallel_for(
+      static_cast<int64_t>(counts.size()),
+      [&](int64_t i) {
+        counts[i] = recheck::recheck(descriptor, storage, 1 + i % 3)
+                        .valid_pieces.count();
+      },
+      static_cast<int64_t>(counts.size()));
+  REQUIRE(std::all_of(counts.begin(), counts.end(),
+                      [](int64_t count) { return count == 3; }));
+
+  std::filesystem::remove_all(folder);
+}
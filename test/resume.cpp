@@ -0,0 +1,167 @@
+#include "resume.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "helpers.hpp"
+#include "platform/io.hpp"
+#include "storage/file.hpp"
+
+using namespace fur;
+using namespace fur::resume;
+
+/// Creates a torrent made of two files of 10 and 6 bytes with pieces of 4
+/// bytes, all files are created inside a fresh temporary folder
+static TorrentFile make_torrent(const std::string& name) {
+  const std::string folder = make_temp_folder(name);
+  std::filesystem::create_directories(folder + "/sub");
+
+  TorrentFile descriptor = make_two_files_torrent(folder, 6);
+  descriptor.info_hash = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10,
+                          11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+
+  for (const auto& file : descriptor.files) {
+    platform::io::touch(descriptor.folder_name + '/' + file.filename(),
+                        file.length);
+  }
+  return descriptor;
+}
+
+TEST_CASE("[Resume] Encode and decode") {
+  ResumeData data;
+  data.info_hash = {20, 19, 18, 17, 16, 15, 14, 13, 12, 11,
+                    10, 9,  8,  7,  6,  5,  4,  3,  2,  1};
+  data.folder_name = "some/folder";
+  data.pieces_count = 10;
+  data.completed = {0b10100000, 0b01000000};
+  data.files = {{100, 12345}, {200, 67890}};
+
+  auto bytes = encode(data);
+  auto decoded = decode(bytes);
+  REQUIRE(decoded.valid());
+  REQUIRE(decoded->info_hash == data.info_hash);
+  REQUIRE(decoded->folder_name == data.folder_name);
+  REQUIRE(decoded->pieces_count == data.pieces_count);
+  REQUIRE(decoded->completed == data.completed);
+  REQUIRE(decoded->files.size() == 2);
+  REQUIRE(decoded->files[1].size == 200);
+  REQUIRE(decoded->files[1].mtime == 67890);
+
+  // Truncated content must be rejected
+  bytes.pop_back();
+  auto truncated = decode(bytes);
+  REQUIRE(!truncated.valid());
+  REQUIRE(truncated.error() == ResumeError::Malformed);
+}
+
+TEST_CASE("[Resume] Completed pieces are persisted") {
+  auto descriptor = make_torrent("resume_persist");
+  const std::string filepath = descriptor.folder_name + "/torrent.resume";
+
+  ResumeFile resume(filepath, descriptor, Bitfield(descriptor.pieces_count));
+  REQUIRE(resume.save());
+  REQUIRE(resume.mark_completed(0));
+  REQUIRE(resume.mark_completed(3));
+
+  auto data = load(filepath);
+  REQUIRE(data.valid());
+  REQUIRE(data->folder_name == descriptor.folder_name);
+
+  auto validation = validate(*data, descriptor);
+  REQUIRE(validation.has_value());
+  REQUIRE(validation->trusted.get(0));
+  REQUIRE(!validation->trusted.get(1));
+  REQUIRE(!validation->trusted.get(2));
+  REQUIRE(validation->trusted.get(3));
+  REQUIRE(validation->suspect.count() == 0);
+
+  std::filesystem::remove_all(descriptor.folder_name);
+}
+
+TEST_CASE("[Resume] Completed pieces are written in batches") {
+  auto descriptor = make_torrent("resume_batch");
+  const std::string filepath = descriptor.folder_name + "/torrent.resume";
+
+  {
+    ResumeFile resume(filepath, descriptor, Bitfield(descriptor.pieces_count),
+                      2, std::chrono::hours(1));
+    REQUIRE(resume.save());
+    REQUIRE(resume.mark_completed(0));
+    REQUIRE(!load(filepath)->completed[0]);
+
+    REQUIRE(resume.mark_completed(1));
+    REQUIRE(validate(*load(filepath), descriptor)->trusted.count() == 2);
+
+    // The rest of the batch is written when the file goes away
+    REQUIRE(resume.mark_completed(3));
+    REQUIRE(validate(*load(filepath), descriptor)->trusted.count() == 2);
+  }
+  REQUIRE(validate(*load(filepath), descriptor)->trusted.get(3));
+
+  std::filesystem::remove_all(descriptor.folder_name);
+}
+
+TEST_CASE("[Resume] Modified files are not trusted") {
+  auto descriptor = make_torrent("resume_modified");
+  const std::string filepath = descriptor.folder_name + "/torrent.resume";
+
+  ResumeFile resume(filepath, descriptor, Bitfield(descriptor.pieces_count));
+  for (int64_t i = 0; i < descriptor.pieces_count; i++)
+    REQUIRE(resume.mark_completed(i));
+
+  // Pieces 2 and 3 overlap the second file
+  std::filesystem::resize_file(descriptor.folder_name + "/sub/b", 7);
+
+  auto data = load(filepath);
+  REQUIRE(data.valid());
+  auto validation = validate(*data, descriptor);
+  REQUIRE(validation.has_value());
+  REQUIRE(validation->trusted.get(0));
+  REQUIRE(validation->trusted.get(1));
+  REQUIRE(!validation->trusted.get(2));
+  REQUIRE(!validation->trusted.get(3));
+
+  // They must be verified before they are trusted again
+  REQUIRE(validation->suspect.count() == 2);
+  REQUIRE(validation->suspect.get(2));
+  REQUIRE(validation->suspect.get(3));
+
+  // Resume data of another torrent is rejected entirely
+  descriptor.info_hash[0] = 0;
+  REQUIRE(!validate(*data, descriptor).has_value());
+
+  std::filesystem::remove_all(descriptor.folder_name);
+}
+
+TEST_CASE("[Resume] Deleted files are created again") {
+  auto descriptor = make_torrent("resume_deleted");
+  const std::string filepath = descriptor.folder_name + "/torrent.resume";
+  {
+    ResumeFile resume(filepath, descriptor, Bitfield(descriptor.pieces_count));
+    for (int64_t i = 0; i < descriptor.pieces_count; i++)
+      REQUIRE(resume.mark_completed(i));
+  }
+
+  // The second file goes away between two runs, its pieces are suspect
+  std::filesystem::remove(descriptor.folder_name + "/sub/b");
+  auto validation = validate(*load(filepath), descriptor);
+  REQUIRE(validation.has_value());
+  REQUIRE(validation->trusted.count() == 2);
+  REQUIRE(validation->suspect.count() == 2);
+
+  // Preparing the same folder again creates it, so the pieces can be stored
+  const std::string folder = descriptor.folder_name;
+  storage::FileBackend storage;
+  REQUIRE(storage.prepare(descriptor, true).valid());
+  REQUIRE(descriptor.folder_name == folder);
+  REQUIRE(std::filesystem::file_size(folder + "/sub/b") == 6);
+
+  const FileLayout layout(descriptor);
+  const uint8_t content[4] = {12, 13, 14, 15};
+  REQUIRE(storage.write_piece(descriptor, layout.piece(3), content, 4).valid());
+
+  std::filesystem::remove_all(folder);
+}
@@ -0,0 +1,62 @@
+#include "download/retry.hpp"
+
+#include <chrono>
+
+#include "catch2/catch.hpp"
+
+using namespace fur;
+using namespace fur::download::retry;
+using fur::download::downloader::DownloaderError;
+
+TEST_CASE("[Retry] Errors are classified") {
+  REQUIRE(classify(DownloaderError::MissingPiece) == Failure::Missing);
+  REQUIRE(classify(DownloaderError::SocketTimeout) == Failure::Timeout);
+  REQUIRE(classify(DownloaderError::CorruptPiece) == Failure::Corrupt);
+  REQUIRE(classify(DownloaderError::SocketOther) == Failure::Protocol);
+  REQUIRE(classify(DownloaderError::InvalidMessage) == Failure::Protocol);
+  REQUIRE(classify(DownloaderError::NoBitfield) == Failure::Protocol);
+  REQUIRE(classify(DownloaderError::DifferentInfoHash) == Failure::Protocol);
+  REQUIRE(classify(DownloaderError::CannotStore) == Failure::Storage);
+}
+
+TEST_CASE("[Retry] Backoff doubles up to a limit") {
+  using std::chrono::milliseconds;
+  REQUIRE(backoff(1) == milliseconds(BACKOFF_MS));
+  REQUIRE(backoff(2) == milliseconds(BACKOFF_MS * 2));
+  REQUIRE(backoff(3) == milliseconds(BACKOFF_MS * 4));
+  REQUIRE(backoff(1000) == milliseconds(BACKOFF_MAX_MS));
+}
+
+TEST_CASE("[Retry] Every class has its own budget") {
+  Retries retries;
+
+  // Failures of the other classes make the wait longer but don't spend the
+  // budget of a class
+  for (int64_t i = 1; i < budget(Failure::Corrupt); i++) {
+    auto wait = retries.fail(Failure::Corrupt);
+    REQUIRE(wait.has_value());
+    REQUIRE(*wait == backoff(i));
+  }
+  auto wait = retries.fail(Failure::Timeout);
+  REQUIRE(wait.has_value());
+  REQUIRE(*wait == backoff(budget(Failure::Corrupt)));
+
+  REQUIRE_FALSE(retries.fail(Failure::Corrupt).has_value());
+  REQUIRE(retries.failures(Failure::Corrupt) == budget(Failure::Corrupt));
+  REQUIRE(retries.failures(Failure::Timeout) == 1);
+  REQUIRE(retries.failures(Failure::Missing) == 0);
+  REQUIRE(retries.total() == budget(Failure::Corrupt) + 1);
+}
+
+TEST_CASE("[Retry] Failures are counted by class") {
+  FailureCounters counters;
+  counters.add(Failure::Missing);
+  counters.add(Failure::Missing);
+  counters.add(Failure::Protocol);
+
+  REQUIRE(counters.get(Failure::Missing) == 2);
+  REQUIRE(counters.get(Failure::Timeout) == 0);
+  REQUIRE(counters.get(Failure::Corrupt) == 0);
+  REQUIRE(counters.get(Failure::Protocol) == 1);
+  REQUIRE(counters.get(Failure::Storage) == 0);
+}
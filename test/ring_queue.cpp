@@ -0,0 +1,73 @@
+#include <atomic>
+#include <memory>
+#include <mt/ring_queue.hpp>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+using namespace fur::mt;
+
+TEST_CASE("[Ring queue] Items come out in order") {
+  RingQueue<std::unique_ptr<int64_t>> queue(5);
+  REQUIRE(queue.capacity() == 8);
+  REQUIRE(!queue.try_pop().has_value());
+
+  for (int64_t i = 0; i < 8; i++)
+    REQUIRE(queue.try_push(std::make_unique<int64_t>(i)));
+  REQUIRE(queue.size() == 8);
+
+  // A rejected item is left untouched
+  auto rejected = std::make_unique<int64_t>(8);
+  REQUIRE(!queue.try_push(std::move(rejected)));
+  REQUIRE(rejected != nullptr);
+
+  // Items keep their order while the positions wrap around the ring
+  for (int64_t lap = 0; lap < 3; lap++) {
+    for (int64_t i = 0; i < 8; i++) {
+      auto item = queue.try_pop();
+      REQUIRE(item.has_value());
+      REQUIRE(**item == lap * 8 + i);
+      REQUIRE(queue.try_push(std::make_unique<int64_t>((lap + 1) * 8 + i)));
+    }
+  }
+  REQUIRE(queue.size() == 8);
+}
+
+TEST_CASE("[Ring queue] Every item is popped once under contention") {
+  const int64_t PRODUCERS = 4;
+  const int64_t CONSUMERS = 4;
+  const int64_t ITEMS = 50000;
+  RingQueue<int64_t> queue(64);
+
+  std::vector<std::atomic_int64_t> popped(PRODUCERS * ITEMS);
+  std::atomic_int64_t remaining{PRODUCERS * ITEMS};
+
+  std::vector<std::thread> threads;
+  for (int64_t p = 0; p < PRODUCERS; p++) {
+    threads.emplace_back([&, p] {
+      for (int64_t i = 0; i < ITEMS; i++) {
+        while (!queue.try_push(p * ITEMS + i)) std::this_thread::yield();
+      }
+    });
+  }
+  for (int64_t c = 0; c < CONSUMERS; c++) {
+    threads.emplace_back([&] {
+      while (remaining.load() > 0) {
+        auto item = queue.try_pop();
+        if (!item.has_value()) {
+          std::this_thread::yield();
+          continue;
+        }
+        popped[*item] += 1;
+        remaining -= 1;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  bool once = true;
+  for (const auto& count : popped) once &= count == 1;
+  REQUIRE(once);
+  REQUIRE(queue.size() == 0);
+}
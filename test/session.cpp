@@ -0,0 +1,132 @@
+#include "session.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "helpers.hpp"
+
+using namespace fur;
+using namespace fur::session;
+
+/// A session with a single torrent made of two files
+static SessionData make_session() {
+  SessionTorrent torrent;
+  torrent.descriptor = make_two_files_torrent("downloads/content", 6);
+  TorrentFile& descriptor = torrent.descriptor;
+  descriptor.announce_url = "http://tracker/announce";
+  descriptor.info_hash = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10,
+                          11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+  descriptor.name = "content";
+
+  torrent.file_priorities = {FilePriority::High, FilePriority::Skip};
+  torrent.sequential = true;
+  torrent.weight = 3;
+  torrent.priority = TorrentPriority::High;
+  torrent.update_interval = 1800;
+  torrent.peers = {peer::Peer(0x7f000001, 6881), peer::Peer(0x0a000002, 80)};
+
+  torrent.resume.info_hash = descriptor.info_hash;
+  torrent.resume.folder_name = descriptor.folder_name;
+  torrent.resume.pieces_count = descriptor.pieces_count;
+  torrent.resume.completed = {0b10100000};
+  torrent.resume.files = {{10, 111}, {6, 222}};
+
+  SessionData data;
+  data.torrents.push_back(std::move(torrent));
+  return data;
+}
+
+TEST_CASE("[Session] Encode and decode") {
+  const SessionData data = make_session();
+  const SessionTorrent& original = data.torrents[0];
+
+  auto bytes = encode(data);
+  auto decoded =
+      decode(std::string_view(reinterpret_cast<const char*>(bytes.data()),
+                              bytes.size()));
+  REQUIRE(decoded.valid());
+  REQUIRE(decoded->torrents.size() == 1);
+
+  const SessionTorrent& torrent = decoded->torrents[0];
+  REQUIRE(torrent.descriptor.announce_url == original.descriptor.announce_url);
+  REQUIRE(torrent.descriptor.info_hash == original.descriptor.info_hash);
+  REQUIRE(torrent.descriptor.folder_name == original.descriptor.folder_name);
+  REQUIRE(torrent.descriptor.pieces_count == 4);
+  REQUIRE(torrent.descriptor.piece_hashes == original.descriptor.piece_hashes);
+  REQUIRE(torrent.descriptor.files.size() == 2);
+  REQUIRE(torrent.descriptor.files[1].filename() == "sub/b");
+  REQUIRE(torrent.descriptor.files[1].length == 6);
+  REQUIRE(torrent.file_priorities == original.file_priorities);
+  REQUIRE(torrent.sequential);
+  REQUIRE(!torrent.streaming);
+  REQUIRE(torrent.weight == 3);
+  REQUIRE(torrent.priority == TorrentPriority::High);
+  REQUIRE(torrent.update_interval == 1800);
+  REQUIRE(torrent.peers.size() == 2);
+  REQUIRE(torrent.peers[0].ip == 0x7f000001);
+  REQUIRE(torrent.peers[1].port == 80);
+  REQUIRE(torrent.resume.completed == original.resume.completed);
+  REQUIRE(torrent.resume.files[1].mtime == 222);
+}
+
+TEST_CASE("[Session] Malformed snapshots are rejected") {
+  auto bytes = encode(make_session());
+  auto view = [](const std::vector<uint8_t>& content) {
+    return std::string_view(reinterpret_cast<const char*>(content.data()),
+                            content.size());
+  };
+
+  // Every truncation must be rejected
+  for (size_t len = 0; len < bytes.size(); len++) {
+    auto truncated = decode(view(bytes).substr(0, len));
+    REQUIRE(!truncated.valid());
+  }
+
+  // Descriptors that don't hold together, the files would be laid out with
+  // them and their pieces divided by their length
+  auto inconsistent = [&](auto change) {
+    SessionData data = make_session();
+    change(data.torrents[0]);
+    auto encoded = encode(data);
+    auto decoded = decode(view(encoded));
+    return !decoded.valid() && decoded.error() == SessionError::Malformed;
+  };
+  REQUIRE(inconsistent(
+      [](SessionTorrent& torrent) { torrent.descriptor.piece_length = 0; }));
+  REQUIRE(inconsistent(
+      [](SessionTorrent& torrent) { torrent.descriptor.length = 17; }));
+  REQUIRE(inconsistent([](SessionTorrent& torrent) {
+    torrent.descriptor.files[1].length = -6;
+  }));
+  REQUIRE(inconsistent([](SessionTorrent& torrent) {
+    torrent.descriptor.piece_length = 8;
+  }));
+  REQUIRE(inconsistent([](SessionTorrent& torrent) {
+    torrent.file_priorities.push_back(FilePriority::Normal);
+  }));
+
+  // The version follows the magic number
+  bytes[4] += 1;
+  auto newer = decode(view(bytes));
+  REQUIRE(!newer.valid());
+  REQUIRE(newer.error() == SessionError::UnsupportedVersion);
+}
+
+TEST_CASE("[Session] Save and load") {
+  const std::string folder = make_temp_folder("session");
+  const std::string filepath = folder + "/session";
+
+  auto missing = load(filepath);
+  REQUIRE(!missing.valid());
+  REQUIRE(missing.error() == SessionError::CannotOpenFile);
+
+  REQUIRE(save(filepath, make_session()));
+  auto loaded = load(filepath);
+  REQUIRE(loaded.valid());
+  REQUIRE(loaded->torrents.size() == 1);
+  REQUIRE(loaded->torrents[0].descriptor.name == "content");
+
+  std::filesystem::remove_all(folder);
+}
@@ -0,0 +1,154 @@
+#include "sha1.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "smallsha1/sha1.hpp"
+
+using namespace fur::hash;
+
+static hash_t digest(const std::string& message) {
+  return Sha1::digest(reinterpret_cast<const uint8_t*>(message.data()),
+                      static_cast<int64_t>(message.size()));
+}
+
+TEST_CASE("[Sha1] Known vectors") {
+  REQUIRE(hash_to_hex(digest("")) ==
+          "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+  REQUIRE(hash_to_hex(digest("abc")) ==
+          "a9993e364706816aba3e25717850c26c9cd0d89d");
+  REQUIRE(hash_to_hex(digest(
+              "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")) ==
+          "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+}
+
+TEST_CASE("[Sha1] Incremental matches one-shot") {
+  std::mt19937 gen(42);
+  std::vector<uint8_t> bytes(10000);
+  for (auto& byte : bytes) byte = gen();
+
+  // Every length around the padding boundaries, fed in uneven chunks
+  for (int64_t len : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 10000}) {
+    hash_t expected;
+    sha1::calc(bytes.data(), static_cast<int>(len), expected.data());
+
+    Sha1 sha1;
+    int64_t fed = 0;
+    while (fed < len) {
+      int64_t chunk = std::min<int64_t>(gen() % 100, len - fed);
+      sha1.update(bytes.data() + fed, chunk);
+      fed += chunk;
+    }
+    REQUIRE(sha1.finish() == expected);
+    REQUIRE(Sha1::digest(bytes.data(), len) == expected);
+  }
+}
+
+TEST_CASE("[Sha1] Streaming hasher with out of order blocks") {
+  const int64_t BLOCK = 100;
+  std::vector<uint8_t> piece(1050);
+  for (int64_t i = 0; i < 1050; i++) piece[i] = i * 7;
+  const hash_t expected = Sha1::digest(piece.data(), 1050);
+
+  // Blocks 0..10, the last one is shorter
+  std::vector<int64_t> order{3, 0, 1, 10, 2, 5, 4, 9, 8, 6, 7};
+  StreamingHasher hasher(piece.data(), 1050);
+  for (int64_t block : order) {
+    REQUIRE(!hasher.complete());
+    hasher.received(block * BLOCK,
+                    std::min<int64_t>(BLOCK, 1050 - block * BLOCK));
+  }
+  REQUIRE(hasher.complete());
+  REQUIRE(hasher.finish() == expected);
+
+  // Duplicated blocks are hashed once
+  StreamingHasher duplicated(piece.data(), 1050);
+  duplicated.received(500, 550);
+  duplicated.received(500, 100);
+  duplicated.received(0, 600);
+  duplicated.received(0, 100);
+  REQUIRE(duplicated.complete());
+  REQUIRE(duplicated.finish() == expected);
+}
+
+TEST_CASE("[Sha1] Block hasher only keeps blocks after a gap") {
+  const int64_t BLOCK = 100;
+  std::vector<uint8_t> piece(1050);
+  for (int64_t i = 0; i < 1050; i++) piece[i] = i * 11;
+  const hash_t expected = Sha1::digest(piece.data(), 1050);
+
+  std::vector<int64_t> order{1, 2, 0, 3, 4, 6, 5, 10, 7, 8, 9};
+  BlockHasher hasher(1050);
+  for (int64_t block : order) {
+    REQUIRE(!hasher.complete());
+    // Every block is gone from the caller's memory right after the call
+    std::vector<uint8_t> copy(
+        piece.begin() + block * BLOCK,
+        piece.begin() + std::min<int64_t>(1050, (block + 1) * BLOCK));
+    hasher.received(block * BLOCK, copy.data(),
+                    static_cast<int64_t>(copy.size()));
+    std::fill(copy.begin(), copy.end(), 0);
+
+    if (block == 2) REQUIRE(hasher.buffered() == 2 * BLOCK);
+    if (block == 0) REQUIRE(hasher.buffered() == 0);
+  }
+  REQUIRE(hasher.complete());
+  REQUIRE(hasher.buffered() == 0);
+  REQUIRE(hasher.finish() == expected);
+
+  // Overlapping blocks are hashed once
+  BlockHasher overlapping(1050);
+  overlapping.received(500, piece.data() + 500, 550);
+  overlapping.received(0, piece.data(), 600);
+  overlapping.received(0, piece.data(), 100);
+  REQUIRE(overlapping.complete());
+  REQUIRE(overlapping.finish() == expected);
+}
+
+TEST_CASE("[Sha1] Every supported kernel matches smallsha1") {
+  std::mt19937 gen(7);
+  std::vector<uint8_t> bytes(20000);
+  for (auto& byte : bytes) byte = gen();
+
+  for (auto kernel : supported_kernels()) {
+    INFO("kernel " << kernel_name(kernel));
+    for (int64_t len : {0, 3, 55, 64, 100, 128, 1000, 4096, 19999, 20000}) {
+      hash_t expected;
+      sha1::calc(bytes.data(), static_cast<int>(len), expected.data());
+      REQUIRE(Sha1::digest(bytes.data(), len, kernel) == expected);
+    }
+  }
+  REQUIRE(best_kernel() == supported_kernels().back());
+}
+
+TEST_CASE("[Sha1] Every supported batch kernel matches smallsha1") {
+  std::mt19937 gen(11);
+  std::vector<uint8_t> bytes(40000);
+  for (auto& byte : bytes) byte = gen();
+
+  // More messages than the widest kernel has lanes, with lengths that leave
+  // some lanes without a message in the last group
+  std::vector<Message> messages;
+  for (int64_t i = 0; i < 37; i++) {
+    const int64_t len = (i % 5 == 0) ? (i * 131) % 3000 : 1024 + i % 3;
+    messages.push_back({bytes.data() + i * 1000, len});
+  }
+
+  std::vector<hash_t> expected(messages.size());
+  for (size_t i = 0; i < messages.size(); i++) {
+    sha1::calc(messages[i].bytes, static_cast<int>(messages[i].len),
+               expected[i].data());
+  }
+
+  for (auto kernel : supported_batch_kernels()) {
+    INFO("kernel " << batch_kernel_name(kernel));
+    for (int64_t count : {0, 1, 3, 37}) {
+      std::vector<hash_t> hashes(count);
+      digest_batch(messages.data(), count, hashes.data(), kernel);
+      for (int64_t i = 0; i < count; i++) REQUIRE(hashes[i] == expected[i]);
+    }
+  }
+}
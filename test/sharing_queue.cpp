@@ -1,4 +1,5 @@
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mt/sharing_queue.hpp>
 #include <policy/policy.hpp>
@@ -77,4 +78,42 @@ TEST_CASE("[Sharing queue][policy] Mutation") {
   }
 
   REQUIRE(count == TOTAL_COUNT / 2);
-}
\ No newline at end of file
+}
+
+TEST_CASE("[Sharing queue][policy] Waiting with a deadline") {
+  fur::mt::SharedQueue<Item> items;
+
+  // Nothing arrives, the wait ends at the deadline
+  const auto begin = std::chrono::steady_clock::now();
+  items.wait_work_until(begin + std::chrono::milliseconds(20));
+  REQUIRE(std::chrono::steady_clock::now() - begin >=
+          std::chrono::milliseconds(20));
+
+  // An item arrives long before the deadline
+  std::thread writer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    items.insert({1});
+  });
+  items.wait_work_until(std::chrono::steady_clock::now() +
+                        std::chrono::seconds(60));
+  writer.join();
+
+  fur::policy::FIFOPolicy<Item> policy;
+  auto result = items.try_extract(policy);
+  REQUIRE(result.valid());
+  REQUIRE(result->value == 1);
+}
+
+TEST_CASE("[Sharing queue][policy] Waking up without work") {
+  fur::mt::SharedQueue<Item> items;
+
+  // Nobody is waiting yet, the next wait returns right away
+  items.wake_one();
+  items.wait_work();
+
+  // A waiting thread is woken up
+  std::thread waiter([&] { items.wait_work(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  items.wake_one();
+  waiter.join();
+}
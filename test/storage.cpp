@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "helpers.hpp"
+#include "mt/parallel.hpp"
+#include "recheck.hpp"
+#include "storage/file.hpp"
+#include "storage/memory.hpp"
+
+using namespace fur;
+using namespace fur::storage;
+
+/// Writes every piece of the torrent made by `make_two_files_torrent`
+static void write_all_pieces(StorageBackend& storage,
+                             const TorrentFile& descriptor) {
+  for (const auto& piece : descriptor.pieces()) {
+    std::vector<uint8_t> content;
+    for (const auto& subpiece : piece.subpieces) {
+      const int64_t begin = piece.index * 4 + static_cast<int64_t>(content.size());
+      for (int64_t i = 0; i < subpiece.len; i++) content.push_back(begin + i);
+    }
+    REQUIRE(storage
+                .write_piece(descriptor, piece, content.data(),
+                             static_cast<int64_t>(content.size()))
+                .valid());
+  }
+}
+
+TEST_CASE("[Storage] File backend splits pieces across files") {
+  const std::filesystem::path folder = temp_path("storage");
+
+  FileBackend storage;
+  auto descriptor = make_two_files_torrent(folder.string());
+  REQUIRE(storage.prepare(descriptor, false).valid());
+  REQUIRE(descriptor.folder_name == folder.string());
+  REQUIRE(std::filesystem::file_size(folder / "sub" / "b") == 7);
+
+  write_all_pieces(storage, descriptor);
+  REQUIRE(storage.flush(descriptor).valid());
+
+  // The third piece crosses the boundary between the files
+  std::vector<uint8_t> bytes(4);
+  auto read = storage.read_block(descriptor.folder_name + "/a", bytes.data(),
+                                 4, 8);
+  REQUIRE(read.valid());
+  REQUIRE(*read == 2);
+  REQUIRE(bytes[0] == 8);
+  REQUIRE(bytes[1] == 9);
+
+  read = storage.read_block(descriptor.folder_name + "/sub/b", bytes.data(), 4,
+                            0);
+  REQUIRE(read.valid());
+  REQUIRE(*read == 4);
+  REQUIRE(bytes == std::vector<uint8_t>{10, 11, 12, 13});
+
+  // An existing folder is never overwritten
+  auto copy = make_two_files_torrent(folder.string());
+  REQUIRE(storage.prepare(copy, false).valid());
+  REQUIRE(copy.folder_name == folder.string() + " COPY");
+
+  std::filesystem::remove_all(folder);
+  std::filesystem::remove_all(copy.folder_name);
+}
+
+TEST_CASE("[Storage] File backend keeps files open until released") {
+  const std::filesystem::path folder = temp_path("open_files");
+
+  FileBackend storage;
+  auto descriptor = make_two_files_torrent(folder.string());
+  REQUIRE(storage.prepare(descriptor, false).valid());
+  const auto pieces = descriptor.pieces();
+  const uint8_t bytes[4] = {1, 2, 3, 4};
+  REQUIRE(storage.write_block(descriptor, pieces[0], 0, bytes, 4).valid());
+
+  // The open file is still written once its path is gone
+  std::filesystem::remove(folder / "a");
+  REQUIRE(storage.write_block(descriptor, pieces[1], 0, bytes, 4).valid());
+
+  // Released files are opened again by path
+  storage.release(descriptor);
+  REQUIRE(!storage.write_block(descriptor, pieces[1], 0, bytes, 4).valid());
+  REQUIRE(storage.write_block(descriptor, pieces[3], 0, bytes, 4).valid());
+
+  std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("[Storage] Torrents with the same name get their own folder") {
+  const std::filesystem::path folder = temp_path("same_name");
+  const int64_t TORRENTS = 8;
+  auto folder_name = [&](int64_t copies) {
+    std::string name = folder.string();
+    for (int64_t i = 0; i < copies; i++) name += " COPY";
+    return name;
+  };
+  for (int64_t i = 0; i < TORRENTS; i++)
+    std::filesystem::remove_all(folder_name(i));
+
+  FileBackend storage;
+  std::vector<TorrentFile> descriptors(TORRENTS,
+                                       make_two_files_torrent(folder.string()));
+  std::vector<int> prepared(TORRENTS, 0);
+  mt::parallel_for(TORRENTS, [&](int64_t index) {
+    prepared[index] = storage.prepare(descriptors[index], false).valid();
+  });
+
+  std::vector<std::string> folders;
+  for (int64_t i = 0; i < TORRENTS; i++) {
+    REQUIRE(prepared[i]);
+    REQUIRE(std::filesystem::file_size(descriptors[i].folder_name + "/a") ==
+            10);
+    folders.push_back(descriptors[i].folder_name);
+  }
+  std::sort(folders.begin(), folders.end());
+  REQUIRE(std::unique(folders.begin(), folders.end()) == folders.end());
+
+  for (int64_t i = 0; i < TORRENTS; i++)
+    std::filesystem::remove_all(folder_name(i));
+}
+
+TEST_CASE("[Storage] File backend creates only needed files") {
+  const std::filesystem::path folder = temp_path("skipped");
+
+  FileBackend storage;
+  auto descriptor = make_two_files_torrent(folder.string());
+  REQUIRE(storage
+              .prepare(descriptor, false,
+                       {FilePriority::Skip, FilePriority::Skip})
+              .valid());
+  REQUIRE(!std::filesystem::exists(folder / "a"));
+  REQUIRE(!std::filesystem::exists(folder / "sub" / "b"));
+  REQUIRE(storage.flush(descriptor).valid());
+
+  // The second file shares a piece with the first one
+  std::filesystem::remove_all(folder);
+  descriptor = make_two_files_torrent(folder.string());
+  REQUIRE(storage
+              .prepare(descriptor, false,
+                       {FilePriority::Normal, FilePriority::Skip})
+              .valid());
+  REQUIRE(std::filesystem::file_size(folder / "a") == 10);
+  REQUIRE(std::filesystem::exists(folder / "sub" / "b"));
+
+  std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("[Storage] Memory backend keeps the whole content") {
+  MemoryBackend storage;
+  auto descriptor = make_two_files_torrent("memory");
+  REQUIRE(storage.prepare(descriptor, false).valid());
+
+  auto empty = recheck::recheck(descriptor, storage);
+  REQUIRE(empty.valid_pieces.count() == 0);
+
+  write_all_pieces(storage, descriptor);
+  auto full = recheck::recheck(descriptor, storage);
+  REQUIRE(full.valid_pieces.count() == 5);
+  REQUIRE(full.bytes_read == 17);
+
+  // Reusing the folder keeps the content
+  auto again = make_two_files_torrent("memory");
+  REQUIRE(storage.prepare(again, true).valid());
+  REQUIRE(again.folder_name == "memory");
+  REQUIRE(recheck::recheck(again, storage).valid_pieces.count() == 5);
+
+  std::vector<uint8_t> bytes(4);
+  REQUIRE(!storage.read_block("missing", bytes.data(), 4, 0).valid());
+}
+
+TEST_CASE("[Storage] Blocks are split across files") {
+  MemoryBackend storage;
+  auto descriptor = make_two_files_torrent("blocks");
+  REQUIRE(storage.prepare(descriptor, false).valid());
+
+  // The third piece holds bytes 8..11, the first two belong to the first file
+  const Piece piece = descriptor.pieces()[2];
+  const std::vector<uint8_t> content{8, 9, 10, 11};
+  REQUIRE(storage.write_block(descriptor, piece, 1, content.data() + 1, 3)
+              .valid());
+  REQUIRE(storage.write_block(descriptor, piece, 0, content.data(), 1)
+              .valid());
+  REQUIRE(!storage.write_block(descriptor, piece, 2, content.data(), 3)
+               .valid());
+
+  auto report = recheck::recheck(descriptor, storage);
+  REQUIRE(report.valid_pieces.count() == 1);
+  REQUIRE(report.valid_pieces.get(2));
+
+  auto slices = split_block(piece, 1, 3);
+  REQUIRE(slices.has_value());
+  REQUIRE(slices->size() == 2);
+  REQUIRE(*(*slices)[0].filepath == "a");
+  REQUIRE((*slices)[0].file_offset == 9);
+  REQUIRE((*slices)[1].block_offset == 1);
+  REQUIRE((*slices)[1].file_offset == 0);
+  REQUIRE((*slices)[1].len == 2);
+}
+
+TEST_CASE("[Storage] Discard backend counts bytes") {
+  DiscardBackend storage;
+  auto descriptor = make_two_files_torrent("discard");
+  REQUIRE(storage.prepare(descriptor, false).valid());
+
+  write_all_pieces(storage, descriptor);
+  REQUIRE(storage.bytes_written() == 17);
+  REQUIRE(!storage.persistent());
+
+  std::vector<uint8_t> bytes(4);
+  auto read = storage.read_block("discard/a", bytes.data(), 4, 0);
+  REQUIRE(read.valid());
+  REQUIRE(*read == 0);
+}
@@ -2,11 +2,16 @@
 
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
+#include "bencode/bencode_cursor.hpp"
+#include "bencode/bencode_parser.hpp"
 #include "bencode/bencode_value.hpp"
 #include "catch2/catch.hpp"
 #include "hash.hpp"
+#include "platform/io.hpp"
 
 using namespace fur;
 using namespace fur::hash;
@@ -39,6 +44,115 @@ TEST_CASE("[Torrent] Parse .torrent") {
           "cc5bf72c0db84e2de95f967954441c017c5a3631");
 }
 
+TEST_CASE("[Torrent] Parse in place the same as the tree") {
+  auto mapped = fur::platform::io::MappedFile::open(
+      "../extra/multi-file-1.torrent");
+  REQUIRE(mapped.valid());
+
+  BencodeParser parser;
+  auto tree = parser.decode(mapped->view());
+  REQUIRE(tree.valid());
+  TorrentFile from_tree{*(*tree)};
+  TorrentFile in_place{BencodeCursor(mapped->view())};
+
+  REQUIRE(in_place.info_hash == from_tree.info_hash);
+  REQUIRE(in_place.name == from_tree.name);
+  REQUIRE(in_place.length == from_tree.length);
+  REQUIRE(in_place.piece_hashes == from_tree.piece_hashes);
+  REQUIRE(in_place.files.size() == from_tree.files.size());
+  REQUIRE(in_place.files.size() > 1);
+  REQUIRE(in_place.files.back().filename() ==
+          from_tree.files.back().filename());
+
+  REQUIRE_THROWS_AS(TorrentFile{BencodeCursor("d8:announce3:urle")},
+                    std::invalid_argument);
+}
+
+TEST_CASE("[Torrent] Piece priorities follow their files") {
+  // Three files of 10, 7 and 8 bytes with pieces of 4 bytes, the third and
+  // the fifth pieces cross the boundaries between the files
+  TorrentFile descriptor;
+  descriptor.piece_length = 4;
+  descriptor.length = 25;
+  descriptor.pieces_count = 7;
+  descriptor.files = {File{{"a"}, 10}, File{{"b"}, 7}, File{{"c"}, 8}};
+
+  auto all = piece_priorities(descriptor, {});
+  REQUIRE(all == std::vector<FilePriority>(7, FilePriority::Normal));
+  REQUIRE(needed_files(descriptor, {}) == std::vector<bool>{true, true, true});
+
+  // Shared pieces take the highest priority
+  const std::vector<FilePriority> mixed = {
+      FilePriority::High, FilePriority::Skip, FilePriority::Low};
+  REQUIRE(piece_priorities(descriptor, mixed) ==
+          std::vector<FilePriority>{FilePriority::High, FilePriority::High,
+                                    FilePriority::High, FilePriority::Skip,
+                                    FilePriority::Low, FilePriority::Low,
+                                    FilePriority::Low});
+  REQUIRE(needed_files(descriptor, mixed) ==
+          std::vector<bool>{true, true, true});
+
+  // The last file doesn't share any wanted piece
+  const std::vector<FilePriority> first = {
+      FilePriority::Normal, FilePriority::Skip, FilePriority::Skip};
+  REQUIRE(piece_priorities(descriptor, first)[3] == FilePriority::Skip);
+  REQUIRE(needed_files(descriptor, first) ==
+          std::vector<bool>{true, true, false});
+
+  REQUIRE_THROWS_AS(piece_priorities(descriptor, {FilePriority::Normal}),
+                    std::invalid_argument);
+}
+
+TEST_CASE("[Torrent] Pieces are found in the file layout") {
+  // Files of 10, 0, 7 and 8 bytes with pieces of 4 bytes, the empty file
+  // never appears in a piece
+  TorrentFile descriptor;
+  descriptor.piece_length = 4;
+  descriptor.length = 25;
+  descriptor.pieces_count = 7;
+  descriptor.files = {File{{"a"}, 10}, File{{"empty"}, 0},
+                      File{{"sub", "b"}, 7}, File{{"c"}, 8}};
+  const FileLayout layout(descriptor);
+
+  REQUIRE(layout.file_at(0) == 0);
+  REQUIRE(layout.file_at(9) == 0);
+  REQUIRE(layout.file_at(10) == 2);
+  REQUIRE(layout.file_at(17) == 3);
+  REQUIRE(layout.file_at(24) == 3);
+  REQUIRE(layout.piece_length(0) == 4);
+  REQUIRE(layout.piece_length(6) == 1);
+
+  // Crosses the boundary between the first file and the third one
+  const Piece crossing = layout.piece(2);
+  REQUIRE(crossing.index == 2);
+  REQUIRE(crossing.subpieces.size() == 2);
+  REQUIRE(crossing.subpieces[0].filepath == "a");
+  REQUIRE(crossing.subpieces[0].file_offset == 8);
+  REQUIRE(crossing.subpieces[0].len == 2);
+  REQUIRE(crossing.subpieces[1].filepath == "sub/b");
+  REQUIRE(crossing.subpieces[1].file_offset == 0);
+  REQUIRE(crossing.subpieces[1].len == 2);
+
+  const Piece last = layout.piece(6);
+  REQUIRE(last.subpieces.size() == 1);
+  REQUIRE(last.subpieces[0].filepath == "c");
+  REQUIRE(last.subpieces[0].file_offset == 7);
+  REQUIRE(last.subpieces[0].len == 1);
+
+  // Every byte of the torrent belongs to exactly one piece
+  int64_t offset = 0;
+  for (const auto& piece : descriptor.pieces()) {
+    for (const auto& subpiece : piece.subpieces) {
+      REQUIRE(subpiece.len > 0);
+      offset += subpiece.len;
+    }
+  }
+  REQUIRE(offset == descriptor.length);
+
+  REQUIRE_THROWS_AS(layout.piece(7), std::out_of_range);
+  REQUIRE_THROWS_AS(layout.piece(-1), std::out_of_range);
+}
+
 std::unique_ptr<BencodeValue> get_debian_tree() {
   std::map<std::string, std::unique_ptr<BencodeValue>> dict;
   dict.emplace("announce", std::make_unique<BencodeString>(